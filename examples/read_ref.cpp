@@ -9,6 +9,16 @@
 #include <locale> // tolower, isspace
 #include <limits>
 #include <fstream>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define HAVE_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 ///////////////////////////////////////////
 // This example is completely standalone
@@ -126,6 +136,134 @@ std::vector<gaussian_shell> reffile_read_basis(std::istream & fs)
 }
 
 
+/* Prints the first and last integrals of a quartet */
+void print_quartet(size_t p, size_t q, size_t r, size_t s,
+                   const std::vector<double> & integrals)
+{
+    const size_t nintegrals = integrals.size();
+
+    std::cout << "\nQuartet " << p << " " << q << " " << r << " " << s << " has " << nintegrals << " integrals\n";
+    std::cout << "    " << integrals[0] << "\n";
+    if(nintegrals > 1)
+    {
+        std::cout << "    ....\n";
+        std::cout << "    " << integrals[nintegrals-1] << "\n";
+    }
+}
+
+
+///////////////////////////////////////////
+// Binary reference files
+//
+// All integers are unsigned little-endian, and
+// all doubles are little-endian IEEE doubles.
+//
+//  Header (128 bytes): magic "MIRPREFB", version (4 bytes),
+//                      number of centers (4 bytes), then (offset, count)
+//                      pairs (8 bytes each) for the comment, shells,
+//                      shell parameters, integrals, quartet index, and
+//                      block index, then the encoding (4 bytes)
+//  Shell (48 bytes):  am, nprim, ngeneral, reserved (4 bytes each),
+//                     xyz (3 doubles), index of first parameter (8 bytes)
+//  Quartet (32 bytes): shell indices (4 bytes each), am (1 byte each),
+//                      number of integrals (4 bytes),
+//                      index of the first integral (8 bytes)
+//
+// With the raw encoding (0), the integrals are stored as consecutive
+// doubles, so the block index is not needed here. Compressed files
+// can be converted with mirp_convert_reference --format binary
+///////////////////////////////////////////
+
+/* Reads an unsigned little-endian integer */
+uint64_t load_le(const unsigned char * p, int nbytes)
+{
+    uint64_t v = 0;
+    for(int i = nbytes-1; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/* Reads a little-endian double */
+double load_double(const unsigned char * p)
+{
+    uint64_t bits = load_le(p, 8);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+
+/* Reads a binary reference file. The file is memory mapped
+ * (where possible), so quartets could also be read in any order */
+int read_binary(const char * filepath)
+{
+    std::vector<unsigned char> contents;
+    const unsigned char * data = nullptr;
+    size_t size = 0;
+
+#ifdef HAVE_MMAP
+    int fd = open(filepath, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0)
+        throw std::runtime_error("Error opening input file");
+
+    size = static_cast<size_t>(st.st_size);
+    void * map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        throw std::runtime_error("Error mapping input file");
+    data = static_cast<const unsigned char *>(map);
+#else
+    std::ifstream fs(filepath, std::ifstream::binary);
+    contents.assign(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+    data = contents.data();
+    size = contents.size();
+#endif
+
+    // (A real program should check that all offsets are within the file)
+    if(size < 128 || load_le(data + 8, 4) != 2 || load_le(data + 112, 4) != 0)
+        throw std::runtime_error("Unsupported binary reference file");
+
+    const unsigned char * shell_data = data + load_le(data + 32, 8);
+    const size_t nshell = load_le(data + 40, 8);
+    const unsigned char * integral_data = data + load_le(data + 64, 8);
+    const unsigned char * index_data = data + load_le(data + 80, 8);
+    const size_t nquartet = load_le(data + 88, 8);
+
+    std::cout << "Read " << nshell << " shells\n";
+    for(size_t i = 0; i < nshell; i++)
+    {
+        const unsigned char * sh = shell_data + 48*i;
+        std::cout << "    Shell " << i << ": am = " << load_le(sh, 4)
+                  << ", nprim = " << load_le(sh+4, 4)
+                  << ", ngeneral = " << load_le(sh+8, 4) << "\n";
+    }
+
+    size_t nintegrals_total = 0;
+
+    for(size_t i = 0; i < nquartet; i++)
+    {
+        const unsigned char * q = index_data + 32*i;
+        const size_t nintegrals = load_le(q+20, 4);
+        const unsigned char * v = integral_data + 8*load_le(q+24, 8);
+
+        std::vector<double> integrals(nintegrals);
+        for(size_t j = 0; j < nintegrals; j++)
+            integrals[j] = load_double(v + 8*j);
+
+        print_quartet(load_le(q, 4), load_le(q+4, 4), load_le(q+8, 4), load_le(q+12, 4), integrals);
+        nintegrals_total += nintegrals;
+    }
+
+    std::cout << "\nRead in " << nintegrals_total << " integrals from the file\n";
+
+#ifdef HAVE_MMAP
+    munmap(const_cast<unsigned char *>(data), size);
+#endif
+    return 0;
+}
+
+
 int main(int argc, char ** argv)
 {
     if(argc != 2)
@@ -136,6 +274,16 @@ int main(int argc, char ** argv)
 
 
     std::cout << "Opening file " << argv[1] << "\n";
+
+    // Binary files start with a magic string
+    {
+        char magic[8] = {0};
+        std::ifstream fs(argv[1], std::ifstream::binary);
+        fs.read(magic, 8);
+        if(fs.good() && std::memcmp(magic, "MIRPREFB", 8) == 0)
+            return read_binary(argv[1]);
+    }
+
     std::ifstream fs(argv[1]);
     if(!fs.is_open())
         throw std::runtime_error("Error opening input file");
@@ -167,14 +315,8 @@ int main(int argc, char ** argv)
             integrals_file[i] = read_hexdouble(fs);
 
         // print what we read and the first/last integrals
-        std::cout << "\nQuartet " << p << " " << q << " " << r << " " << s << " has " << nintegrals << " integrals\n";
-        std::cout << "    " << integrals_file[0] << "\n";
-        if(nintegrals > 1)
-        {
-            std::cout << "    ....\n";
-            std::cout << "    " << integrals_file[nintegrals-1] << "\n";
-        }
-    
+        print_quartet(p, q, r, s, integrals_file);
+
         nintegrals_total += nintegrals;
 
         if(!file_skip(fs, '#'))
@@ -0,0 +1,238 @@
+/*! \file
+ *
+ * \brief Storage of an entire basis set, and its significant shell pairs
+ */
+
+#include "mirp/basis.h"
+#include "mirp/scheduler.h"
+#include <float.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/*! \brief Working precision used to compute the screening bounds */
+#define MIRP_SCREEN_PREC 128
+
+
+/* Data shared by all threads while screening */
+typedef struct
+{
+    const mirp_basis * basis;
+    cb_integral4 cb;
+} mirp_screen_data;
+
+
+void mirp_basis_init(mirp_basis * basis, int nshell, const mirp_shell * shells)
+{
+    assert(nshell >= 0);
+
+    basis->nshell = nshell;
+    basis->am = (int *)malloc((size_t)nshell * sizeof(int));
+    basis->nprim = (int *)malloc((size_t)nshell * sizeof(int));
+    basis->ngeneral = (int *)malloc((size_t)nshell * sizeof(int));
+    basis->prim_start = (long *)malloc((size_t)nshell * sizeof(long));
+    basis->coeff_start = (long *)malloc((size_t)nshell * sizeof(long));
+
+    /* Compute the offsets of each shell first */
+    long nprim_total = 0;
+    long ncoeff_total = 0;
+
+    for(int i = 0; i < nshell; i++)
+    {
+        const mirp_shell * s = shells + i;
+
+        assert(s->am >= 0);
+        assert(s->nprim > 0);
+        assert(s->ngeneral > 0);
+
+        basis->am[i] = s->am;
+        basis->nprim[i] = s->nprim;
+        basis->ngeneral[i] = s->ngeneral;
+        basis->prim_start[i] = nprim_total;
+        basis->coeff_start[i] = ncoeff_total;
+
+        nprim_total += s->nprim;
+        ncoeff_total += (long)s->nprim * s->ngeneral;
+    }
+
+    basis->nprim_total = nprim_total;
+    basis->ncoeff_total = ncoeff_total;
+
+    basis->xyz = (double *)malloc((size_t)nshell * 3 * sizeof(double));
+    basis->alpha = (double *)malloc((size_t)nprim_total * sizeof(double));
+    basis->coeff = (double *)malloc((size_t)ncoeff_total * sizeof(double));
+    basis->xyz_arb = _arb_vec_init(3*nshell);
+    basis->alpha_arb = _arb_vec_init(nprim_total);
+    basis->coeff_arb = _arb_vec_init(ncoeff_total);
+
+    /* Conversion from double to arb_t is exact */
+    for(int i = 0; i < nshell; i++)
+    {
+        const mirp_shell * s = shells + i;
+        const long p0 = basis->prim_start[i];
+        const long c0 = basis->coeff_start[i];
+
+        for(int n = 0; n < 3; n++)
+        {
+            basis->xyz[3*i+n] = s->xyz[n];
+            arb_set_d(basis->xyz_arb + 3*i+n, s->xyz[n]);
+        }
+
+        for(int n = 0; n < s->nprim; n++)
+        {
+            basis->alpha[p0+n] = s->alpha[n];
+            arb_set_d(basis->alpha_arb + p0+n, s->alpha[n]);
+        }
+
+        for(int n = 0; n < s->nprim * s->ngeneral; n++)
+        {
+            basis->coeff[c0+n] = s->coeff[n];
+            arb_set_d(basis->coeff_arb + c0+n, s->coeff[n]);
+        }
+    }
+
+    /* All shell pairs, in order of compound index */
+    const long npair = ((long)nshell * (nshell+1))/2;
+    basis->screen_threshold = 0.0;
+    basis->npair = npair;
+    basis->pair_shells = (int *)malloc((size_t)npair * 2 * sizeof(int));
+    basis->pair_bound = (double *)malloc((size_t)npair * sizeof(double));
+
+    long ij = 0;
+    for(int i = 0; i < nshell; i++)
+    for(int j = 0; j <= i; j++)
+    {
+        basis->pair_shells[2*ij] = i;
+        basis->pair_shells[2*ij+1] = j;
+        basis->pair_bound[ij] = DBL_MAX;
+        ij++;
+    }
+}
+
+
+void mirp_basis_clear(mirp_basis * basis)
+{
+    free(basis->am);
+    free(basis->nprim);
+    free(basis->ngeneral);
+    free(basis->prim_start);
+    free(basis->coeff_start);
+    free(basis->xyz);
+    free(basis->alpha);
+    free(basis->coeff);
+    _arb_vec_clear(basis->xyz_arb, 3*basis->nshell);
+    _arb_vec_clear(basis->alpha_arb, basis->nprim_total);
+    _arb_vec_clear(basis->coeff_arb, basis->ncoeff_total);
+    free(basis->pair_shells);
+    free(basis->pair_bound);
+}
+
+
+long mirp_basis_nfunction(const mirp_basis * basis, int i)
+{
+    return MIRP_NCART(basis->am[i]) * basis->ngeneral[i];
+}
+
+
+/* Computes the bound for a single shell pair
+ *
+ * The integrals (ij|ij) are allocated for each pair, so that memory
+ * does not scale with the largest shell of the basis to the fourth power.
+ */
+static void mirp_screen_task(long p, void * workspace, void * data)
+{
+    const mirp_screen_data * d = (const mirp_screen_data *)data;
+    const mirp_basis * b = d->basis;
+    (void)workspace;
+
+    const int i = b->pair_shells[2*p];
+    const int j = b->pair_shells[2*p+1];
+
+    const long nfunc_ij = mirp_basis_nfunction(b, i) * mirp_basis_nfunction(b, j);
+    const long nintegrals = nfunc_ij * nfunc_ij;
+    arb_ptr integrals = _arb_vec_init(nintegrals);
+
+    arb_srcptr xyz_i = b->xyz_arb + 3*i;
+    arb_srcptr xyz_j = b->xyz_arb + 3*j;
+    arb_srcptr alpha_i = b->alpha_arb + b->prim_start[i];
+    arb_srcptr alpha_j = b->alpha_arb + b->prim_start[j];
+    arb_srcptr coeff_i = b->coeff_arb + b->coeff_start[i];
+    arb_srcptr coeff_j = b->coeff_arb + b->coeff_start[j];
+
+    d->cb(integrals,
+          b->am[i], xyz_i, b->nprim[i], b->ngeneral[i], alpha_i, coeff_i,
+          b->am[j], xyz_j, b->nprim[j], b->ngeneral[j], alpha_j, coeff_j,
+          b->am[i], xyz_i, b->nprim[i], b->ngeneral[i], alpha_i, coeff_i,
+          b->am[j], xyz_j, b->nprim[j], b->ngeneral[j], alpha_j, coeff_j,
+          MIRP_SCREEN_PREC);
+
+    /* Find the largest diagonal element (ab|ab) */
+    const long nci = MIRP_NCART(b->am[i]);
+    const long ncj = MIRP_NCART(b->am[j]);
+    const long ngi = b->ngeneral[i];
+    const long ngj = b->ngeneral[j];
+    const long ncart1234 = nci*ncj*nci*ncj;
+
+    mag_t bound, tmp;
+    mag_init(bound);
+    mag_init(tmp);
+
+    for(long m = 0; m < ngi; m++)
+    for(long n = 0; n < ngj; n++)
+    for(long a = 0; a < nci; a++)
+    for(long c = 0; c < ncj; c++)
+    {
+        const long g = ((m*ngj + n)*ngi + m)*ngj + n;
+        const long q = ((a*ncj + c)*nci + a)*ncj + c;
+
+        arb_get_mag(tmp, integrals + g*ncart1234 + q);
+        mag_max(bound, bound, tmp);
+    }
+
+    /* mag_get_d gives an upper bound */
+    b->pair_bound[p] = mag_get_d(bound);
+
+    mag_clear(bound);
+    mag_clear(tmp);
+    _arb_vec_clear(integrals, nintegrals);
+}
+
+
+void mirp_basis_screen(mirp_basis * basis, double threshold, int nthreads, cb_integral4 cb)
+{
+    assert(threshold >= 0.0);
+
+    mirp_screen_data d;
+    d.basis = basis;
+    d.cb = cb;
+
+    mirp_scheduler_run(basis->npair, nthreads, NULL, NULL,
+                       mirp_screen_task, &d);
+
+    double max_bound = 0.0;
+    for(long p = 0; p < basis->npair; p++)
+    {
+        if(basis->pair_bound[p] > max_bound)
+            max_bound = basis->pair_bound[p];
+    }
+
+    /* Pair ij can be removed if bound[ij] * bound[kl] < threshold^2 for all kl.
+     * The extra factor accounts for rounding in the product. The remaining
+     * pairs are compacted in place, so they stay in order */
+    const double threshold2 = threshold * threshold;
+    long npair = 0;
+
+    for(long p = 0; p < basis->npair; p++)
+    {
+        const double bound = basis->pair_bound[p] * max_bound * (1.0 + 4.0*DBL_EPSILON);
+        if(bound < threshold2)
+            continue;
+
+        basis->pair_shells[2*npair] = basis->pair_shells[2*p];
+        basis->pair_shells[2*npair+1] = basis->pair_shells[2*p+1];
+        basis->pair_bound[npair] = basis->pair_bound[p];
+        npair++;
+    }
+
+    basis->npair = npair;
+    basis->screen_threshold = threshold;
+}
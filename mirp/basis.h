@@ -0,0 +1,104 @@
+/*! \file
+ *
+ * \brief Storage of an entire basis set, and its significant shell pairs
+ */
+
+#pragma once
+
+#include "mirp/typedefs.h"
+#include "mirp/shell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! \brief A basis set stored as a structure of arrays
+ *
+ * All exponents, coefficients, and centers of all shells are stored contiguously,
+ * in both double precision and as (exact) arb_t. The data for shell \c i starts at
+ * \c alpha[prim_start[i]] and \c coeff[coeff_start[i]] (and similarly for the arb_t versions),
+ * and its center is at \c xyz[3*i].
+ *
+ * The basis also holds a list of shell pairs (i, j) with i >= j, in order of
+ * compound index. After \ref mirp_basis_init, this contains all shell pairs. After
+ * \ref mirp_basis_screen, it only contains significant pairs.
+ */
+typedef struct
+{
+    int nshell;             /*!< Number of shells in the basis */
+    int * am;               /*!< Angular momentum of each shell */
+    int * nprim;            /*!< Number of primitives in each shell */
+    int * ngeneral;         /*!< Number of general contractions in each shell */
+    long * prim_start;      /*!< Start of each shell in \p alpha and \p alpha_arb */
+    long * coeff_start;     /*!< Start of each shell in \p coeff and \p coeff_arb */
+    long nprim_total;       /*!< Total number of exponents (length of \p alpha) */
+    long ncoeff_total;      /*!< Total number of coefficients (length of \p coeff) */
+
+    double * xyz;           /*!< Centers of all the shells (length 3 * \p nshell) */
+    double * alpha;         /*!< Exponents of all the shells */
+    double * coeff;         /*!< Unnormalized coefficients of all the shells */
+    arb_ptr xyz_arb;        /*!< Same as \p xyz, as arb_t */
+    arb_ptr alpha_arb;      /*!< Same as \p alpha, as arb_t */
+    arb_ptr coeff_arb;      /*!< Same as \p coeff, as arb_t */
+
+    double screen_threshold; /*!< Threshold used for screening (0 if not screened) */
+    long npair;              /*!< Number of (significant) shell pairs */
+    int * pair_shells;       /*!< Shell indices (i, j) of each pair (length 2 * \p npair) */
+    double * pair_bound;     /*!< Upper bound of the largest |(ab|ab)| of each pair (length \p npair) */
+} mirp_basis;
+
+
+/*! \brief Creates a basis from a list of shells
+ *
+ * All data is copied, so \p shells may be freed afterwards. The pair list
+ * contains all shell pairs.
+ *
+ * The basis must be destroyed with \ref mirp_basis_clear.
+ *
+ * \param [out] basis  The basis to initialize
+ * \param [in]  nshell Number of shells
+ * \param [in]  shells The shells of the basis (length \p nshell)
+ */
+void mirp_basis_init(mirp_basis * basis, int nshell, const mirp_shell * shells);
+
+
+/*! \brief Frees all memory associated with a basis
+ *
+ * \param [in] basis The basis to destroy
+ */
+void mirp_basis_clear(mirp_basis * basis);
+
+
+/*! \brief Removes insignificant shell pairs from the pair list of a basis
+ *
+ * For each shell pair, an upper bound of the diagonal integrals |(ab|ab)| is computed
+ * using interval arithmetic. By the Schwarz inequality, |(ab|cd)| <= sqrt(|(ab|ab)|) * sqrt(|(cd|cd)|).
+ * Pairs where all integrals (ij|kl) (for any kl) are guaranteed to have a magnitude
+ * smaller than \p threshold are removed.
+ *
+ * The bounds are kept, and are used to screen individual quartets when computing
+ * integrals over the basis.
+ *
+ * \param [inout] basis     The basis to screen
+ * \param [in]    threshold Screening threshold
+ * \param [in]    nthreads  Number of threads to use (0 for the default)
+ * \param [in]    cb        Function that computes all cartesian integrals of a
+ *                          contracted shell quartet using interval arithmetic
+ */
+void mirp_basis_screen(mirp_basis * basis, double threshold, int nthreads, cb_integral4 cb);
+
+
+/*! \brief Number of functions in a shell (cartesian components times general contractions)
+ *
+ * \param [in] basis The basis containing the shell
+ * \param [in] i     Index of the shell
+ * \return The number of functions in shell \p i
+ */
+long mirp_basis_nfunction(const mirp_basis * basis, int i);
+
+
+#ifdef __cplusplus
+}
+#endif
+
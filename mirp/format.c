@@ -0,0 +1,271 @@
+/*! \file
+ *
+ * \brief Binary floating-point formats that results can be certified for
+ */
+
+#include "mirp/format.h"
+#include "mirp/math.h"
+#include <assert.h>
+
+
+size_t mirp_format_size(mirp_format fmt)
+{
+    switch(fmt)
+    {
+        case MIRP_BINARY32:
+            return sizeof(float);
+        case MIRP_BINARY64:
+            return sizeof(double);
+        default:
+            assert(fmt == MIRP_BINARY128);
+            return sizeof(mirp_binary128);
+    }
+}
+
+
+slong mirp_format_prec(mirp_format fmt)
+{
+    switch(fmt)
+    {
+        case MIRP_BINARY32:
+            return 24;
+        case MIRP_BINARY64:
+            return 53;
+        default:
+            assert(fmt == MIRP_BINARY128);
+            return 113;
+    }
+}
+
+
+/* Exponent of the largest finite value of a format
+ * (that is, the largest finite value is just below 2^(emax+1)) */
+static slong mirp_format_max_exp(mirp_format fmt)
+{
+    switch(fmt)
+    {
+        case MIRP_BINARY32:
+            return 127;
+        case MIRP_BINARY64:
+            return 1023;
+        default:
+            assert(fmt == MIRP_BINARY128);
+            return 16383;
+    }
+}
+
+
+slong mirp_format_min_exp(mirp_format fmt)
+{
+    /* The smallest normal value is 2^(1-emax). Subnormal values
+     * have p-1 fewer bits available below that */
+    return 2 - mirp_format_max_exp(fmt) - mirp_format_prec(fmt);
+}
+
+
+void mirp_format_round(arf_t y, const arf_t x, mirp_format fmt)
+{
+    if(arf_is_zero(x) || !arf_is_finite(x))
+    {
+        arf_set(y, x);
+        return;
+    }
+
+    const int sgn = arf_sgn(x);
+    const slong min_exp = mirp_format_min_exp(fmt);
+
+    /* 2^(e-1) <= |x| < 2^e. Representable values near x are spaced by 2^q */
+    const slong e = arf_abs_bound_lt_2exp_si(x);
+    const slong q = MAX(e - mirp_format_prec(fmt), min_exp);
+
+    if(e > q)
+        arf_set_round(y, x, e - q, ARF_RND_NEAR);
+    else
+    {
+        /* Below the smallest subnormal value, x rounds to either zero or
+         * the smallest subnormal. Exactly half of it rounds to (even) zero */
+        if(arf_cmpabs_2exp_si(x, min_exp - 1) > 0)
+        {
+            arf_set_si(y, sgn);
+            arf_mul_2exp_si(y, y, min_exp);
+        }
+        else
+            arf_zero(y);
+    }
+
+    /* Overflow */
+    if(arf_cmpabs_2exp_si(y, mirp_format_max_exp(fmt) + 1) >= 0)
+    {
+        if(sgn > 0)
+            arf_pos_inf(y);
+        else
+            arf_neg_inf(y);
+    }
+}
+
+
+int mirp_format_certified(const arb_t x, mirp_format fmt, slong working_prec)
+{
+    if(!arb_is_finite(x))
+        return 0;
+
+    arf_t lbound, ubound;
+    arf_init(lbound);
+    arf_init(ubound);
+
+    /* The bounds are rounded outwards, so this can only fail
+     * to certify a value, never certify a wrong one */
+    arb_get_lbound_arf(lbound, x, working_prec);
+    arb_get_ubound_arf(ubound, x, working_prec);
+    mirp_format_round(lbound, lbound, fmt);
+    mirp_format_round(ubound, ubound, fmt);
+
+    const int certified = arf_equal(lbound, ubound);
+
+    arf_clear(lbound);
+    arf_clear(ubound);
+    return certified;
+}
+
+
+void mirp_format_tolerance(mag_t tol, double abs_tol, double rel_tol, const mag_t max_mag)
+{
+    assert(abs_tol >= 0.0);
+    assert(rel_tol >= 0.0);
+
+    mag_t tmp;
+    mag_init(tmp);
+
+    mag_set_d_lower(tol, abs_tol);
+    mag_set_d_lower(tmp, rel_tol);
+    mag_mul_lower(tmp, tmp, max_mag);
+    mag_max(tol, tol, tmp);
+
+    mag_clear(tmp);
+}
+
+
+int mirp_format_negligible(const arb_t x, const mag_t tol)
+{
+    if(mag_is_zero(tol) || !arb_is_finite(x))
+        return 0;
+
+    mag_t tmp;
+    mag_init(tmp);
+
+    arb_get_mag(tmp, x);
+    const int negligible = (mag_cmp(tmp, tol) <= 0);
+
+    mag_clear(tmp);
+    return negligible;
+}
+
+
+/* Converts a value that is exactly representable in binary128 to its bits */
+static void mirp_binary128_set_arf(mirp_binary128 * out, const arf_t y)
+{
+    const uint64_t exp_mask = UINT64_C(0x7FFF) << 48;
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    if(arf_is_nan(y))
+        hi = exp_mask | (UINT64_C(1) << 47);
+    else if(arf_is_inf(y))
+        hi = exp_mask;
+    else if(!arf_is_zero(y))
+    {
+        arf_t t, high, low;
+        arf_init(t);
+        arf_init(high);
+        arf_init(low);
+
+        /* Shift the value so that the significand (113 bits for normal values,
+         * fewer for subnormal values) is an integer */
+        const slong e = arf_abs_bound_lt_2exp_si(y);
+        slong biased_exp = e - 1 + mirp_format_max_exp(MIRP_BINARY128);
+        slong shift = mirp_format_prec(MIRP_BINARY128) - e;
+
+        if(biased_exp <= 0)
+        {
+            biased_exp = 0;
+            shift = -mirp_format_min_exp(MIRP_BINARY128);
+        }
+
+        arf_abs(t, y);
+        arf_mul_2exp_si(t, t, shift);
+
+        /* Split the significand into 32-bit words (from least significant),
+         * which always fit into a slong */
+        for(int k = 0; k < 4; k++)
+        {
+            arf_mul_2exp_si(high, t, -32);
+            arf_floor(high, high);
+            arf_mul_2exp_si(low, high, 32);
+            arf_sub(low, t, low, ARF_PREC_EXACT, ARF_RND_DOWN);
+
+            const uint64_t word = (uint64_t)arf_get_si(low, ARF_RND_DOWN);
+            if(k < 2)
+                lo |= word << (32*k);
+            else
+                hi |= word << (32*(k-2));
+
+            arf_swap(t, high);
+        }
+
+        /* Replace the implicit bit with the exponent */
+        hi = (hi & ((UINT64_C(1) << 48) - 1)) | ((uint64_t)biased_exp << 48);
+
+        arf_clear(t);
+        arf_clear(high);
+        arf_clear(low);
+    }
+
+    if(arf_sgn(y) < 0)
+        hi |= UINT64_C(1) << 63;
+
+    out->lo = lo;
+    out->hi = hi;
+}
+
+
+void mirp_format_set_arb(void * out, long i, const arb_t x, mirp_format fmt)
+{
+    arf_t y;
+    arf_init(y);
+
+    /* After rounding, the conversions below are exact */
+    mirp_format_round(y, arb_midref(x), fmt);
+
+    switch(fmt)
+    {
+        case MIRP_BINARY32:
+            ((float *)out)[i] = (float)arf_get_d(y, ARF_RND_NEAR);
+            break;
+        case MIRP_BINARY64:
+            ((double *)out)[i] = arf_get_d(y, ARF_RND_NEAR);
+            break;
+        default:
+            assert(fmt == MIRP_BINARY128);
+            mirp_binary128_set_arf((mirp_binary128 *)out + i, y);
+            break;
+    }
+
+    /* A negative midpoint that rounds to zero is stored as -0 */
+    if(arf_is_zero(y) && arf_sgn(arb_midref(x)) < 0)
+    {
+        switch(fmt)
+        {
+            case MIRP_BINARY32:
+                ((float *)out)[i] = -0.0f;
+                break;
+            case MIRP_BINARY64:
+                ((double *)out)[i] = -0.0;
+                break;
+            default:
+                ((mirp_binary128 *)out)[i].hi |= UINT64_C(1) << 63;
+                break;
+        }
+    }
+
+    arf_clear(y);
+}
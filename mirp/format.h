@@ -0,0 +1,134 @@
+/*! \file
+ *
+ * \brief Binary floating-point formats that results can be certified for
+ */
+
+#pragma once
+
+#include <arb.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! \brief IEEE 754 binary floating-point formats
+ *
+ * Values in these formats are stored as `float`, `double`, and
+ * \ref mirp_binary128, respectively.
+ */
+typedef enum
+{
+    MIRP_BINARY32,  /*!< Single precision (24-bit significand) */
+    MIRP_BINARY64,  /*!< Double precision (53-bit significand) */
+    MIRP_BINARY128  /*!< Quadruple precision (113-bit significand) */
+} mirp_format;
+
+
+/*! \brief Storage for an IEEE 754 binary128 (quadruple precision) value
+ *
+ * \p hi contains the sign bit, the 15-bit biased exponent, and the top 48 bits
+ * of the fraction. \p lo contains the remaining 64 bits of the fraction.
+ * On little-endian machines, this has the same layout as `__float128`
+ * (and `long double` on platforms where it is quadruple precision), so it
+ * can be copied into one of those with memcpy.
+ */
+typedef struct
+{
+    uint64_t lo; /*!< Lower 64 bits of the fraction */
+    uint64_t hi; /*!< Sign, exponent, and upper 48 bits of the fraction */
+} mirp_binary128;
+
+
+/*! \brief Working precision beyond which the exact functions stop increasing the precision
+ *
+ * This is only reached if a value is (nearly) exactly halfway between two
+ * values of the requested format, in which case the rounded midpoint
+ * of the last attempt is used.
+ */
+#define MIRP_FORMAT_MAX_PREC 65536
+
+
+/*! \brief Size (in bytes) of a single value of a format */
+size_t mirp_format_size(mirp_format fmt);
+
+
+/*! \brief Number of bits in the significand of a format (including the implicit bit) */
+slong mirp_format_prec(mirp_format fmt);
+
+
+/*! \brief Exponent of the smallest positive (subnormal) value of a format
+ *
+ * This is also the spacing of the subnormal values.
+ */
+slong mirp_format_min_exp(mirp_format fmt);
+
+
+/*! \brief Rounds a number to the nearest value representable in a format
+ *
+ * Ties are rounded to even. Subnormal values are handled, and values
+ * that are too large for the format are rounded to infinity.
+ *
+ * \param [out] y   The rounded value
+ * \param [in]  x   The value to round
+ * \param [in]  fmt The format to round to
+ */
+void mirp_format_round(arf_t y, const arf_t x, mirp_format fmt);
+
+
+/*! \brief Determines if a value is known to the accuracy of a format
+ *
+ * A value is certified if all numbers within the ball round to the same
+ * value of the given format. That rounded value is then the correctly-rounded
+ * value of the (unknown) exact result.
+ *
+ * \param [in] x            The value to check
+ * \param [in] fmt          The format the value is needed in
+ * \param [in] working_prec Precision used for the endpoints of the ball
+ * \return Nonzero if the value is certified, zero otherwise
+ */
+int mirp_format_certified(const arb_t x, mirp_format fmt, slong working_prec);
+
+
+/*! \brief Computes the tolerance below which values do not need to be correctly rounded
+ *
+ * The tolerance is the larger of \p abs_tol and \p rel_tol times \p max_mag,
+ * rounded down. A tolerance of zero means that all values must be certified.
+ *
+ * \param [out] tol     The resulting tolerance
+ * \param [in]  abs_tol Absolute tolerance (ignored if zero)
+ * \param [in]  rel_tol Tolerance relative to the largest value (ignored if zero)
+ * \param [in]  max_mag Lower bound of the magnitude of the largest value
+ */
+void mirp_format_tolerance(mag_t tol, double abs_tol, double rel_tol, const mag_t max_mag);
+
+
+/*! \brief Determines if the magnitude of a value is known to be within a tolerance
+ *
+ * \param [in] x   The value to check
+ * \param [in] tol The tolerance (see \ref mirp_format_tolerance)
+ * \return Nonzero if the entire ball is within \p tol of zero (and \p tol is
+ *         not zero), zero otherwise
+ */
+int mirp_format_negligible(const arb_t x, const mag_t tol);
+
+
+/*! \brief Stores the midpoint of a ball in an array of values of a format
+ *
+ * The midpoint is rounded (see \ref mirp_format_round) and stored
+ * as element \p i of \p out. A negative midpoint that rounds to zero
+ * is stored as -0.
+ *
+ * \param [out] out Array of values of type given by \p fmt
+ * \param [in]  i   Index in \p out to store the value at
+ * \param [in]  x   The value to store
+ * \param [in]  fmt The format of the values in \p out
+ */
+void mirp_format_set_arb(void * out, long i, const arb_t x, mirp_format fmt);
+
+
+#ifdef __cplusplus
+}
+#endif
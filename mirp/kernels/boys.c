@@ -3,9 +3,10 @@
  * \brief Calculation of the boys function using interval arithmetic
  */
 
-#include "mirp/pragma.h"
 #include "mirp/math.h"
 #include "mirp/kernels/boys.h"
+#include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 
 void mirp_boys(arb_ptr F, int m, const arb_t t, slong working_prec)
@@ -169,11 +170,26 @@ void mirp_boys_str(arb_ptr F, int m, const char * t, slong working_prec)
 }
 
 
-void mirp_boys_exact(double *F, int m, double t)
+/* Estimates the number of bits lost when computing the Boys function
+ *
+ * Both the series and the downward recursion only add positive terms, so
+ * the only loss is from rounding. That grows with the number of terms in
+ * the short-range series (about t, but the long-range formula is used for
+ * large t) and with the number of steps in the recursion (m).
+ */
+static double mirp_boys_loss_bits(int m, double t)
+{
+    const double nterms = m + MIN(t, m + 2.0) + 2.0;
+    return log2(nterms) + 8.0;
+}
+
+
+long mirp_boys_target_tol(void * F, char * inexact, mirp_format fmt, int m, double t,
+                          double abs_tol, double rel_tol)
 {
-    /* The target precision is the number of bits in
-     * double precision (53) + safety */
-    const slong target_prec = 64;
+    /* The target precision (used only for the starting precision) is the
+     * number of bits in the format + safety */
+    const slong target_prec = mirp_format_prec(fmt) + 11;
 
     /* convert the input to arb_t
      * Since we are converting from binary (double precision)
@@ -186,55 +202,87 @@ void mirp_boys_exact(double *F, int m, double t)
 
     arb_ptr F_mp = _arb_vec_init(m+1);
 
-    slong working_prec = target_prec;
+    /* Start with the estimated precision. If that is not enough,
+     * the precision is increased geometrically */
+    slong working_prec = mirp_exact_start_prec(target_prec, mirp_boys_loss_bits(m, t));
     int suff_acc = 0;
 
-    /* for comparisons */
-    arf_t ubound, lbound;
-    arf_init(ubound);
-    arf_init(lbound);
+    /* Values smaller than the tolerance do not need to be certified */
+    char * uncertified = (char *)malloc((size_t)(m+1));
+    mag_t tol, max_mag, tmp;
+    mag_init(tol);
+    mag_init(max_mag);
+    mag_init(tmp);
 
     while(!suff_acc)
     {
-        working_prec += target_prec;
-        suff_acc = 1;
-
         mirp_boys(F_mp, m, t_mp, working_prec);
 
-        suff_acc = 1;
+        /* Lower bound of the largest value, for the relative tolerance */
         for(int i = 0; i <= m; i++)
         {
-            /* Do we have sufficient accuracy? We need at least
-             * 53 bits + 11 bits safety OR the value is zero (has zero precision)
-             * and the error bounds is exactly zero when converted to double precision */
-            slong bits = arb_rel_accuracy_bits(F_mp + i);
-
-            if(bits > 0 && bits < target_prec)
-                suff_acc = 0;
-            else if(bits <= 0)
+            if(arb_is_finite(F_mp + i))
             {
-                arb_get_ubound_arf(ubound, F_mp + i, working_prec);
-                arb_get_lbound_arf(lbound, F_mp + i, working_prec);
+                arb_get_mag_lower(tmp, F_mp + i);
+                mag_max(max_mag, max_mag, tmp);
+            }
+        }
 
-                PRAGMA_WARNING_PUSH
-                PRAGMA_WARNING_IGNORE_FP_UNDERFLOW
+        mirp_format_tolerance(tol, abs_tol, rel_tol, max_mag);
 
-                if(arf_cmpabs_d(lbound, MIRP_DBL_TRUE_MIN) > 0 || 
-                   arf_cmpabs_d(ubound, MIRP_DBL_TRUE_MIN) > 0)
-                        suff_acc = 0; 
+        /* Do we have sufficient accuracy? The entire ball of each
+         * value must round to the same value in the requested format,
+         * or be within the tolerance */
+        suff_acc = 1;
+        for(int i = 0; i <= m; i++)
+        {
+            uncertified[i] = 0;
+            if(mirp_format_certified(F_mp + i, fmt, working_prec))
+                continue;
 
-                PRAGMA_WARNING_POP
-            }
+            uncertified[i] = 1;
+            if(!mirp_format_negligible(F_mp + i, tol))
+                suff_acc = 0;
         }
+
+        /* A value (nearly) halfway between two values of the format
+         * may never be certified */
+        if(!suff_acc && working_prec >= MIRP_FORMAT_MAX_PREC)
+            break;
+
+        if(!suff_acc)
+            working_prec = mirp_exact_next_prec(working_prec);
     }
 
-    /* convert back to double precision */
+    /* convert back to the requested format */
+    long nuncertified = 0;
     for(int i = 0; i <= m; i++)
-        F[i] = arf_get_d(arb_midref(F_mp + i), ARF_RND_NEAR);
+    {
+        mirp_format_set_arb(F, i, F_mp + i, fmt);
+        if(inexact)
+            inexact[i] = uncertified[i];
+        if(uncertified[i])
+            nuncertified++;
+    }
 
-    arf_clear(lbound);
-    arf_clear(ubound);
+    mag_clear(tol);
+    mag_clear(max_mag);
+    mag_clear(tmp);
+    free(uncertified);
     arb_clear(t_mp);
     _arb_vec_clear(F_mp, m+1);
+
+    return nuncertified;
 }
 
+
+long mirp_boys_target(void * F, mirp_format fmt, int m, double t)
+{
+    return mirp_boys_target_tol(F, NULL, fmt, m, t, 0.0, 0.0);
+}
+
+
+long mirp_boys_exact(double *F, int m, double t)
+{
+    return mirp_boys_target(F, MIRP_BINARY64, m, t);
+}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <arb.h>
+#include "mirp/format.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,8 +49,60 @@ void mirp_boys_str(arb_ptr F, int m, const char * t, slong working_prec);
  * \param [out] F The computed values of the Boys function
  * \param [in]  m The maximum order to calculate
  * \param [in]  t The value at which to evaluate
+ * \return The number of values that may not be correctly rounded
+ *         (zero if all are certified)
  */
-void mirp_boys_exact(double *F, int m, double t);
+long mirp_boys_exact(double *F, int m, double t);
+
+
+/*! \brief Computes the Boys function correctly rounded to a given
+ *         floating-point format using interval arithmetic
+ *
+ * The working precision is increased until the error ball of every
+ * value rounds to a single value of the format \p fmt (see \ref mirp_format_certified).
+ * \ref mirp_boys_exact is this function with \ref MIRP_BINARY64.
+ *
+ * \warning \p F must be large enough to hold (\p m + 1) values, since
+ *             this is computing from zero to m.
+ *
+ * \param [out] F   The computed values of the Boys function (`float`, `double`,
+ *                  or \ref mirp_binary128, depending on \p fmt)
+ * \param [in]  fmt Format of the output
+ * \param [in]  m   The maximum order to calculate
+ * \param [in]  t   The value at which to evaluate
+ * \return The number of values that may not be correctly rounded (zero if all
+ *         are certified). The rounded midpoint of the last attempt is stored for
+ *         each value that could not be certified by \ref MIRP_FORMAT_MAX_PREC.
+ */
+long mirp_boys_target(void * F, mirp_format fmt, int m, double t);
+
+
+/*! \brief Computes the Boys function correctly rounded to a given
+ *         floating-point format, unless negligible
+ *
+ * This is \ref mirp_boys_target, except that values whose magnitude is known
+ * to be at most a tolerance are accepted without being certified. The tolerance
+ * is the larger of \p abs_tol and \p rel_tol times the largest value
+ * (which is \f$F_0(t)\f$). Such values may not be correctly rounded, and are
+ * flagged in \p inexact.
+ *
+ * \warning \p F and \p inexact must be large enough to hold (\p m + 1) values, since
+ *             this is computing from zero to m.
+ *
+ * \param [out] F       The computed values of the Boys function (`float`, `double`,
+ *                      or \ref mirp_binary128, depending on \p fmt)
+ * \param [out] inexact For each value, nonzero if it may not be correctly rounded:
+ *                      it was only found to be within the tolerance, or could not be
+ *                      certified by \ref MIRP_FORMAT_MAX_PREC (may be NULL)
+ * \param [in]  fmt     Format of the output
+ * \param [in]  m       The maximum order to calculate
+ * \param [in]  t       The value at which to evaluate
+ * \param [in]  abs_tol Absolute tolerance (zero for none)
+ * \param [in]  rel_tol Tolerance relative to the largest value (zero for none)
+ * \return The number of values flagged in \p inexact
+ */
+long mirp_boys_target_tol(void * F, char * inexact, mirp_format fmt, int m, double t,
+                          double abs_tol, double rel_tol);
 
 
 #ifdef __cplusplus
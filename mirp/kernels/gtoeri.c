@@ -110,6 +110,233 @@ static void mirp_G(arb_t G, arb_t fp, arb_t fq,
     arb_clear(tmp2);
 }
 
+
+/* Determines if two centers represent the same point
+ *
+ * Centers are coincident if they are the same array, or if all
+ * their coordinates are exact and equal. Two inexact balls with the
+ * same midpoint and radius may still represent different points, and
+ * are not considered coincident.
+ */
+static int mirp_same_center(arb_srcptr A, arb_srcptr B)
+{
+    if(A == B)
+        return 1;
+
+    for(int i = 0; i < 3; i++)
+    {
+        if(!arb_is_exact(A+i) || !arb_equal(A+i, B+i))
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/* Computes a single cartesian ERI where A = B and C = D
+ *
+ * With coincident centers, PA, PB, QC, and QD are all zero. The
+ * expansions of mirp_farr then only contain a single nonzero term
+ * (which is exactly one), and the prefactors K1 and K2 are also one.
+ * The only remaining parameter is the distance between A and C.
+ *
+ * If one_center is nonzero, A = C as well. In that case PQ is zero, so only
+ * terms without powers of PQ survive, and the Boys function reduces
+ * to F_m(0) = 1/(2m+1). The integral is zero unless the total
+ * exponents of x, y, and z are all even.
+ */
+static void mirp_gtoeri_single_coincident(arb_t integral,
+                                          const int * lmn1, const int * lmn2,
+                                          arb_srcptr A, const arb_t alpha1, const arb_t alpha2,
+                                          const int * lmn3, const int * lmn4,
+                                          arb_srcptr C, const arb_t alpha3, const arb_t alpha4,
+                                          int one_center, slong working_prec)
+{
+    const int lp = lmn1[0] + lmn2[0];
+    const int mp = lmn1[1] + lmn2[1];
+    const int np = lmn1[2] + lmn2[2];
+    const int lq = lmn3[0] + lmn4[0];
+    const int mq = lmn3[1] + lmn4[1];
+    const int nq = lmn3[2] + lmn4[2];
+    const int L = lp + lq + mp + mq + np + nq;
+
+    if(one_center && ((lp + lq) % 2 || (mp + mq) % 2 || (np + nq) % 2))
+    {
+        arb_zero(integral);
+        return;
+    }
+
+    arb_ptr F = _arb_vec_init(L+1);
+    arb_ptr PQ = _arb_vec_init(3);
+
+    arb_t one, tmp1, tmp2, tmp3;
+    arb_t tmp4x, tmp4y, tmp4xy, tmp4z;
+    arb_t gammap, gammaq, gammapq;
+    arb_t Gx, Gy, Gxy, Gz, Gxyz;
+    arb_init(one);
+    arb_init(tmp1);
+    arb_init(tmp2);
+    arb_init(tmp3);
+    arb_init(tmp4x);
+    arb_init(tmp4y);
+    arb_init(tmp4xy);
+    arb_init(tmp4z);
+    arb_init(gammap);
+    arb_init(gammaq);
+    arb_init(gammapq);
+    arb_init(Gx);
+    arb_init(Gy);
+    arb_init(Gxy);
+    arb_init(Gz);
+    arb_init(Gxyz);
+
+    /* The only nonzero term of each mirp_farr expansion */
+    arb_one(one);
+
+    /* Zero the integral (we will be summing into it) */
+    arb_zero(integral);
+
+    arb_add(gammap, alpha1, alpha2, working_prec);
+    arb_add(gammaq, alpha3, alpha4, working_prec);
+    arb_mul(tmp1, gammap, gammaq, working_prec);
+    arb_add(tmp2, gammap, gammaq, working_prec);
+    arb_div(gammapq, tmp1, tmp2, working_prec);
+
+    if(one_center)
+    {
+        /* F_m(0) = 1/(2m+1). PQ stays zero */
+        for(int i = 0; i <= L; i++)
+        {
+            arb_one(F+i);
+            arb_div_si(F+i, F+i, 2*i+1, working_prec);
+        }
+    }
+    else
+    {
+        arb_sub(PQ+0, A+0, C+0, working_prec);
+        arb_sub(PQ+1, A+1, C+1, working_prec);
+        arb_sub(PQ+2, A+2, C+2, working_prec);
+
+        arb_mul(tmp1, PQ+0, PQ+0, working_prec);
+        arb_addmul(tmp1, PQ+1, PQ+1, working_prec);
+        arb_addmul(tmp1, PQ+2, PQ+2, working_prec);
+        arb_mul(tmp1, tmp1, gammapq, working_prec);
+        mirp_boys(F, L, tmp1, working_prec);
+    }
+
+    for(int u1 = 0; u1 <= (lp/2); u1++)
+    for(int u2 = 0; u2 <= (lq/2); u2++)
+    {
+        mirp_G(Gx, one, one, lp, lq, u1, u2, gammap, gammaq, gammapq, working_prec);
+
+        for(int v1 = 0; v1 <= (mp/2); v1++)
+        for(int v2 = 0; v2 <= (mq/2); v2++)
+        {
+            mirp_G(Gy, one, one, mp, mq, v1, v2, gammap, gammaq, gammapq, working_prec);
+            arb_mul(Gxy, Gx, Gy, working_prec);
+
+            for(int w1 = 0; w1 <= (np/2); w1++)
+            for(int w2 = 0; w2 <= (nq/2); w2++)
+            {
+                mirp_G(Gz, one, one, np, nq, w1, w2, gammap, gammaq, gammapq, working_prec);
+                arb_mul(Gxyz, Gxy, Gz, working_prec);
+
+                /* For one center, only the terms with a zero power of PQ remain */
+                const int tx_max = (lp + lq - 2 * (u1 + u2)) / 2;
+                const int ty_max = (mp + mq - 2 * (v1 + v2)) / 2;
+                const int tz_max = (np + nq - 2 * (w1 + w2)) / 2;
+
+                for(int tx = (one_center ? tx_max : 0); tx <= tx_max; tx++)
+                {
+                    const int xfac = lp + lq - 2*(u1 + u2 + tx);
+                    mirp_pow_si(tmp4x, PQ+0, xfac, working_prec);
+                    mirp_factorial(tmp3, xfac);
+                    arb_div(tmp4x, tmp4x, tmp3, working_prec);
+
+                    for(int ty = (one_center ? ty_max : 0); ty <= ty_max; ty++)
+                    {
+                        const int yfac = mp + mq - 2*(v1 + v2 + ty);
+                        mirp_pow_si(tmp4y, PQ+1, yfac, working_prec);
+                        mirp_factorial(tmp3, yfac);
+                        arb_div(tmp4y, tmp4y, tmp3, working_prec);
+                        arb_mul(tmp4xy, tmp4x, tmp4y, working_prec);
+
+                        for(int tz = (one_center ? tz_max : 0); tz <= tz_max; tz++)
+                        {
+                            const int zfac = np + nq - 2*(w1 + w2 + tz);
+                            mirp_pow_si(tmp4z, PQ+2, zfac, working_prec);
+                            mirp_factorial(tmp3, zfac);
+                            arb_div(tmp4z, tmp4z, tmp3, working_prec);
+
+                            const int zeta = L - 2*(u1 + u2 + v1 + v2 + w1 + w2) - tx - ty - tz;
+
+                            arb_mul_si(tmp1, Gxyz, NEG1_POW(tx+ty+tz), working_prec);
+                            arb_mul(tmp1, tmp1, F + zeta, working_prec);
+                            arb_mul(tmp1, tmp1, tmp4xy, working_prec);
+                            arb_mul(tmp1, tmp1, tmp4z, working_prec);
+
+                            arb_set_ui(tmp2, 4);
+                            mirp_pow_si(tmp2, tmp2, u1 + u2 + tx + v1 + v2 + ty + w1 + w2 + tz, working_prec);
+
+                            mirp_pow_si(tmp3, gammapq, tx + ty + tz, working_prec);
+                            arb_mul(tmp2, tmp2, tmp3, working_prec);
+
+                            mirp_factorial(tmp3, tx);
+                            arb_mul(tmp2, tmp2, tmp3, working_prec);
+
+                            mirp_factorial(tmp3, ty);
+                            arb_mul(tmp2, tmp2, tmp3, working_prec);
+
+                            mirp_factorial(tmp3, tz);
+                            arb_mul(tmp2, tmp2, tmp3, working_prec);
+
+                            arb_div(tmp1, tmp1, tmp2, working_prec);
+
+                            arb_add(integral, integral, tmp1, working_prec);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /* Prefactor. K1 = K2 = 1, so this is
+     * 2 * pi**2.5 / (gammap * gammaq * sqrt(gammap + gammaq))
+     */
+    arb_const_pi(tmp1, working_prec);
+    arb_pow_ui(tmp1, tmp1, 5, working_prec);
+    arb_sqrt(tmp1, tmp1, working_prec);
+    arb_mul_ui(tmp1, tmp1, 2, working_prec);
+
+    arb_add(tmp2, gammap, gammaq, working_prec);
+    arb_sqrt(tmp2, tmp2, working_prec);
+    arb_mul(tmp2, tmp2, gammap, working_prec);
+    arb_mul(tmp2, tmp2, gammaq, working_prec);
+    arb_div(tmp1, tmp1, tmp2, working_prec);
+
+    arb_mul(integral, integral, tmp1, working_prec);
+
+    _arb_vec_clear(F, L+1);
+    _arb_vec_clear(PQ, 3);
+    arb_clear(one);
+    arb_clear(tmp1);
+    arb_clear(tmp2);
+    arb_clear(tmp3);
+    arb_clear(tmp4x);
+    arb_clear(tmp4y);
+    arb_clear(tmp4xy);
+    arb_clear(tmp4z);
+    arb_clear(gammap);
+    arb_clear(gammaq);
+    arb_clear(gammapq);
+    arb_clear(Gx);
+    arb_clear(Gy);
+    arb_clear(Gxy);
+    arb_clear(Gz);
+    arb_clear(Gxyz);
+}
+
+
 void mirp_gtoeri_single(arb_t integral,
                         const int * lmn1, arb_srcptr A, const arb_t alpha1,
                         const int * lmn2, arb_srcptr B, const arb_t alpha2,
@@ -122,6 +349,16 @@ void mirp_gtoeri_single(arb_t integral,
     assert(lmn3[0] >= 0); assert(lmn3[1] >= 0); assert(lmn3[2] >= 0);
     assert(lmn4[0] >= 0); assert(lmn4[1] >= 0); assert(lmn4[2] >= 0);
 
+    /* Two- and one-center integrals have a simpler form */
+    if(mirp_same_center(A, B) && mirp_same_center(C, D))
+    {
+        mirp_gtoeri_single_coincident(integral,
+                                      lmn1, lmn2, A, alpha1, alpha2,
+                                      lmn3, lmn4, C, alpha3, alpha4,
+                                      mirp_same_center(A, C), working_prec);
+        return;
+    }
+
     const int L_l = lmn1[0]+lmn2[0]+lmn3[0]+lmn4[0];
     const int L_m = lmn1[1]+lmn2[1]+lmn3[1]+lmn4[1];
     const int L_n = lmn1[2]+lmn2[2]+lmn3[2]+lmn4[2];
@@ -380,3 +617,134 @@ void mirp_gtoeri_single(arb_t integral,
     arb_clear(Gxyz);
 }
 
+
+
+/* For a gaussian with angular momentum am and exponent alpha, computes
+ * M and alpha_out such that |x^l y^m z^n exp(-alpha r^2)| <= M exp(-alpha_out r^2)
+ * for any l+m+n = am.
+ *
+ * Since |x^l y^m z^n| <= r^am, and r^am exp(-alpha r^2 / 2) has a maximum
+ * at r^2 = am / alpha, M = (am / (e alpha))^(am/2) and alpha_out = alpha / 2.
+ */
+static void mirp_gtoeri_bound_prim(arb_t M, arb_t alpha_out,
+                                   int am, const arb_t alpha,
+                                   slong working_prec)
+{
+    if(am == 0)
+    {
+        arb_one(M);
+        arb_set(alpha_out, alpha);
+        return;
+    }
+
+    /* alpha_out is used as a temporary */
+    arb_const_e(alpha_out, working_prec);
+    arb_mul(alpha_out, alpha_out, alpha, working_prec);
+    arb_set_ui(M, (ulong)am);
+    arb_div(M, M, alpha_out, working_prec);
+    arb_sqrt(M, M, working_prec);
+    arb_pow_ui(M, M, (ulong)am, working_prec);
+
+    arb_mul_2exp_si(alpha_out, alpha, -1);
+}
+
+
+void mirp_gtoeri_bound(mag_t bound,
+                       int am1, arb_srcptr A, const arb_t alpha1,
+                       int am2, arb_srcptr B, const arb_t alpha2,
+                       int am3, arb_srcptr C, const arb_t alpha3,
+                       int am4, arb_srcptr D, const arb_t alpha4,
+                       slong working_prec)
+{
+    assert(am1 >= 0);
+    assert(am2 >= 0);
+    assert(am3 >= 0);
+    assert(am4 >= 0);
+
+    /* The bound does not need to be precise, just rigorous */
+    const slong prec = MIN(working_prec, 64);
+
+    /* Each cartesian gaussian is bounded by M times an s-type gaussian,
+     * and the integrand of the ERI is positive for s-type gaussians.
+     * Therefore, |(ab|cd)| <= M1 M2 M3 M4 (s1 s2|s3 s4), and
+     *
+     * (s1 s2|s3 s4) = 2 pi^(5/2) / (gammap gammaq sqrt(gammap + gammaq))
+     *                 * exp(-a1 a2 AB2 / gammap) * exp(-a3 a4 CD2 / gammaq) * F_0(T)
+     *
+     * where F_0(T) <= 1 */
+    arb_t M1, M2, M3, M4, a1, a2, a3, a4;
+    arb_t gammap, gammaq, AB2, CD2;
+    arb_t tmp1, tmp2, result;
+    arb_ptr P  = _arb_vec_init(3);
+    arb_ptr PA = _arb_vec_init(3);
+    arb_ptr PB = _arb_vec_init(3);
+    arb_ptr Q  = _arb_vec_init(3);
+    arb_ptr QC = _arb_vec_init(3);
+    arb_ptr QD = _arb_vec_init(3);
+
+    arb_init(M1); arb_init(M2); arb_init(M3); arb_init(M4);
+    arb_init(a1); arb_init(a2); arb_init(a3); arb_init(a4);
+    arb_init(gammap);
+    arb_init(gammaq);
+    arb_init(AB2);
+    arb_init(CD2);
+    arb_init(tmp1);
+    arb_init(tmp2);
+    arb_init(result);
+
+    mirp_gtoeri_bound_prim(M1, a1, am1, alpha1, prec);
+    mirp_gtoeri_bound_prim(M2, a2, am2, alpha2, prec);
+    mirp_gtoeri_bound_prim(M3, a3, am3, alpha3, prec);
+    mirp_gtoeri_bound_prim(M4, a4, am4, alpha4, prec);
+
+    mirp_gpt(a1, a2, A, B, gammap, P, PA, PB, AB2, prec);
+    mirp_gpt(a3, a4, C, D, gammaq, Q, QC, QD, CD2, prec);
+
+    /* Exponent: -a1 a2 AB2 / gammap - a3 a4 CD2 / gammaq */
+    arb_mul(tmp1, a1, a2, prec);
+    arb_mul(tmp1, tmp1, AB2, prec);
+    arb_div(tmp1, tmp1, gammap, prec);
+    arb_mul(tmp2, a3, a4, prec);
+    arb_mul(tmp2, tmp2, CD2, prec);
+    arb_div(tmp2, tmp2, gammaq, prec);
+    arb_add(tmp1, tmp1, tmp2, prec);
+    arb_neg(tmp1, tmp1);
+    arb_exp(result, tmp1, prec);
+
+    /* 2 pi^(5/2) */
+    arb_const_pi(tmp1, prec);
+    arb_pow_ui(tmp2, tmp1, 5, prec);
+    arb_sqrt(tmp2, tmp2, prec);
+    arb_mul_2exp_si(tmp2, tmp2, 1);
+    arb_mul(result, result, tmp2, prec);
+
+    /* divide by gammap * gammaq * sqrt(gammap + gammaq) */
+    arb_add(tmp1, gammap, gammaq, prec);
+    arb_sqrt(tmp1, tmp1, prec);
+    arb_mul(tmp1, tmp1, gammap, prec);
+    arb_mul(tmp1, tmp1, gammaq, prec);
+    arb_div(result, result, tmp1, prec);
+
+    arb_mul(result, result, M1, prec);
+    arb_mul(result, result, M2, prec);
+    arb_mul(result, result, M3, prec);
+    arb_mul(result, result, M4, prec);
+
+    arb_get_mag(bound, result);
+
+    _arb_vec_clear(P,  3);
+    _arb_vec_clear(PA, 3);
+    _arb_vec_clear(PB, 3);
+    _arb_vec_clear(Q,  3);
+    _arb_vec_clear(QC, 3);
+    _arb_vec_clear(QD, 3);
+    arb_clear(M1); arb_clear(M2); arb_clear(M3); arb_clear(M4);
+    arb_clear(a1); arb_clear(a2); arb_clear(a3); arb_clear(a4);
+    arb_clear(gammap);
+    arb_clear(gammaq);
+    arb_clear(AB2);
+    arb_clear(CD2);
+    arb_clear(tmp1);
+    arb_clear(tmp2);
+    arb_clear(result);
+}
@@ -7,6 +7,7 @@
 
 #include <arb.h>
 #include "mirp/kernels/integral4_wrappers.h"
+#include "mirp/kernels/integral4_basis.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +32,33 @@ void mirp_gtoeri_single(arb_t integral,
                         slong working_prec);
 
 
+/*! \brief Computes an upper bound of the magnitude of all cartesian GTO electron
+ *         repulsion integrals of a primitive quartet
+ *
+ * The bound is rigorous, and is valid for all cartesian components of
+ * the given angular momenta. It decays with the distance between A and B
+ * (and between C and D) similarly to the gaussian product prefactor.
+ *
+ * \param [out] bound
+ *              Upper bound of the magnitude of the integrals
+ * \param [in]  am1,am2,am3,am4
+ *              Angular momentum for the four centers
+ * \param [in]  A,B,C,D
+ *              XYZ coordinates of the four centers (each of length 3)
+ * \param [in]  alpha1,alpha2,alpha3,alpha4
+ *              Exponents of the gaussian on the four centers
+ * \param [in]  working_prec
+ *              The working precision (binary digits/bits) to use
+ *              in the calculation
+ */
+void mirp_gtoeri_bound(mag_t bound,
+                       int am1, arb_srcptr A, const arb_t alpha1,
+                       int am2, arb_srcptr B, const arb_t alpha2,
+                       int am3, arb_srcptr C, const arb_t alpha3,
+                       int am4, arb_srcptr D, const arb_t alpha4,
+                       slong working_prec);
+
+
 /*******************
  * Wrappings
  *******************/
@@ -63,15 +91,43 @@ MIRP_WRAP_SINGLE4_STR(gtoeri)
 MIRP_WRAP_SINGLE4_EXACT(gtoeri)
 
 
+/*! \brief Compute a single GTO electron repulsion integral for a primitive quartet
+ *         (correctly rounded to a given format)
+ *
+ * \copydetails mirp_integral4_single_target
+ */
+MIRP_WRAP_SINGLE4_TARGET(gtoeri)
+
+
 /*! \brief Compute GTO electron repulsion integrals for a contracted
  *         shell quartet (interval arithmetic)
  *
- * \copydetails mirp_gtoeri_exact
+ * Primitive quartets that are negligible at the working precision
+ * (according to \ref mirp_gtoeri_bound) are skipped, and their
+ * contribution is added to the error bounds of the result.
+ *
+ * \param [out] integrals
+ *              Output for the computed integral
+ * \param [in]  am1,am2,am3,am4
+ *              Angular momentum for the four centers
+ * \param [in]  A,B,C,D
+ *              XYZ coordinates of the four centers (each of length 3)
+ * \param [in]  nprim1,nprim2,nprim3,nprim4
+ *              Number of primitive gaussians for each shell
+ * \param [in]  ngen1,ngen2,ngen3,ngen4
+ *              Number of general contractions for each shell
+ * \param [in]  alpha1,alpha2,alpha3,alpha4
+ *              Exponents of the primitive gaussians on the four centers
+ *              (of lengths \p nprim1, \p nprim2, \p nprim3, \p nprim4 respectively)
+ * \param [in]  coeff1,coeff2,coeff3,coeff4
+ *              Coefficients for all primitives and for all general contractions
+ *              for each shell (of lengths \p nprim1 * \p ngen1, \p nprim2 * \p ngen2,
+ *              \p nprim3 * \p ngen3, \p nprim4 * \p ngen4 respectively)
  * \param [in]  working_prec
  *              The working precision (binary digits/bits) to use
  *              in the calculation
  */
-MIRP_WRAP_SHELL4(gtoeri)
+MIRP_WRAP_SHELL4_SCREENED(gtoeri)
 
 
 /*! \brief Compute GTO electron repulsion integrals for a contracted
@@ -102,8 +158,58 @@ MIRP_WRAP_SHELL4_STR(gtoeri)
  *              Coefficients for all primitives and for all general contractions
  *              for each shell (of lengths \p nprim1 * \p ngen1, \p nprim2 * \p ngen2,
  *              \p nprim3 * \p ngen3, \p nprim4 * \p ngen4 respectively)
+ * \return The number of integrals that may not be correctly rounded
+ *         (zero if all are certified)
+ */
+MIRP_WRAP_SHELL4_EXACT_SCREENED(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for a contracted
+ *         shell quartet (correctly rounded to a given format)
+ *
+ * \copydetails mirp_integral4_target
+ */
+MIRP_WRAP_SHELL4_TARGET(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for a contracted
+ *         shell quartet (correctly rounded to a given format, unless negligible)
+ *
+ * \copydetails mirp_integral4_target_tol
+ */
+MIRP_WRAP_SHELL4_TARGET_TOL(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for all unique shell
+ *         quartets of a basis (interval arithmetic)
+ *
+ * \copydetails mirp_integral4_basis
+ */
+MIRP_WRAP_BASIS4(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for all unique shell
+ *         quartets of a basis (exact double precision)
+ *
+ * \copydetails mirp_integral4_basis_exact
+ */
+MIRP_WRAP_BASIS4_EXACT(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for a list of shell
+ *         quartets of a basis (interval arithmetic)
+ *
+ * \copydetails mirp_integral4_basis_list
+ */
+MIRP_WRAP_BASIS4_LIST(gtoeri)
+
+
+/*! \brief Compute GTO electron repulsion integrals for a list of shell
+ *         quartets of a basis (exact double precision)
+ *
+ * \copydetails mirp_integral4_basis_list_exact
  */
-MIRP_WRAP_SHELL4_EXACT(gtoeri)
+MIRP_WRAP_BASIS4_LIST_EXACT(gtoeri)
 
 
 
@@ -0,0 +1,334 @@
+/*! \file
+ *
+ * \brief Computing four-center integrals over an entire basis set
+ */
+
+#include "mirp/kernels/integral4_basis.h"
+#include "mirp/kernels/integral4_wrappers.h"
+#include "mirp/scheduler.h"
+#include <float.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/* Number of computed quartets that may be held for each thread
+ * while waiting to be passed to the sink in order */
+#define MIRP_BASIS_WINDOW_PER_THREAD 16
+
+/* Data shared by all threads */
+typedef struct
+{
+    const mirp_basis * basis;
+    double screen_threshold2;
+
+    /* Quartets to compute (4 shell indices each), or NULL for all unique quartets */
+    const int * quartets;
+
+    slong working_prec;
+    cb_integral4 cb;
+    cb_integral4_single cb_single;
+    cb_integral4_bound cb_bound;
+
+    int exact;
+    cb_integral4_sink sink;
+    cb_integral4_sink_exact sink_exact;
+    void * sink_data;
+
+    /* Number of integrals passed to the sink that may not be correctly rounded */
+    long nuncertified;
+} mirp_basis_data;
+
+
+/* Workspace for each slot of the scheduler (holds one computed quartet)
+ *
+ * The integrals are allocated for each quartet when it is computed, and
+ * freed once they have been passed to the sink.
+ */
+typedef struct
+{
+    int shells[4];
+    long nintegrals;
+    long nuncertified;
+    arb_ptr integrals;
+    double * integrals_exact;
+} mirp_basis_workspace;
+
+
+/* Splits a compound index into i >= j, where ij = i*(i+1)/2 + j */
+static void mirp_split_index(long ij, long * i, long * j)
+{
+    /* Find the largest i such that i*(i+1)/2 <= ij, one bit at a time */
+    long ii = 0;
+    long bit = 1L << 30;
+
+    while(bit > 0)
+    {
+        if((ii + bit) * (ii + bit + 1) / 2 <= ij)
+            ii += bit;
+        bit >>= 1;
+    }
+
+    *i = ii;
+    *j = ij - ii*(ii+1)/2;
+}
+
+
+/* Computes a shell quartet using interval arithmetic */
+static void mirp_basis_compute(const mirp_basis * b, const int * idx,
+                               arb_ptr integrals, slong working_prec, cb_integral4 cb)
+{
+    const int i = idx[0], j = idx[1], k = idx[2], l = idx[3];
+
+    cb(integrals,
+       b->am[i], b->xyz_arb + 3*i, b->nprim[i], b->ngeneral[i],
+       b->alpha_arb + b->prim_start[i], b->coeff_arb + b->coeff_start[i],
+       b->am[j], b->xyz_arb + 3*j, b->nprim[j], b->ngeneral[j],
+       b->alpha_arb + b->prim_start[j], b->coeff_arb + b->coeff_start[j],
+       b->am[k], b->xyz_arb + 3*k, b->nprim[k], b->ngeneral[k],
+       b->alpha_arb + b->prim_start[k], b->coeff_arb + b->coeff_start[k],
+       b->am[l], b->xyz_arb + 3*l, b->nprim[l], b->ngeneral[l],
+       b->alpha_arb + b->prim_start[l], b->coeff_arb + b->coeff_start[l],
+       working_prec);
+}
+
+
+/* Computes a shell quartet to exact double precision
+ *
+ * Returns the number of integrals that may not be correctly rounded.
+ */
+static long mirp_basis_compute_exact(const mirp_basis * b, const int * idx, double * integrals,
+                                     cb_integral4_single cb, cb_integral4_bound cb_bound)
+{
+    const int i = idx[0], j = idx[1], k = idx[2], l = idx[3];
+
+    return mirp_integral4_exact_screened(integrals,
+                                         b->am[i], b->xyz + 3*i, b->nprim[i], b->ngeneral[i],
+                                         b->alpha + b->prim_start[i], b->coeff + b->coeff_start[i],
+                                         b->am[j], b->xyz + 3*j, b->nprim[j], b->ngeneral[j],
+                                         b->alpha + b->prim_start[j], b->coeff + b->coeff_start[j],
+                                         b->am[k], b->xyz + 3*k, b->nprim[k], b->ngeneral[k],
+                                         b->alpha + b->prim_start[k], b->coeff + b->coeff_start[k],
+                                         b->am[l], b->xyz + 3*l, b->nprim[l], b->ngeneral[l],
+                                         b->alpha + b->prim_start[l], b->coeff + b->coeff_start[l],
+                                         cb, cb_bound);
+}
+
+
+static void * mirp_basis_ws_init(void * data)
+{
+    mirp_basis_workspace * ws = (mirp_basis_workspace *)malloc(sizeof(mirp_basis_workspace));
+    ws->nintegrals = 0;
+    ws->nuncertified = 0;
+    ws->integrals = NULL;
+    ws->integrals_exact = NULL;
+
+    (void)data;
+    return ws;
+}
+
+
+/* Frees the integrals of the quartet held by a workspace */
+static void mirp_basis_ws_release(mirp_basis_workspace * ws)
+{
+    if(ws->integrals)
+        _arb_vec_clear(ws->integrals, ws->nintegrals);
+    free(ws->integrals_exact);
+
+    ws->integrals = NULL;
+    ws->integrals_exact = NULL;
+}
+
+
+static void mirp_basis_ws_clear(void * workspace, void * data)
+{
+    mirp_basis_workspace * ws = (mirp_basis_workspace *)workspace;
+    mirp_basis_ws_release(ws);
+    free(ws);
+
+    (void)data;
+}
+
+
+/* Computes a single shell quartet
+ *
+ * Without a list of quartets, task t is the pair of shell pairs t = pq*(pq+1)/2 + rs.
+ */
+static void mirp_basis_quartet_task(long t, void * workspace, void * data)
+{
+    const mirp_basis_data * d = (const mirp_basis_data *)data;
+    const mirp_basis * b = d->basis;
+    mirp_basis_workspace * ws = (mirp_basis_workspace *)workspace;
+
+    if(d->quartets)
+    {
+        for(int n = 0; n < 4; n++)
+            ws->shells[n] = d->quartets[4*t+n];
+    }
+    else
+    {
+        long p, q;
+        mirp_split_index(t, &p, &q);
+
+        ws->shells[0] = b->pair_shells[2*p];
+        ws->shells[1] = b->pair_shells[2*p+1];
+        ws->shells[2] = b->pair_shells[2*q];
+        ws->shells[3] = b->pair_shells[2*q+1];
+
+        /* Schwarz screening: |(ij|kl)| <= sqrt(|(ij|ij)|) * sqrt(|(kl|kl)|).
+         * The extra factor accounts for rounding in the product */
+        if(b->screen_threshold > 0.0)
+        {
+            const double bound = b->pair_bound[p] * b->pair_bound[q] * (1.0 + 4.0*DBL_EPSILON);
+            if(bound < d->screen_threshold2)
+                return;
+        }
+    }
+
+    ws->nintegrals = mirp_basis_nfunction(b, ws->shells[0]) * mirp_basis_nfunction(b, ws->shells[1])
+                   * mirp_basis_nfunction(b, ws->shells[2]) * mirp_basis_nfunction(b, ws->shells[3]);
+
+    if(d->exact)
+    {
+        ws->integrals_exact = (double *)malloc((size_t)ws->nintegrals * sizeof(double));
+        ws->nuncertified = mirp_basis_compute_exact(b, ws->shells, ws->integrals_exact,
+                                                    d->cb_single, d->cb_bound);
+    }
+    else
+    {
+        ws->integrals = _arb_vec_init(ws->nintegrals);
+        mirp_basis_compute(b, ws->shells, ws->integrals, d->working_prec, d->cb);
+    }
+}
+
+
+/* Hands a computed quartet to the sink (called in quartet order) */
+static int mirp_basis_quartet_complete(long t, void * workspace, void * data)
+{
+    mirp_basis_data * d = (mirp_basis_data *)data;
+    mirp_basis_workspace * ws = (mirp_basis_workspace *)workspace;
+    int stop = 0;
+    (void)t;
+
+    /* Screened quartets were not computed */
+    if(ws->integrals_exact)
+    {
+        d->nuncertified += ws->nuncertified;
+        stop = d->sink_exact(ws->shells, ws->integrals_exact, ws->nintegrals, d->sink_data);
+    }
+    else if(ws->integrals)
+        stop = d->sink(ws->shells, ws->integrals, ws->nintegrals, d->sink_data);
+
+    mirp_basis_ws_release(ws);
+    return stop;
+}
+
+
+/* Common driver for the interval and exact versions
+ *
+ * If d->quartets is NULL, all unique quartets of the pair list are computed.
+ */
+static void mirp_integral4_basis_common(mirp_basis_data * d, long nquartet, int nthreads)
+{
+    const mirp_basis * b = d->basis;
+    d->screen_threshold2 = b->screen_threshold * b->screen_threshold;
+
+    /* All pairs of (significant) shell pairs */
+    if(d->quartets == NULL)
+        nquartet = (b->npair * (b->npair+1))/2;
+
+    const long window = MIRP_BASIS_WINDOW_PER_THREAD * mirp_scheduler_nthreads(nthreads);
+
+    mirp_scheduler_run_ordered(nquartet, nthreads, window,
+                               mirp_basis_ws_init, mirp_basis_ws_clear,
+                               mirp_basis_quartet_task, mirp_basis_quartet_complete, d);
+}
+
+
+/* Sets up the shared data for the interval version */
+static void mirp_basis_data_init(mirp_basis_data * d, const mirp_basis * basis,
+                                 const int * quartets, slong working_prec, cb_integral4 cb,
+                                 cb_integral4_sink sink, void * sink_data)
+{
+    assert(sink != NULL);
+
+    d->basis = basis;
+    d->quartets = quartets;
+    d->working_prec = working_prec;
+    d->cb = cb;
+    d->cb_single = NULL;
+    d->cb_bound = NULL;
+    d->exact = 0;
+    d->sink = sink;
+    d->sink_exact = NULL;
+    d->sink_data = sink_data;
+    d->nuncertified = 0;
+}
+
+
+/* Sets up the shared data for the exact version */
+static void mirp_basis_data_init_exact(mirp_basis_data * d, const mirp_basis * basis,
+                                       const int * quartets,
+                                       cb_integral4_single cb, cb_integral4_bound cb_bound,
+                                       cb_integral4_sink_exact sink, void * sink_data)
+{
+    assert(sink != NULL);
+
+    d->basis = basis;
+    d->quartets = quartets;
+    d->working_prec = 0;
+    d->cb = NULL;
+    d->cb_single = cb;
+    d->cb_bound = cb_bound;
+    d->exact = 1;
+    d->sink = NULL;
+    d->sink_exact = sink;
+    d->sink_data = sink_data;
+    d->nuncertified = 0;
+}
+
+
+void mirp_integral4_basis(const mirp_basis * basis, int nthreads,
+                          slong working_prec, cb_integral4 cb,
+                          cb_integral4_sink sink, void * sink_data)
+{
+    mirp_basis_data d;
+    mirp_basis_data_init(&d, basis, NULL, working_prec, cb, sink, sink_data);
+    mirp_integral4_basis_common(&d, 0, nthreads);
+}
+
+
+long mirp_integral4_basis_exact(const mirp_basis * basis, int nthreads,
+                                cb_integral4_single cb, cb_integral4_bound cb_bound,
+                                cb_integral4_sink_exact sink, void * sink_data)
+{
+    mirp_basis_data d;
+    mirp_basis_data_init_exact(&d, basis, NULL, cb, cb_bound, sink, sink_data);
+    mirp_integral4_basis_common(&d, 0, nthreads);
+    return d.nuncertified;
+}
+
+
+void mirp_integral4_basis_list(const mirp_basis * basis,
+                               long nquartet, const int * quartets, int nthreads,
+                               slong working_prec, cb_integral4 cb,
+                               cb_integral4_sink sink, void * sink_data)
+{
+    assert(nquartet == 0 || quartets != NULL);
+
+    mirp_basis_data d;
+    mirp_basis_data_init(&d, basis, quartets, working_prec, cb, sink, sink_data);
+    mirp_integral4_basis_common(&d, nquartet, nthreads);
+}
+
+
+long mirp_integral4_basis_list_exact(const mirp_basis * basis,
+                                     long nquartet, const int * quartets, int nthreads,
+                                     cb_integral4_single cb, cb_integral4_bound cb_bound,
+                                     cb_integral4_sink_exact sink, void * sink_data)
+{
+    assert(nquartet == 0 || quartets != NULL);
+
+    mirp_basis_data d;
+    mirp_basis_data_init_exact(&d, basis, quartets, cb, cb_bound, sink, sink_data);
+    mirp_integral4_basis_common(&d, nquartet, nthreads);
+    return d.nuncertified;
+}
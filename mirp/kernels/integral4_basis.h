@@ -0,0 +1,210 @@
+/*! \file
+ *
+ * \brief Computing four-center integrals over an entire basis set
+ */
+
+#pragma once
+
+#include "mirp/typedefs.h"
+#include "mirp/basis.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! \brief Compute all unique shell quartets of a basis (four-center, interval arithmetic)
+ *
+ * All quartets (ij|kl) formed from pairs ij >= kl of the shell pair list of \p basis
+ * are computed and handed to \p sink, one quartet at a time, in that order.
+ * For a basis that has not been screened, this is all quartets with i >= j, k >= l,
+ * and ij >= kl (compound indices).
+ * The integrals for each quartet are laid out the same way as for \ref mirp_integral4.
+ * The sink is never called concurrently, and the integrals passed to it are only valid
+ * for the duration of the call. If the sink returns nonzero, the calculation stops
+ * and no further quartets are passed to it.
+ *
+ * Quartets are distributed over threads via \ref mirp_scheduler_run_ordered.
+ * The sink may be called from any thread. Memory for the integrals is allocated
+ * for each quartet, and at most a few quartets per thread are held at once.
+ *
+ * If the basis has been screened with \ref mirp_basis_screen, quartets are also screened
+ * using the Schwarz inequality. Quartets where all integrals are guaranteed to have a
+ * magnitude smaller than the screening threshold are not computed and are not passed to the sink.
+ *
+ * \param [in] basis            The basis set
+ * \param [in] nthreads         Number of threads to use (0 for the default)
+ * \param [in] working_prec     The working precision (binary digits/bits) to use
+ *                              in the calculation
+ * \param [in] cb               Function that computes all cartesian integrals of a
+ *                              contracted shell quartet using interval arithmetic
+ * \param [in] sink             Function that receives the integrals of each quartet
+ * \param [in] sink_data        Arbitrary data passed to \p sink
+ */
+void mirp_integral4_basis(const mirp_basis * basis, int nthreads,
+                          slong working_prec, cb_integral4 cb,
+                          cb_integral4_sink sink, void * sink_data);
+
+
+/*! \brief Compute all unique shell quartets of a basis to exact double precision (four-center)
+ *
+ * This is the same as \ref mirp_integral4_basis, except that the integrals for each
+ * quartet are computed with \ref mirp_integral4_exact_screened (so that primitive
+ * screening, masking of converged components, and early abandonment are used).
+ *
+ * \param [in] basis            The basis set
+ * \param [in] nthreads         Number of threads to use (0 for the default)
+ * \param [in] cb               Function that computes a single cartesian integral
+ *                              with interval arithmetic
+ * \param [in] cb_bound         Function that computes an upper bound of the magnitude of
+ *                              all cartesian integrals of a primitive quartet (may be NULL)
+ * \param [in] sink             Function that receives the integrals of each quartet
+ * \param [in] sink_data        Arbitrary data passed to \p sink
+ * \return The number of integrals passed to \p sink that may not be correctly rounded
+ *         (see \ref mirp_integral4_exact_screened)
+ */
+long mirp_integral4_basis_exact(const mirp_basis * basis, int nthreads,
+                                cb_integral4_single cb, cb_integral4_bound cb_bound,
+                                cb_integral4_sink_exact sink, void * sink_data);
+
+
+/*! \brief Compute a list of shell quartets of a basis (four-center, interval arithmetic)
+ *
+ * This is the same as \ref mirp_integral4_basis, except that only the quartets
+ * in \p quartets are computed (and passed to \p sink in that order).
+ * These quartets are not screened.
+ *
+ * \param [in] basis            The basis set
+ * \param [in] nquartet         Number of quartets in \p quartets
+ * \param [in] quartets         Indices of the shells of each quartet (length 4 * \p nquartet)
+ * \param [in] nthreads         Number of threads to use (0 for the default)
+ * \param [in] working_prec     The working precision (binary digits/bits) to use
+ *                              in the calculation
+ * \param [in] cb               Function that computes all cartesian integrals of a
+ *                              contracted shell quartet using interval arithmetic
+ * \param [in] sink             Function that receives the integrals of each quartet
+ * \param [in] sink_data        Arbitrary data passed to \p sink
+ */
+void mirp_integral4_basis_list(const mirp_basis * basis,
+                               long nquartet, const int * quartets, int nthreads,
+                               slong working_prec, cb_integral4 cb,
+                               cb_integral4_sink sink, void * sink_data);
+
+
+/*! \brief Compute a list of shell quartets of a basis to exact double precision (four-center)
+ *
+ * This is the same as \ref mirp_integral4_basis_exact, except that only the quartets
+ * in \p quartets are computed (and passed to \p sink in that order).
+ * These quartets are not screened with the Schwarz inequality.
+ *
+ * \param [in] basis            The basis set
+ * \param [in] nquartet         Number of quartets in \p quartets
+ * \param [in] quartets         Indices of the shells of each quartet (length 4 * \p nquartet)
+ * \param [in] nthreads         Number of threads to use (0 for the default)
+ * \param [in] cb               Function that computes a single cartesian integral
+ *                              with interval arithmetic
+ * \param [in] cb_bound         Function that computes an upper bound of the magnitude of
+ *                              all cartesian integrals of a primitive quartet (may be NULL)
+ * \param [in] sink             Function that receives the integrals of each quartet
+ * \param [in] sink_data        Arbitrary data passed to \p sink
+ * \return The number of integrals passed to \p sink that may not be correctly rounded
+ *         (see \ref mirp_integral4_exact_screened)
+ */
+long mirp_integral4_basis_list_exact(const mirp_basis * basis,
+                                     long nquartet, const int * quartets, int nthreads,
+                                     cb_integral4_single cb, cb_integral4_bound cb_bound,
+                                     cb_integral4_sink_exact sink, void * sink_data);
+
+
+/*! \brief Create a function that computes all unique shell quartets of a basis
+ *         (four-center, interval arithmetic)
+ *
+ *  A function computing all cartesian integrals of a contracted shell quartet
+ *  in interval arithmetic is expected to exist and be named `mirp_{name}`
+ *
+ *  The created function is named `mirp_{name}_basis`.
+ *
+ *  \sa mirp_integral4_basis
+ */
+#define MIRP_WRAP_BASIS4(name) \
+    static inline \
+    void mirp_##name##_basis(const mirp_basis * basis, int nthreads, \
+                             slong working_prec, \
+                             cb_integral4_sink sink, void * sink_data) \
+    { \
+        mirp_integral4_basis(basis, nthreads, \
+                             working_prec, mirp_##name, sink, sink_data); \
+    }
+
+
+/*! \brief Create a function that computes all unique shell quartets of a basis
+ *         to exact double precision (four-center)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}_basis_exact`.
+ *
+ *  \sa mirp_integral4_basis_exact
+ */
+#define MIRP_WRAP_BASIS4_EXACT(name) \
+    static inline \
+    long mirp_##name##_basis_exact(const mirp_basis * basis, int nthreads, \
+                                   cb_integral4_sink_exact sink, void * sink_data) \
+    { \
+        return mirp_integral4_basis_exact(basis, nthreads, \
+                                          mirp_##name##_single, mirp_##name##_bound, \
+                                          sink, sink_data); \
+    }
+
+
+/*! \brief Create a function that computes a list of shell quartets of a basis
+ *         (four-center, interval arithmetic)
+ *
+ *  A function computing all cartesian integrals of a contracted shell quartet
+ *  in interval arithmetic is expected to exist and be named `mirp_{name}`
+ *
+ *  The created function is named `mirp_{name}_basis_list`.
+ *
+ *  \sa mirp_integral4_basis_list
+ */
+#define MIRP_WRAP_BASIS4_LIST(name) \
+    static inline \
+    void mirp_##name##_basis_list(const mirp_basis * basis, \
+                                  long nquartet, const int * quartets, int nthreads, \
+                                  slong working_prec, \
+                                  cb_integral4_sink sink, void * sink_data) \
+    { \
+        mirp_integral4_basis_list(basis, nquartet, quartets, nthreads, \
+                                  working_prec, mirp_##name, sink, sink_data); \
+    }
+
+
+/*! \brief Create a function that computes a list of shell quartets of a basis
+ *         to exact double precision (four-center)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}_basis_list_exact`.
+ *
+ *  \sa mirp_integral4_basis_list_exact
+ */
+#define MIRP_WRAP_BASIS4_LIST_EXACT(name) \
+    static inline \
+    long mirp_##name##_basis_list_exact(const mirp_basis * basis, \
+                                        long nquartet, const int * quartets, int nthreads, \
+                                        cb_integral4_sink_exact sink, void * sink_data) \
+    { \
+        return mirp_integral4_basis_list_exact(basis, nquartet, quartets, nthreads, \
+                                               mirp_##name##_single, mirp_##name##_bound, \
+                                               sink, sink_data); \
+    }
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -3,83 +3,339 @@
  * \brief Some useful wrapping of functionality
  */
 
-#include "mirp/pragma.h"
 #include "mirp/math.h"
 #include "mirp/shell.h"
+#include "mirp/runtime.h"
 #include "mirp/kernels/boys.h"
 #include "mirp/kernels/integral4_wrappers.h"
-#include <string.h> /* for memset */
+#include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 
+/*! \brief Maximum number of primitive integrals computed at once by mirp_integral4 */
+#define MIRP_INTEGRAL4_BATCH_SIZE 4096
 
+/*! \brief Minimum number of times the radius is checked when abandoning integrals
+ *         that cannot reach the target accuracy */
+#define MIRP_INTEGRAL4_NCHECK 8
 
-/*! \brief Compute all cartesian components of a single primitive integral
- *         (interval arithmetic)
- *
- * The \p integral buffer is expected to be able to hold all primitive integrals
- * (ie, it can hold ncart(am1) * ncart(am2) * ncart(am3) * ncart(am4) elements).
+
+
+/* Determines which primitive quartets of a contracted quartet need to be computed
  *
- * \param [out] integrals
- *              Resulting integral integral
- * \param [in]  am1,am2,am3,am4
- *              Angular momentum of the four centers
- * \param [in]  A,B,C,D
- *              XYZ coordinates of the four centers (each of length 3)
- * \param [in]  alpha1,alpha2,alpha3,alpha4
- *              Exponents of the gaussian on the four centers
- * \param [in]  cb
- *              Callback that calculates a single cartesian component of a
- *              primitive integral
- * \param [in] working_prec The working precision (binary digits/bits) to use in the calculation
+ * The indices of primitive quartets to compute are stored (in order) in prim_list,
+ * and the number of them is returned. The sum of the bounds of all the
+ * skipped primitive quartets is stored in skipped. The sum of the bounds of all
+ * primitive quartets (an upper bound for the magnitude of any contracted integral)
+ * is stored in total, which is infinite if cb_bound is NULL.
  */
-static void mirp_cartloop4(arb_ptr integrals,
-                           int am1, arb_srcptr A, const arb_t alpha1,
-                           int am2, arb_srcptr B, const arb_t alpha2,
-                           int am3, arb_srcptr C, const arb_t alpha3,
-                           int am4, arb_srcptr D, const arb_t alpha4,
-                           slong working_prec, cb_integral4_single cb)
+static long mirp_integral4_screen_prim(long * prim_list, mag_t skipped, mag_t total,
+                                       int am1, arb_srcptr A, int nprim1, arb_srcptr alpha1,
+                                       int am2, arb_srcptr B, int nprim2, arb_srcptr alpha2,
+                                       int am3, arb_srcptr C, int nprim3, arb_srcptr alpha3,
+                                       int am4, arb_srcptr D, int nprim4, arb_srcptr alpha4,
+                                       arb_srcptr coeff12, long ngen12,
+                                       arb_srcptr coeff34, long ngen34,
+                                       slong working_prec, cb_integral4_bound cb_bound)
 {
-    assert(am1 >= 0);
-    assert(am2 >= 0);
-    assert(am3 >= 0);
-    assert(am4 >= 0);
+    const long nprim12 = (long)nprim1*nprim2;
+    const long nprim34 = (long)nprim3*nprim4;
+    const long nprim1234 = nprim12*nprim34;
 
-    const long ncart1 = MIRP_NCART(am1);
-    const long ncart2 = MIRP_NCART(am2);
-    const long ncart3 = MIRP_NCART(am3);
-    const long ncart4 = MIRP_NCART(am4);
+    mag_zero(skipped);
+    mag_zero(total);
 
-    int lmn1[ncart1][3];
-    int lmn2[ncart2][3];
-    int lmn3[ncart3][3];
-    int lmn4[ncart4][3];
+    if(cb_bound == NULL)
+    {
+        mag_inf(total);
+        for(long pq = 0; pq < nprim1234; pq++)
+            prim_list[pq] = pq;
+        return nprim1234;
+    }
 
-    mirp_gaussian_fill_lmn(am1, (int*)lmn1);
-    mirp_gaussian_fill_lmn(am2, (int*)lmn2);
-    mirp_gaussian_fill_lmn(am3, (int*)lmn3);
-    mirp_gaussian_fill_lmn(am4, (int*)lmn4);
+    /* Largest magnitude of the coefficient products of each primitive pair
+     * (over all general contractions) */
+    mag_ptr cmax12 = (mag_ptr)malloc((size_t)nprim12 * sizeof(mag_struct));
+    mag_ptr cmax34 = (mag_ptr)malloc((size_t)nprim34 * sizeof(mag_struct));
+    mag_ptr bounds = (mag_ptr)malloc((size_t)nprim1234 * sizeof(mag_struct));
+
+    mag_t tmp, max_bound;
+    mag_init(tmp);
+    mag_init(max_bound);
+
+    for(long ij = 0; ij < nprim12; ij++)
+    {
+        mag_init(cmax12 + ij);
+        for(long mn = 0; mn < ngen12; mn++)
+        {
+            arb_get_mag(tmp, coeff12 + ij*ngen12 + mn);
+            mag_max(cmax12 + ij, cmax12 + ij, tmp);
+        }
+    }
+
+    for(long kl = 0; kl < nprim34; kl++)
+    {
+        mag_init(cmax34 + kl);
+        for(long op = 0; op < ngen34; op++)
+        {
+            arb_get_mag(tmp, coeff34 + kl*ngen34 + op);
+            mag_max(cmax34 + kl, cmax34 + kl, tmp);
+        }
+    }
+
+    for(long pq = 0; pq < nprim1234; pq++)
+    {
+        const long ij = pq / nprim34;
+        const long kl = pq % nprim34;
+        const long i = ij / nprim2;
+        const long j = ij % nprim2;
+        const long k = kl / nprim4;
+        const long l = kl % nprim4;
+
+        mag_init(bounds + pq);
+        cb_bound(bounds + pq,
+                 am1, A, alpha1 + i,
+                 am2, B, alpha2 + j,
+                 am3, C, alpha3 + k,
+                 am4, D, alpha4 + l,
+                 working_prec);
+
+        mag_mul(bounds + pq, bounds + pq, cmax12 + ij);
+        mag_mul(bounds + pq, bounds + pq, cmax34 + kl);
+        mag_max(max_bound, max_bound, bounds + pq);
+        mag_add(total, total, bounds + pq);
+    }
+
+    /* Anything smaller than this is below the precision of the
+     * largest contribution */
+    mag_mul_2exp_si(max_bound, max_bound, -working_prec);
+
+    long nkept = 0;
+    for(long pq = 0; pq < nprim1234; pq++)
+    {
+        if(mag_cmp(bounds + pq, max_bound) < 0)
+            mag_add(skipped, skipped, bounds + pq);
+        else
+            prim_list[nkept++] = pq;
+
+        mag_clear(bounds + pq);
+    }
+
+    for(long ij = 0; ij < nprim12; ij++)
+        mag_clear(cmax12 + ij);
+    for(long kl = 0; kl < nprim34; kl++)
+        mag_clear(cmax34 + kl);
+
+    free(cmax12);
+    free(cmax34);
+    free(bounds);
+    mag_clear(tmp);
+    mag_clear(max_bound);
+
+    return nkept;
+}
+
+
+/* Determines which cartesian components are needed for any general contraction
+ *
+ * Returns the number of needed components.
+ */
+static long mirp_integral4_cart_mask(char * cart_mask, const char * active,
+                                     long ngen, long ncart)
+{
+    long nactive = 0;
+
+    for(long q = 0; q < ncart; q++)
+    {
+        cart_mask[q] = 0;
+        for(long g = 0; g < ngen; g++)
+            cart_mask[q] |= active[g*ncart + q];
+        nactive += cart_mask[q];
+    }
+
+    return nactive;
+}
 
 
+/* Computes all integrals of a contracted quartet with general contractions
+ *
+ * The primitive-to-contracted transformation is done as four successive one-index
+ * transformations. For each primitive of the first shell, all primitive integrals
+ * for a primitive of the second shell are computed and transformed (via dot products)
+ * over the fourth and then third shells. After all primitives of the second shell,
+ * the second index is transformed, and the result is added to the output
+ * for each contraction of the first shell.
+ *
+ * The coefficients must be normalized. Primitive quartets for which
+ * prim_mask is zero are not computed (and are treated as zero). If mask is not NULL,
+ * only the integrals for which mask is nonzero are computed, and the rest
+ * of the output is not touched.
+ *
+ * If doom is not NULL, integrals whose radius exceeds doom after the contribution
+ * of a primitive of the first shell are abandoned (see mirp_integral4_masked).
+ */
+static void mirp_integral4_general(arb_ptr integrals,
+                                   const int * lmn1, arb_srcptr A, int nprim1, int ngen1, arb_srcptr alpha1, arb_srcptr coeff1,
+                                   const int * lmn2, arb_srcptr B, int nprim2, int ngen2, arb_srcptr alpha2, arb_srcptr coeff2,
+                                   const int * lmn3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3,
+                                   const int * lmn4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4,
+                                   long ncart2, long ncart3, long ncart4, long ncart1234,
+                                   const char * prim_mask, const char * mask, mag_srcptr doom,
+                                   slong working_prec, cb_integral4_single cb)
+{
+    const long ncart = ncart1234;
+    const long nprim34 = (long)nprim3*nprim4;
+    const long ngen34 = (long)ngen3*ngen4;
+    const long ngen234 = ngen2*ngen34;
+    const long full_size = ngen1*ngen234*ncart;
+
+    /* Buffers for each stage of the transformation
+     *   prim:  [k][l][q] primitive integrals for the current i, j
+     *   half1: [k][p][q] after transforming the fourth index
+     *   half2: [j][o][p][q] after transforming the third index
+     *   half3: [n][o][p][q] after transforming the second index
+     */
+    const long nprim_buf = nprim34*ncart;
+    const long nhalf1 = nprim3*ngen4*ncart;
+    const long nhalf2 = nprim2*ngen34*ncart;
+    const long nhalf3 = ngen234*ncart;
+    const long nbuf = nprim_buf + nhalf1 + nhalf2 + nhalf3;
+
+    /* Integrals that are still being computed */
+    char * active = (char *)malloc((size_t)full_size);
+    for(long x = 0; x < full_size; x++)
+        active[x] = (mask == NULL || mask[x]);
+
+    /* Cartesian components that are needed for any general contraction */
+    char * cart_mask = (char *)malloc((size_t)ncart);
+    long nactive = mirp_integral4_cart_mask(cart_mask, active, ngen1*ngen234, ncart);
+
+    arb_ptr buf = mirp_workspace_get(nbuf);
+    arb_ptr prim = buf;
+    arb_ptr half1 = prim + nprim_buf;
+    arb_ptr half2 = half1 + nhalf1;
+    arb_ptr half3 = half2 + nhalf2;
+
+    /* Each element of each buffer (and of the output) is computed by a single
+     * thread, in a fixed order, so the results do not depend on the number of threads */
     #ifdef _OPENMP
-    #pragma omp parallel for collapse(4)
+    #pragma omp parallel num_threads(mirp_num_threads())
     #endif
-    for(long i = 0; i < ncart1; i++)
-    for(long j = 0; j < ncart2; j++)
-    for(long k = 0; k < ncart3; k++)
-    for(long l = 0; l < ncart4; l++)
+    for(long i = 0; i < nprim1 && nactive > 0; i++)
     {
-        const long idx = i*ncart4*ncart3*ncart2
-                       + j*ncart4*ncart3
-                       + k*ncart4
-                       + l;
-
-        cb(integrals + idx,
-           lmn1[i], A, alpha1,
-           lmn2[j], B, alpha2,
-           lmn3[k], C, alpha3,
-           lmn4[l], D, alpha4,
-           working_prec);
+        for(long j = 0; j < nprim2; j++)
+        {
+            const long ij = i*nprim2 + j;
+
+            #ifdef _OPENMP
+            #pragma omp for schedule(dynamic)
+            #endif
+            for(long w = 0; w < nprim_buf; w++)
+            {
+                const long kl = w / ncart;
+                const long q = w % ncart;
+
+                if(!cart_mask[q] || !prim_mask[ij*nprim34 + kl])
+                {
+                    arb_zero(prim + w);
+                    continue;
+                }
+
+                const long k = kl / nprim4;
+                const long l = kl % nprim4;
+                const long ci = q / (ncart2*ncart3*ncart4);
+                const long cj = (q / (ncart3*ncart4)) % ncart2;
+                const long ck = (q / ncart4) % ncart3;
+                const long cl = q % ncart4;
+
+                cb(prim + w,
+                   lmn1 + 3*ci, A, alpha1 + i,
+                   lmn2 + 3*cj, B, alpha2 + j,
+                   lmn3 + 3*ck, C, alpha3 + k,
+                   lmn4 + 3*cl, D, alpha4 + l,
+                   working_prec);
+            }
+
+            /* Fourth index: half1[k][p][q] = sum_l coeff4[p][l] * prim[k][l][q] */
+            #ifdef _OPENMP
+            #pragma omp for schedule(static)
+            #endif
+            for(long w = 0; w < nhalf1; w++)
+            {
+                const long k = w / (ngen4*ncart);
+                const long p = (w / ncart) % ngen4;
+                const long q = w % ncart;
+
+                arb_dot(half1 + w, NULL, 0,
+                        prim + k*nprim4*ncart + q, ncart,
+                        coeff4 + p*nprim4, 1,
+                        nprim4, working_prec);
+            }
+
+            /* Third index: half2[j][o][p][q] = sum_k coeff3[o][k] * half1[k][p][q] */
+            #ifdef _OPENMP
+            #pragma omp for schedule(static)
+            #endif
+            for(long w = 0; w < ngen34*ncart; w++)
+            {
+                const long o = w / (ngen4*ncart);
+                const long pq = w % (ngen4*ncart);
+
+                arb_dot(half2 + j*ngen34*ncart + w, NULL, 0,
+                        half1 + pq, ngen4*ncart,
+                        coeff3 + o*nprim3, 1,
+                        nprim3, working_prec);
+            }
+        }
+
+        /* Second index: half3[n][o][p][q] = sum_j coeff2[n][j] * half2[j][o][p][q] */
+        #ifdef _OPENMP
+        #pragma omp for schedule(static)
+        #endif
+        for(long w = 0; w < nhalf3; w++)
+        {
+            const long n = w / (ngen34*ncart);
+            const long opq = w % (ngen34*ncart);
+
+            arb_dot(half3 + w, NULL, 0,
+                    half2 + opq, ngen34*ncart,
+                    coeff2 + n*nprim2, 1,
+                    nprim2, working_prec);
+        }
+
+        /* First index: integrals[m][n][o][p][q] += coeff1[m][i] * half3[n][o][p][q] */
+        #ifdef _OPENMP
+        #pragma omp for schedule(static)
+        #endif
+        for(long x = 0; x < full_size; x++)
+        {
+            const long m = x / nhalf3;
+            const long nopq = x % nhalf3;
+
+            if(!active[x])
+                continue;
+
+            arb_addmul(integrals + x, half3 + nopq, coeff1 + m*nprim1 + i, working_prec);
+
+            if(doom && mag_cmp(arb_radref(integrals + x), doom) > 0)
+            {
+                arb_indeterminate(integrals + x);
+                active[x] = 0;
+            }
+        }
+
+        if(doom)
+        {
+            #ifdef _OPENMP
+            #pragma omp single
+            #endif
+            nactive = mirp_integral4_cart_mask(cart_mask, active, ngen1*ngen234, ncart);
+        }
     }
+
+    mirp_workspace_release(buf, nbuf);
+    free(cart_mask);
+    free(active);
 }
 
 
@@ -89,17 +345,68 @@ void mirp_integral4(arb_ptr integrals,
                     int am3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3,
                     int am4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4,
                     slong working_prec, cb_integral4_single cb)
+{
+    mirp_integral4_screened(integrals,
+                            am1, A, nprim1, ngen1, alpha1, coeff1,
+                            am2, B, nprim2, ngen2, alpha2, coeff2,
+                            am3, C, nprim3, ngen3, alpha3, coeff3,
+                            am4, D, nprim4, ngen4, alpha4, coeff4,
+                            working_prec, cb, NULL);
+}
+
+
+/* Computes a contracted shell quartet, with primitive screening
+ *
+ * If mask is not NULL, only the integrals for which mask is nonzero are computed,
+ * and the rest of the output is not touched.
+ *
+ * If target is not NULL (and cb_bound is given), integrals that can no longer
+ * be certified for that format at this working precision are abandoned
+ * part way through, and set to indeterminate. The radius of a sum can only grow,
+ * and the magnitude of the integral is at most the sum of the bounds of all
+ * primitive quartets. Once the radius is larger than that sum times 2^(2-p)
+ * (with p bits in the significand of the format) and larger than the smallest
+ * value of the format, the ends of the final result cannot round to the same value.
+ * If tol is not NULL, integrals are also not abandoned while their radius is
+ * within tol, since they may still be negligible (see mirp_format_negligible).
+ *
+ * The sum of the bounds of the skipped primitive quartets (which is added to the
+ * radius of every computed integral) is stored in skipped_out, if not NULL.
+ */
+static void mirp_integral4_masked(arb_ptr integrals,
+                                  int am1, arb_srcptr A, int nprim1, int ngen1, arb_srcptr alpha1, arb_srcptr coeff1,
+                                  int am2, arb_srcptr B, int nprim2, int ngen2, arb_srcptr alpha2, arb_srcptr coeff2,
+                                  int am3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3,
+                                  int am4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4,
+                                  const char * mask, const mirp_format * target, mag_srcptr tol, mag_ptr skipped_out,
+                                  slong working_prec, cb_integral4_single cb, cb_integral4_bound cb_bound)
 {
     assert(am1 >= 0); assert(nprim1 > 0); assert(ngen1 > 0);
     assert(am2 >= 0); assert(nprim2 > 0); assert(ngen2 > 0);
     assert(am3 >= 0); assert(nprim3 > 0); assert(ngen3 > 0);
     assert(am4 >= 0); assert(nprim4 > 0); assert(ngen4 > 0);
 
-    const long ncart1234 = MIRP_NCART4(am1, am2, am3, am4);
-    const long ngen1234 = ngen1*ngen2*ngen3*ngen4;
+    const long ncart1 = MIRP_NCART(am1);
+    const long ncart2 = MIRP_NCART(am2);
+    const long ncart3 = MIRP_NCART(am3);
+    const long ncart4 = MIRP_NCART(am4);
+    const long ncart1234 = ncart1*ncart2*ncart3*ncart4;
+    const long nprim1234 = (long)nprim1*nprim2*nprim3*nprim4;
+    const long ngen1234 = (long)ngen1*ngen2*ngen3*ngen4;
+    const long ngen12 = (long)ngen1*ngen2;
+    const long ngen34 = (long)ngen3*ngen4;
     const long full_size = ncart1234*ngen1234;
 
-    arb_ptr integral_buffer = _arb_vec_init(ncart1234);
+    int lmn1[ncart1][3];
+    int lmn2[ncart2][3];
+    int lmn3[ncart3][3];
+    int lmn4[ncart4][3];
+
+    mirp_gaussian_fill_lmn(am1, (int*)lmn1);
+    mirp_gaussian_fill_lmn(am2, (int*)lmn2);
+    mirp_gaussian_fill_lmn(am3, (int*)lmn3);
+    mirp_gaussian_fill_lmn(am4, (int*)lmn4);
+
     arb_ptr coeff1_norm = _arb_vec_init(nprim1 * ngen1);
     arb_ptr coeff2_norm = _arb_vec_init(nprim2 * ngen2);
     arb_ptr coeff3_norm = _arb_vec_init(nprim3 * ngen3);
@@ -110,51 +417,217 @@ void mirp_integral4(arb_ptr integrals,
     mirp_normalize_shell(am3, nprim3, ngen3, alpha3, coeff3, coeff3_norm, working_prec);
     mirp_normalize_shell(am4, nprim4, ngen4, alpha4, coeff4, coeff4_norm, working_prec);
 
-    _arb_vec_zero(integrals, full_size);
-
+    /* Products of coefficients for the bra and ket primitive pairs.
+     * Index is (primitive pair)*ngen12 + (general contraction pair) */
+    arb_ptr coeff12 = _arb_vec_init(nprim1*nprim2*ngen12);
+    arb_ptr coeff34 = _arb_vec_init(nprim3*nprim4*ngen34);
 
     for(int i = 0; i < nprim1; i++)
     for(int j = 0; j < nprim2; j++)
+    for(int m = 0; m < ngen1; m++)
+    for(int n = 0; n < ngen2; n++)
+        arb_mul(coeff12 + (i*nprim2+j)*ngen12 + m*ngen2 + n,
+                coeff1_norm+(m*nprim1+i), coeff2_norm+(n*nprim2+j), working_prec);
+
     for(int k = 0; k < nprim3; k++)
     for(int l = 0; l < nprim4; l++)
+    for(int o = 0; o < ngen3; o++)
+    for(int p = 0; p < ngen4; p++)
+        arb_mul(coeff34 + (k*nprim4+l)*ngen34 + o*ngen4 + p,
+                coeff3_norm+(o*nprim3+k), coeff4_norm+(p*nprim4+l), working_prec);
+
+    /* Primitive quartets that actually need to be computed */
+    long * prim_list = (long *)malloc((size_t)nprim1234 * sizeof(long));
+    mag_t skipped, doom;
+    mag_init(skipped);
+    mag_init(doom);
+
+    const long nprim_kept = mirp_integral4_screen_prim(prim_list, skipped, doom,
+                                                       am1, A, nprim1, alpha1,
+                                                       am2, B, nprim2, alpha2,
+                                                       am3, C, nprim3, alpha3,
+                                                       am4, D, nprim4, alpha4,
+                                                       coeff12, ngen12, coeff34, ngen34,
+                                                       working_prec, cb_bound);
+
+    /* Radius beyond which an integral is abandoned. This is never
+     * smaller than the smallest value of the format, so that integrals that are
+     * zero are not abandoned */
+    const int check_doom = (target != NULL && !mag_is_inf(doom));
+    if(check_doom)
     {
-        mirp_cartloop4(integral_buffer,
-                       am1, A, alpha1 + i,
-                       am2, B, alpha2 + j,
-                       am3, C, alpha3 + k,
-                       am4, D, alpha4 + l,
-                       working_prec, cb);
+        mag_t tiny;
+        mag_init(tiny);
+        mag_set_ui_2exp_si(tiny, 1, mirp_format_min_exp(*target));
+        mag_mul_2exp_si(doom, doom, 2 - mirp_format_prec(*target));
+        mag_max(doom, doom, tiny);
+        if(tol)
+            mag_max(doom, doom, tol);
+        mag_clear(tiny);
+    }
 
-        #ifdef _OPENMP
-        #pragma omp parallel for collapse(4)
-        #endif
-        for(int m = 0; m < ngen1; m++)
-        for(int n = 0; n < ngen2; n++)
-        for(int o = 0; o < ngen3; o++)
-        for(int p = 0; p < ngen4; p++)
+    for(long x = 0; x < full_size; x++)
+    {
+        if(mask == NULL || mask[x])
+            arb_zero(integrals + x);
+    }
+
+    if(ngen1234 > 1)
+    {
+        /* General contractions: transform one index at a time */
+        char * prim_mask = (char *)calloc((size_t)nprim1234, 1);
+        for(long n = 0; n < nprim_kept; n++)
+            prim_mask[prim_list[n]] = 1;
+
+        mirp_integral4_general(integrals,
+                               (const int *)lmn1, A, nprim1, ngen1, alpha1, coeff1_norm,
+                               (const int *)lmn2, B, nprim2, ngen2, alpha2, coeff2_norm,
+                               (const int *)lmn3, C, nprim3, ngen3, alpha3, coeff3_norm,
+                               (const int *)lmn4, D, nprim4, ngen4, alpha4, coeff4_norm,
+                               ncart2, ncart3, ncart4, ncart1234,
+                               prim_mask, mask, check_doom ? doom : NULL,
+                               working_prec, cb);
+        free(prim_mask);
+    }
+    else
+    {
+        /* Cartesian components to compute (without general contractions,
+         * these are also the indices into the output) */
+        long * cart_list = (long *)malloc((size_t)ncart1234 * sizeof(long));
+        char * abandon = (char *)calloc((size_t)ncart1234, 1);
+        long ncart_active = 0;
+        for(long q = 0; q < ncart1234; q++)
         {
-            /* A temporary variable (used to build up the coefficient) */
-            arb_t coeff;
-            arb_init(coeff);
+            if(mask == NULL || mask[q])
+                cart_list[ncart_active++] = q;
+        }
 
-            arb_mul(coeff, coeff1_norm+(m*nprim1+i), coeff2_norm+(n*nprim2+j), working_prec);
-            arb_mul(coeff, coeff,                    coeff3_norm+(o*nprim3+k), working_prec);
-            arb_mul(coeff, coeff,                    coeff4_norm+(p*nprim4+l), working_prec);
+        /* The work is made up of all (primitive quartet, cartesian component) pairs.
+         * Primitive integrals are computed in batches of whole primitive quartets, which are
+         * then added to the output in order of primitive quartet. The order of all arithmetic
+         * (and therefore the result, including the error bounds) does not depend on the number
+         * of threads. When abandoning integrals, the batches are made smaller so that
+         * the radius is checked several times. */
+        long batch_nprim = MAX(1, MIRP_INTEGRAL4_BATCH_SIZE / MAX(1, ncart_active));
+        if(check_doom)
+            batch_nprim = MIN(batch_nprim, MAX(1, nprim_kept / MIRP_INTEGRAL4_NCHECK));
+
+        const long batch_size = MIN(batch_nprim, nprim_kept) * ncart_active;
+        arb_ptr prim_integrals = mirp_workspace_get(batch_size);
+
+        /* Coefficient of each kept primitive quartet. These are the same for
+         * all cartesian components, so they are only computed once */
+        arb_ptr coeff1234 = _arb_vec_init(nprim_kept);
+        for(long n = 0; n < nprim_kept; n++)
+        {
+            const long ij = prim_list[n] / (nprim3*nprim4);
+            const long kl = prim_list[n] % (nprim3*nprim4);
+            arb_mul(coeff1234 + n, coeff12 + ij, coeff34 + kl, working_prec);
+        }
 
-            const long start = ncart1234*(
-                               m*ngen4*ngen3*ngen2
-                             + n*ngen4*ngen3
-                             + o*ngen4
-                             + p);
+        /* A single parallel region for the entire contracted quartet */
+        #ifdef _OPENMP
+        #pragma omp parallel num_threads(mirp_num_threads())
+        #endif
+        {
+            for(long n0 = 0; n0 < nprim_kept && ncart_active > 0; n0 += batch_nprim)
+            {
+                const long n1 = MIN(n0 + batch_nprim, nprim_kept);
+                const long nwork = (n1 - n0)*ncart_active;
+
+                #ifdef _OPENMP
+                #pragma omp for schedule(dynamic)
+                #endif
+                for(long w = 0; w < nwork; w++)
+                {
+                    /* Primitive quartet and cartesian component */
+                    const long pq = prim_list[n0 + w / ncart_active];
+                    const long q = cart_list[w % ncart_active];
+
+                    const long i = pq / (nprim2*nprim3*nprim4);
+                    const long j = (pq / (nprim3*nprim4)) % nprim2;
+                    const long k = (pq / nprim4) % nprim3;
+                    const long l = pq % nprim4;
+
+                    const long ci = q / (ncart2*ncart3*ncart4);
+                    const long cj = (q / (ncart3*ncart4)) % ncart2;
+                    const long ck = (q / ncart4) % ncart3;
+                    const long cl = q % ncart4;
+
+                    cb(prim_integrals + w,
+                       lmn1[ci], A, alpha1 + i,
+                       lmn2[cj], B, alpha2 + j,
+                       lmn3[ck], C, alpha3 + k,
+                       lmn4[cl], D, alpha4 + l,
+                       working_prec);
+                }
+
+                /* Add the batch to the output. Each element of the output is
+                 * handled by a single thread */
+                #ifdef _OPENMP
+                #pragma omp for schedule(static)
+                #endif
+                for(long a = 0; a < ncart_active; a++)
+                {
+                    const long x = cart_list[a];
+
+                    for(long n = n0; n < n1; n++)
+                        arb_addmul(integrals + x, prim_integrals + (n - n0)*ncart_active + a,
+                                   coeff1234 + n, working_prec);
+
+                    if(check_doom && mag_cmp(arb_radref(integrals + x), doom) > 0)
+                        abandon[a] = 1;
+                }
+
+                /* Remove abandoned integrals from the list */
+                if(check_doom)
+                {
+                    #ifdef _OPENMP
+                    #pragma omp single
+                    #endif
+                    {
+                        long nkept = 0;
+                        for(long a = 0; a < ncart_active; a++)
+                        {
+                            if(abandon[a])
+                            {
+                                arb_indeterminate(integrals + cart_list[a]);
+                                abandon[a] = 0;
+                            }
+                            else
+                                cart_list[nkept++] = cart_list[a];
+                        }
+                        ncart_active = nkept;
+                    }
+                }
+            }
+        }
 
-            for(long q = 0; q < ncart1234; q++)
-                arb_addmul(integrals+start+q, integral_buffer+q, coeff, working_prec);
+        mirp_workspace_release(prim_integrals, batch_size);
+        _arb_vec_clear(coeff1234, nprim_kept);
+        free(cart_list);
+        free(abandon);
+    }
 
-            arb_clear(coeff);
+    /* Account for the primitive quartets that were skipped */
+    if(!mag_is_zero(skipped))
+    {
+        for(long x = 0; x < full_size; x++)
+        {
+            if(mask == NULL || mask[x])
+                arb_add_error_mag(integrals + x, skipped);
         }
     }
 
-    _arb_vec_clear(integral_buffer, ncart1234);
+    if(skipped_out)
+        mag_set(skipped_out, skipped);
+
+    mag_clear(skipped);
+    mag_clear(doom);
+    free(prim_list);
+
+    _arb_vec_clear(coeff12, nprim1*nprim2*ngen12);
+    _arb_vec_clear(coeff34, nprim3*nprim4*ngen34);
     _arb_vec_clear(coeff1_norm, nprim1*ngen1);
     _arb_vec_clear(coeff2_norm, nprim2*ngen2);
     _arb_vec_clear(coeff3_norm, nprim3*ngen3);
@@ -162,6 +635,22 @@ void mirp_integral4(arb_ptr integrals,
 }
 
 
+void mirp_integral4_screened(arb_ptr integrals,
+                             int am1, arb_srcptr A, int nprim1, int ngen1, arb_srcptr alpha1, arb_srcptr coeff1,
+                             int am2, arb_srcptr B, int nprim2, int ngen2, arb_srcptr alpha2, arb_srcptr coeff2,
+                             int am3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3,
+                             int am4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4,
+                             slong working_prec, cb_integral4_single cb, cb_integral4_bound cb_bound)
+{
+    mirp_integral4_masked(integrals,
+                          am1, A, nprim1, ngen1, alpha1, coeff1,
+                          am2, B, nprim2, ngen2, alpha2, coeff2,
+                          am3, C, nprim3, ngen3, alpha3, coeff3,
+                          am4, D, nprim4, ngen4, alpha4, coeff4,
+                          NULL, NULL, NULL, NULL, working_prec, cb, cb_bound);
+}
+
+
 void mirp_integral4_single_str(arb_t integral,
                                const int * lmn1, const char ** A, const char * alpha1,
                                const int * lmn2, const char ** B, const char * alpha2,
@@ -300,7 +789,94 @@ void mirp_integral4_str(arb_ptr integrals,
 
 
 
-void mirp_integral4_single_exact(double * integral,
+/* Bits lost to cancellation when forming the gaussian product of two primitives
+ *
+ * The distances from the product center P to the centers A and B are
+ * computed by subtraction. If one exponent is much larger than the other,
+ * P is very close to one of the centers, and the bits of the coordinates
+ * above the (small) distance between them are lost.
+ */
+static double mirp_pair_loss_bits(const double * A, double alpha1,
+                                  const double * B, double alpha2)
+{
+    const double gamma = alpha1 + alpha2;
+    const double ratio = MIN(alpha1, alpha2) / gamma;
+    double loss = 0.0;
+
+    for(int n = 0; n < 3; n++)
+    {
+        const double dist = fabs(A[n] - B[n]);
+        const double coord = MAX(fabs(A[n]), fabs(B[n]));
+
+        /* If the coordinates are equal, the difference is just rounding
+         * noise that is small in absolute terms */
+        if(dist > 0.0)
+            loss = MAX(loss, log2(coord / (ratio * dist)));
+    }
+
+    return loss;
+}
+
+
+/* Estimates the number of bits lost when computing a contracted shell quartet
+ *
+ * This is a rough analytic estimate from the exponent ratios within each shell
+ * pair, the total angular momentum (cancellation between the alternating terms
+ * of the expansion grows with it), and the Boys function argument
+ * T = PQ^2 * gammapq. The largest estimate of any primitive quartet is used.
+ * It only determines the starting precision; the result is checked afterwards.
+ */
+static double mirp_integral4_loss_bits(int L12, int L34,
+                                       const double * A, int nprim1, const double * alpha1,
+                                       const double * B, int nprim2, const double * alpha2,
+                                       const double * C, int nprim3, const double * alpha3,
+                                       const double * D, int nprim4, const double * alpha4)
+{
+    double pair_loss = 0.0;
+    double max_T = 0.0;
+
+    for(int i = 0; i < nprim1; i++)
+    for(int j = 0; j < nprim2; j++)
+    {
+        const double gammap = alpha1[i] + alpha2[j];
+        if(L12 > 0)
+            pair_loss = MAX(pair_loss, mirp_pair_loss_bits(A, alpha1[i], B, alpha2[j]));
+
+        for(int k = 0; k < nprim3; k++)
+        for(int l = 0; l < nprim4; l++)
+        {
+            const double gammaq = alpha3[k] + alpha4[l];
+            double PQ2 = 0.0;
+
+            for(int n = 0; n < 3; n++)
+            {
+                const double P = (alpha1[i]*A[n] + alpha2[j]*B[n]) / gammap;
+                const double Q = (alpha3[k]*C[n] + alpha4[l]*D[n]) / gammaq;
+                PQ2 += (P-Q)*(P-Q);
+            }
+
+            max_T = MAX(max_T, PQ2 * gammap * gammaq / (gammap + gammaq));
+        }
+    }
+
+    if(L34 > 0)
+    {
+        for(int k = 0; k < nprim3; k++)
+        for(int l = 0; l < nprim4; l++)
+            pair_loss = MAX(pair_loss, mirp_pair_loss_bits(C, alpha3[k], D, alpha4[l]));
+    }
+
+    /* Rounding in the Boys function (see mirp_boys_exact) */
+    const int L = L12 + L34;
+    const double boys_loss = log2(L + MIN(max_T, L + 2.0) + 2.0);
+
+    /* The full loss of the gaussian product only appears if the cancelling
+     * term dominates, so only part of it is counted */
+    return 0.75*pair_loss + L + boys_loss + 8.0;
+}
+
+
+int mirp_integral4_single_target(void * integral, mirp_format fmt,
                                  const int * lmn1, const double * A, double alpha1,
                                  const int * lmn2, const double * B, double alpha2,
                                  const int * lmn3, const double * C, double alpha3,
@@ -341,22 +917,22 @@ void mirp_integral4_single_exact(double * integral,
     arb_t integral_mp;
     arb_init(integral_mp);
 
-    /* The target precision is the number of bits in
-     * double precision (53) + lots of safety */
-    const slong target_prec = 64;
-
-    slong working_prec = target_prec;
+    /* The target precision (used only for the starting precision) is the
+     * number of bits in the format + safety */
+    const slong target_prec = mirp_format_prec(fmt) + 11;
+
+    /* Start with the estimated precision. If that is not enough,
+     * the precision is increased geometrically */
+    const int L12 = lmn1[0] + lmn1[1] + lmn1[2] + lmn2[0] + lmn2[1] + lmn2[2];
+    const int L34 = lmn3[0] + lmn3[1] + lmn3[2] + lmn4[0] + lmn4[1] + lmn4[2];
+    const double loss_bits = mirp_integral4_loss_bits(L12, L34,
+                                                      A, 1, &alpha1, B, 1, &alpha2,
+                                                      C, 1, &alpha3, D, 1, &alpha4);
+    slong working_prec = mirp_exact_start_prec(target_prec, loss_bits);
     int suff_acc = 0;
 
-    /* for comparisons */
-    arf_t ubound, lbound;
-    arf_init(ubound);
-    arf_init(lbound);
-
     while(!suff_acc)
     {
-        working_prec += target_prec;
-
         /* Call the callback */
         cb(integral_mp,
            lmn1, A_mp, alpha1_mp,
@@ -365,37 +941,23 @@ void mirp_integral4_single_exact(double * integral,
            lmn4, D_mp, alpha4_mp,
            working_prec);
 
-        /* Do we have sufficient accuracy? We need at least
-         * 53 bits + 11 bits safety OR the value is zero (has zero precision)
-         * and the error bounds is exactly zero when converted to double precision */
-        slong bits = arb_rel_accuracy_bits(integral_mp);
+        /* Do we have sufficient accuracy? The entire ball
+         * must round to the same value in the requested format */
+        suff_acc = mirp_format_certified(integral_mp, fmt, working_prec);
 
-        suff_acc = 1;
-        if(bits > 0 && bits < target_prec)
-            suff_acc = 0;
-        else if(bits <= 0)
-        {
-            arb_get_ubound_arf(ubound, integral_mp, working_prec);
-            arb_get_lbound_arf(lbound, integral_mp, working_prec);
-
-
-            PRAGMA_WARNING_PUSH
-            PRAGMA_WARNING_IGNORE_FP_UNDERFLOW
+        /* A value (nearly) halfway between two values of the format
+         * may never be certified */
+        if(!suff_acc && working_prec >= MIRP_FORMAT_MAX_PREC)
+            break;
 
-            if(arf_cmpabs_d(lbound, MIRP_DBL_TRUE_MIN) > 0 || 
-                arf_cmpabs_d(ubound, MIRP_DBL_TRUE_MIN) > 0)
-                suff_acc = 0; 
-
-            PRAGMA_WARNING_POP
-        }
+        if(!suff_acc)
+            working_prec = mirp_exact_next_prec(working_prec);
     }
 
     /* We get the value from the midpoint of the arb struct */
-    *integral = arf_get_d(arb_midref(integral_mp), ARF_RND_NEAR);
+    mirp_format_set_arb(integral, 0, integral_mp, fmt);
 
     /* Cleanup */
-    arf_clear(lbound);
-    arf_clear(ubound);
     _arb_vec_clear(A_mp, 3);
     _arb_vec_clear(B_mp, 3);
     _arb_vec_clear(C_mp, 3);
@@ -405,15 +967,91 @@ void mirp_integral4_single_exact(double * integral,
     arb_clear(alpha3_mp);
     arb_clear(alpha4_mp);
     arb_clear(integral_mp);
+
+    return suff_acc;
 }
 
 
-void mirp_integral4_exact(double * integrals,
-                          int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
-                          int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
-                          int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
-                          int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
-                          cb_integral4 cb)
+void mirp_integral4_single_exact(double * integral,
+                                 const int * lmn1, const double * A, double alpha1,
+                                 const int * lmn2, const double * B, double alpha2,
+                                 const int * lmn3, const double * C, double alpha3,
+                                 const int * lmn4, const double * D, double alpha4,
+                                 cb_integral4_single cb)
+{
+    mirp_integral4_single_target(integral, MIRP_BINARY64,
+                                 lmn1, A, alpha1,
+                                 lmn2, B, alpha2,
+                                 lmn3, C, alpha3,
+                                 lmn4, D, alpha4,
+                                 cb);
+}
+
+
+/* Determines if a component has converged
+ *
+ * A component has converged if the entire ball rounds to the same value in the
+ * format, or is within the tolerance. Abandoned integrals (see mirp_integral4_masked)
+ * are indeterminate, and are neither. uncertified is set to zero if the component
+ * is certified, and nonzero otherwise.
+ */
+static int mirp_integral4_converged(const arb_t x, mirp_format fmt, slong working_prec,
+                                    const mag_t tol, char * uncertified)
+{
+    *uncertified = 0;
+    if(mirp_format_certified(x, fmt, working_prec))
+        return 1;
+
+    *uncertified = 1;
+    return mirp_format_negligible(x, tol);
+}
+
+
+/* Determines if a component would have converged without the error
+ * added for skipped primitive quartets (see mirp_integral4_masked)
+ */
+static int mirp_integral4_converged_unscreened(const arb_t x, const mag_t skipped,
+                                               mirp_format fmt, slong working_prec,
+                                               const mag_t tol)
+{
+    if(mag_is_zero(skipped) || !arb_is_finite(x))
+        return 0;
+
+    /* The radius without the skipped quartets is at most this */
+    arb_t t;
+    arb_init(t);
+    arf_set(arb_midref(t), arb_midref(x));
+    mag_sub(arb_radref(t), arb_radref(x), skipped);
+
+    char uncertified;
+    const int converged = mirp_integral4_converged(t, fmt, working_prec, tol, &uncertified);
+
+    arb_clear(t);
+    return converged;
+}
+
+
+/* Common part of mirp_integral4_target_tol, mirp_integral4_exact, and mirp_integral4_exact_screened
+ *
+ * If cb is not NULL, it is used to compute the entire quartet in each round.
+ * Otherwise, the quartet is computed with cb_single and cb_bound, and only components
+ * that have not yet converged are recomputed in each round. Components that only
+ * fail to converge because of the error from skipped primitive quartets (in particular,
+ * components that are exactly zero, which only round to zero if the radius is tiny)
+ * are recomputed without screening at the same working precision.
+ *
+ * Components that are within the tolerance (see mirp_format_tolerance) are accepted
+ * without being certified. These, and any components that could not be certified by
+ * MIRP_FORMAT_MAX_PREC, are marked in inexact (if not NULL), and the number of
+ * them is returned.
+ */
+static long mirp_integral4_target_common(void * integrals, char * inexact, mirp_format fmt,
+                                         double abs_tol, double rel_tol,
+                                         int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                                         int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                                         int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                                         int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                                         cb_integral4 cb, cb_integral4_single cb_single, cb_integral4_bound cb_bound)
 {
     assert(am1 >= 0); assert(nprim1 > 0); assert(ngen1 > 0);
     assert(am2 >= 0); assert(nprim2 > 0); assert(ngen2 > 0);
@@ -468,69 +1106,150 @@ void mirp_integral4_exact(double * integrals,
     const long nintegrals = ngen*ncart;
     arb_ptr integral_mp = _arb_vec_init(nintegrals);
 
-    /* The target precision is the number of bits in double precision (53) + safety */
-    const slong target_prec = 64;
+    /* Components that still need to be computed. Once a component has
+     * converged, it is kept as-is. Components that are negligible (or that
+     * could not be certified) are not correctly rounded */
+    char * mask = (char *)malloc((size_t)nintegrals);
+    char * uncertified = (char *)malloc((size_t)nintegrals);
+    char * unscreened = (char *)calloc((size_t)nintegrals, 1);
+    for(long i = 0; i < nintegrals; i++)
+    {
+        mask[i] = 1;
+        uncertified[i] = 1;
+    }
 
-    slong working_prec = target_prec;
+    /* Sum of the bounds of the skipped primitive quartets */
+    mag_t skipped;
+    mag_init(skipped);
+
+    /* Values smaller than the tolerance do not need to be certified.
+     * The relative tolerance uses a lower bound of the largest
+     * magnitude of any component, which only grows between rounds */
+    mag_t tol, max_mag, tmp;
+    mag_init(tol);
+    mag_init(max_mag);
+    mag_init(tmp);
+    mirp_format_tolerance(tol, abs_tol, rel_tol, max_mag);
+
+    /* The target precision (used only for the starting precision) is the
+     * number of bits in the format + safety */
+    const slong target_prec = mirp_format_prec(fmt) + 11;
+
+    /* Start with the estimated precision. If that is not enough,
+     * the precision is increased geometrically */
+    const double loss_bits = mirp_integral4_loss_bits(am1 + am2, am3 + am4,
+                                                      A, nprim1, alpha1, B, nprim2, alpha2,
+                                                      C, nprim3, alpha3, D, nprim4, alpha4);
+    slong working_prec = mirp_exact_start_prec(target_prec, loss_bits);
     int suff_acc = 0;
 
-    /* for comparisons */
-    arf_t ubound, lbound;
-    arf_init(ubound);
-    arf_init(lbound);
-
     while(!suff_acc)
     {
-        working_prec += target_prec;
+        /* In the last attempt, nothing is abandoned */
+        const int last = (working_prec >= MIRP_FORMAT_MAX_PREC);
 
         /* Call the callback */
-        cb(integral_mp,
-           am1, A_mp, nprim1, ngen1, alpha1_mp, coeff1_mp,
-           am2, B_mp, nprim2, ngen2, alpha2_mp, coeff2_mp,
-           am3, C_mp, nprim3, ngen3, alpha3_mp, coeff3_mp,
-           am4, D_mp, nprim4, ngen4, alpha4_mp, coeff4_mp,
-           working_prec);
-
-        suff_acc = 1;
-        for(long i = 0; i < nintegrals; i++)
+        if(cb)
         {
-            /* Do we have sufficient accuracy? We need at least
-             * 53 bits + 11 bits safety OR the value is zero (has zero precision)
-             * and the error bounds is exactly zero when converted to double precision */
-            slong bits = arb_rel_accuracy_bits(integral_mp + i);
+            cb(integral_mp,
+               am1, A_mp, nprim1, ngen1, alpha1_mp, coeff1_mp,
+               am2, B_mp, nprim2, ngen2, alpha2_mp, coeff2_mp,
+               am3, C_mp, nprim3, ngen3, alpha3_mp, coeff3_mp,
+               am4, D_mp, nprim4, ngen4, alpha4_mp, coeff4_mp,
+               working_prec);
+        }
+        else
+        {
+            mirp_integral4_masked(integral_mp,
+                                  am1, A_mp, nprim1, ngen1, alpha1_mp, coeff1_mp,
+                                  am2, B_mp, nprim2, ngen2, alpha2_mp, coeff2_mp,
+                                  am3, C_mp, nprim3, ngen3, alpha3_mp, coeff3_mp,
+                                  am4, D_mp, nprim4, ngen4, alpha4_mp, coeff4_mp,
+                                  mask, last ? NULL : &fmt, tol, skipped, working_prec, cb_single, cb_bound);
+        }
 
-            if(bits > 0 && bits < target_prec)
-                suff_acc = 0;
-            else if(bits <= 0)
+        if(rel_tol > 0.0)
+        {
+            for(long i = 0; i < nintegrals; i++)
             {
-                arb_get_ubound_arf(ubound, integral_mp + i, working_prec);
-                arb_get_lbound_arf(lbound, integral_mp + i, working_prec);
+                if(!arb_is_finite(integral_mp + i))
+                    continue;
 
-                PRAGMA_WARNING_PUSH
-                PRAGMA_WARNING_IGNORE_FP_UNDERFLOW
+                arb_get_mag_lower(tmp, integral_mp + i);
+                mag_max(max_mag, max_mag, tmp);
+            }
 
-                if(arf_cmpabs_d(lbound, MIRP_DBL_TRUE_MIN) > 0 || 
-                   arf_cmpabs_d(ubound, MIRP_DBL_TRUE_MIN) > 0)
-                    suff_acc = 0; 
+            mirp_format_tolerance(tol, abs_tol, rel_tol, max_mag);
+        }
 
-                PRAGMA_WARNING_POP
+        suff_acc = 1;
+        long nunscreened = 0;
+        for(long i = 0; i < nintegrals; i++)
+        {
+            /* Without partial recomputation, all components are checked every time */
+            if(cb == NULL && !mask[i])
+                continue;
+
+            /* Do we have sufficient accuracy? */
+            if(mirp_integral4_converged(integral_mp + i, fmt, working_prec, tol, uncertified + i))
+                mask[i] = 0;
+            else if(cb == NULL && mirp_integral4_converged_unscreened(integral_mp + i, skipped,
+                                                                      fmt, working_prec, tol))
+            {
+                unscreened[i] = 1;
+                nunscreened++;
+            }
+            else
+                suff_acc = 0;
+        }
+
+        /* Increasing the precision would not help components that failed only
+         * because of the skipped primitive quartets (until they are no longer
+         * skipped), so these are recomputed without screening instead */
+        if(nunscreened > 0)
+        {
+            mirp_integral4_masked(integral_mp,
+                                  am1, A_mp, nprim1, ngen1, alpha1_mp, coeff1_mp,
+                                  am2, B_mp, nprim2, ngen2, alpha2_mp, coeff2_mp,
+                                  am3, C_mp, nprim3, ngen3, alpha3_mp, coeff3_mp,
+                                  am4, D_mp, nprim4, ngen4, alpha4_mp, coeff4_mp,
+                                  unscreened, NULL, NULL, NULL, working_prec, cb_single, NULL);
+
+            for(long i = 0; i < nintegrals; i++)
+            {
+                if(!unscreened[i])
+                    continue;
+
+                unscreened[i] = 0;
+                if(mirp_integral4_converged(integral_mp + i, fmt, working_prec, tol, uncertified + i))
+                    mask[i] = 0;
+                else
+                    suff_acc = 0;
             }
         }
+
+        /* A value (nearly) halfway between two values of the format
+         * may never be certified */
+        if(last)
+            break;
+
+        if(!suff_acc)
+            working_prec = mirp_exact_next_prec(working_prec);
     }
 
 
     /* We get the value from the midpoint of the arb struct */
+    long nuncertified = 0;
     for(long i = 0; i < nintegrals; i++)
     {
-        if(arb_rel_accuracy_bits(integral_mp + i) <= 0)
-            integrals[i] = 0.0;
-        else
-            integrals[i] = arf_get_d(arb_midref(integral_mp + i), ARF_RND_NEAR);
+        mirp_format_set_arb(integrals, i, integral_mp + i, fmt);
+        if(inexact)
+            inexact[i] = uncertified[i];
+        if(uncertified[i])
+            nuncertified++;
     }
 
     /* Cleanup */
-    arf_clear(lbound);
-    arf_clear(ubound);
     _arb_vec_clear(A_mp, 3);
     _arb_vec_clear(B_mp, 3);
     _arb_vec_clear(C_mp, 3);
@@ -544,5 +1263,79 @@ void mirp_integral4_exact(double * integrals,
     _arb_vec_clear(coeff3_mp, nprim3*ngen3);
     _arb_vec_clear(coeff4_mp, nprim4*ngen4);
     _arb_vec_clear(integral_mp, nintegrals);
+    mag_clear(tol);
+    mag_clear(max_mag);
+    mag_clear(tmp);
+    mag_clear(skipped);
+    free(mask);
+    free(uncertified);
+    free(unscreened);
+
+    return nuncertified;
+}
+
+
+long mirp_integral4_target(void * integrals, mirp_format fmt,
+                           int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                           int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                           int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                           int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                           cb_integral4_single cb, cb_integral4_bound cb_bound)
+{
+    return mirp_integral4_target_common(integrals, NULL, fmt, 0.0, 0.0,
+                                        am1, A, nprim1, ngen1, alpha1, coeff1,
+                                        am2, B, nprim2, ngen2, alpha2, coeff2,
+                                        am3, C, nprim3, ngen3, alpha3, coeff3,
+                                        am4, D, nprim4, ngen4, alpha4, coeff4,
+                                        NULL, cb, cb_bound);
+}
+
+
+long mirp_integral4_target_tol(void * integrals, char * inexact, mirp_format fmt,
+                               double abs_tol, double rel_tol,
+                               int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                               int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                               int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                               int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                               cb_integral4_single cb, cb_integral4_bound cb_bound)
+{
+    return mirp_integral4_target_common(integrals, inexact, fmt, abs_tol, rel_tol,
+                                        am1, A, nprim1, ngen1, alpha1, coeff1,
+                                        am2, B, nprim2, ngen2, alpha2, coeff2,
+                                        am3, C, nprim3, ngen3, alpha3, coeff3,
+                                        am4, D, nprim4, ngen4, alpha4, coeff4,
+                                        NULL, cb, cb_bound);
+}
+
+
+long mirp_integral4_exact(double * integrals,
+                          int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                          int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                          int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                          int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                          cb_integral4 cb)
+{
+    return mirp_integral4_target_common(integrals, NULL, MIRP_BINARY64, 0.0, 0.0,
+                                        am1, A, nprim1, ngen1, alpha1, coeff1,
+                                        am2, B, nprim2, ngen2, alpha2, coeff2,
+                                        am3, C, nprim3, ngen3, alpha3, coeff3,
+                                        am4, D, nprim4, ngen4, alpha4, coeff4,
+                                        cb, NULL, NULL);
+}
+
+
+long mirp_integral4_exact_screened(double * integrals,
+                                   int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                                   int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                                   int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                                   int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                                   cb_integral4_single cb, cb_integral4_bound cb_bound)
+{
+    return mirp_integral4_target_common(integrals, NULL, MIRP_BINARY64, 0.0, 0.0,
+                                        am1, A, nprim1, ngen1, alpha1, coeff1,
+                                        am2, B, nprim2, ngen2, alpha2, coeff2,
+                                        am3, C, nprim3, ngen3, alpha3, coeff3,
+                                        am4, D, nprim4, ngen4, alpha4, coeff4,
+                                        NULL, cb, cb_bound);
 }
 
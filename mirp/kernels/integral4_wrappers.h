@@ -6,6 +6,7 @@
 #pragma once
 
 #include "mirp/typedefs.h"
+#include "mirp/format.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +71,42 @@ void mirp_integral4_single_exact(double * integral,
                                  cb_integral4_single cb);
 
 
+/*! \brief Computes a single integral, correctly rounded to a given
+ *         floating-point format, using interval arithmetic (four-center)
+ *
+ * The working precision is increased until the entire error ball of the
+ * result rounds to the same value in the format \p fmt (see
+ * \ref mirp_format_certified), so less work is done for
+ * formats with fewer bits. \ref mirp_integral4_single_exact is this
+ * function with \ref MIRP_BINARY64.
+ *
+ * \param [out] integral
+ *              Output for the computed integral (a `float`, `double`, or
+ *              \ref mirp_binary128, depending on \p fmt)
+ * \param [in]  fmt
+ *              Format of the output
+ * \param [in]  lmn1,lmn2,lmn3,lmn4
+ *              Exponents of x, y, and z that signify angular momentum. Required
+ *              to be 3 elements.
+ * \param [in]  A,B,C,D
+ *              XYZ coordinates of the four centers (each of length 3)
+ * \param [in]  alpha1,alpha2,alpha3,alpha4
+ *              Exponents of the gaussian on the four centers
+ * \param [in]  cb
+ *              Function that computes a single cartesian four-center integral
+ *              with interval arithmetic
+ * \return Nonzero if the result is certified. Zero if it could not be certified by
+ *         \ref MIRP_FORMAT_MAX_PREC, in which case the rounded midpoint of the last
+ *         attempt is stored in \p integral
+ */
+int mirp_integral4_single_target(void * integral, mirp_format fmt,
+                                 const int * lmn1, const double * A, double alpha1,
+                                 const int * lmn2, const double * B, double alpha2,
+                                 const int * lmn3, const double * C, double alpha3,
+                                 const int * lmn4, const double * D, double alpha4,
+                                 cb_integral4_single cb);
+
+
 /*! \brief Compute all cartesian integrals of a contracted shell quartet
  *         for an integral (four-center, interval arithmetic)
  *
@@ -77,6 +114,18 @@ void mirp_integral4_single_exact(double * integral,
  * primitive cartesian integrals, and uses it to compute all the cartesian
  * components for an contracted shell quartet.
  *
+ * If compiled with OpenMP, all primitive quartets and cartesian components
+ * are distributed over the threads within a single parallel region. When called
+ * from within another parallel region (such as from \ref mirp_scheduler_run),
+ * this function runs on a single thread. The order of all arithmetic operations
+ * is fixed, so the results (including error bounds) are identical for any number
+ * of threads.
+ *
+ * For shells with general contractions, the transformation from primitive to
+ * contracted integrals is done one index at a time (as dot products over the
+ * primitives of each shell), rather than separately for every combination
+ * of general contractions.
+ *
  * \param [out] integrals
  *              Output for the computed integral
  * \param [in]  am1,am2,am3,am4
@@ -109,6 +158,31 @@ void mirp_integral4(arb_ptr integrals,
                     slong working_prec, cb_integral4_single cb);
 
 
+/*! \brief Compute all cartesian integrals of a contracted shell quartet,
+ *         skipping negligible primitive quartets (four-center, interval arithmetic)
+ *
+ * This is the same as \ref mirp_integral4, except that an upper bound of the
+ * contribution of each primitive quartet (including the magnitude of the contraction
+ * coefficients) is first obtained from \p cb_bound. Primitive quartets whose bound
+ * is smaller than the largest bound times 2^-\p working_prec are not computed.
+ * The sum of the bounds of all skipped primitive quartets is added to the
+ * error radius of every integral, so the results are still rigorous.
+ *
+ * If \p cb_bound is NULL, all primitive quartets are computed.
+ *
+ * \copydetails mirp_integral4
+ * \param [in]  cb_bound
+ *              Function that computes an upper bound of the magnitude of all cartesian
+ *              integrals of a primitive quartet
+ */
+void mirp_integral4_screened(arb_ptr integrals,
+                             int am1, arb_srcptr A, int nprim1, int ngen1, arb_srcptr alpha1, arb_srcptr coeff1,
+                             int am2, arb_srcptr B, int nprim2, int ngen2, arb_srcptr alpha2, arb_srcptr coeff2,
+                             int am3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3,
+                             int am4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4,
+                             slong working_prec, cb_integral4_single cb, cb_integral4_bound cb_bound);
+
+
 /*! \brief Compute a single 4-center integral to a target precision (string input)
  *
  * This function converts string inputs into arblib types and runs the callback \c cb
@@ -172,8 +246,11 @@ void mirp_integral4_str(arb_ptr integrals,
  * \param [in]  cb
  *              Function that computes a single cartesian four-center integral
  *              with interval arithmetic
+ * \return The number of integrals that may not be correctly rounded (zero if all
+ *         are certified). The rounded midpoint of the last attempt is stored for each
+ *         integral that could not be certified by \ref MIRP_FORMAT_MAX_PREC.
  */
-void mirp_integral4_exact(double * integrals,
+long mirp_integral4_exact(double * integrals,
                           int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
                           int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
                           int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
@@ -181,6 +258,110 @@ void mirp_integral4_exact(double * integrals,
                           cb_integral4 cb);
 
 
+/*! \brief Compute all cartesian integrals of a contracted shell quartet
+ *         to exact double precision, reusing converged components (four-center)
+ *
+ * This is similar to \ref mirp_integral4_exact, except that the quartet is computed
+ * from single primitive integrals via \ref mirp_integral4_screened. When the working
+ * precision is increased, only the components that have not yet reached the
+ * required accuracy are recomputed. Components that have converged are kept.
+ *
+ * If \p cb_bound is given, the sum of the primitive bounds limits the magnitude
+ * of every component. A component whose error radius grows beyond what would allow
+ * the required accuracy is abandoned part way through the contraction, and
+ * the precision is increased without computing the rest of it.
+ *
+ * \copydetails mirp_integral4_exact
+ * \param [in]  cb_bound
+ *              Function that computes an upper bound of the magnitude of all cartesian
+ *              integrals of a primitive quartet (may be NULL)
+ */
+long mirp_integral4_exact_screened(double * integrals,
+                                   int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                                   int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                                   int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                                   int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                                   cb_integral4_single cb, cb_integral4_bound cb_bound);
+
+
+/*! \brief Compute all cartesian integrals of a contracted shell quartet,
+ *         correctly rounded to a given floating-point format (four-center)
+ *
+ * This is \ref mirp_integral4_exact_screened with the output in the format \p fmt.
+ * Components are finished as soon as their error ball rounds to a single value
+ * of that format (see \ref mirp_format_certified), so formats with fewer
+ * bits need lower working precisions (and often fewer attempts).
+ *
+ * \param [out] integrals
+ *              Output for the computed integrals (`float`, `double`, or
+ *              \ref mirp_binary128, depending on \p fmt)
+ * \param [in]  fmt
+ *              Format of the output
+ * \param [in]  am1,am2,am3,am4
+ *              Angular momentum for the four centers
+ * \param [in]  A,B,C,D
+ *              XYZ coordinates of the four centers (each of length 3)
+ * \param [in]  nprim1,nprim2,nprim3,nprim4
+ *              Number of primitive gaussians for each shell
+ * \param [in]  ngen1,ngen2,ngen3,ngen4
+ *              Number of general contractions for each shell
+ * \param [in]  alpha1,alpha2,alpha3,alpha4
+ *              Exponents of the primitive gaussians on the four centers
+ *              (of lengths \p nprim1, \p nprim2, \p nprim3, \p nprim4 respectively)
+ * \param [in]  coeff1,coeff2,coeff3,coeff4
+ *              Coefficients for all primitives and for all general contractions
+ *              for each shell (of lengths \p nprim1 * \p ngen1, \p nprim2 * \p ngen2,
+ *              \p nprim3 * \p ngen3, \p nprim4 * \p ngen4 respectively)
+ * \param [in]  cb
+ *              Function that computes a single cartesian four-center integral
+ *              with interval arithmetic
+ * \param [in]  cb_bound
+ *              Function that computes an upper bound of the magnitude of all cartesian
+ *              integrals of a primitive quartet (may be NULL)
+ * \return The number of integrals that may not be correctly rounded (zero if all
+ *         are certified). The rounded midpoint of the last attempt is stored for each
+ *         integral that could not be certified by \ref MIRP_FORMAT_MAX_PREC.
+ */
+long mirp_integral4_target(void * integrals, mirp_format fmt,
+                           int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                           int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                           int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                           int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                           cb_integral4_single cb, cb_integral4_bound cb_bound);
+
+
+/*! \brief Compute all cartesian integrals of a contracted shell quartet,
+ *         correctly rounded to a given floating-point format unless
+ *         negligible (four-center)
+ *
+ * This is \ref mirp_integral4_target, except that components whose magnitude is
+ * known to be at most a tolerance are accepted without being certified.
+ * The tolerance is the larger of \p abs_tol and \p rel_tol times the magnitude
+ * of the largest component of the quartet. Such components are returned as the
+ * midpoint of their last error ball (which may not be correctly rounded), and are
+ * flagged in \p inexact (and counted in the return value). Small components then
+ * no longer need a working precision large enough to resolve them to full relative accuracy.
+ *
+ * \param [out] inexact
+ *              For each integral, nonzero if it may not be correctly rounded: it was only
+ *              found to be within the tolerance, or could not be certified by
+ *              \ref MIRP_FORMAT_MAX_PREC (may be NULL)
+ * \param [in]  abs_tol
+ *              Absolute tolerance (zero for none)
+ * \param [in]  rel_tol
+ *              Tolerance relative to the largest component (zero for none)
+ *
+ * \copydetails mirp_integral4_target
+ */
+long mirp_integral4_target_tol(void * integrals, char * inexact, mirp_format fmt,
+                               double abs_tol, double rel_tol,
+                               int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1,
+                               int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2,
+                               int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3,
+                               int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4,
+                               cb_integral4_single cb, cb_integral4_bound cb_bound);
+
+
 /*! \brief Create a function that computes single cartesian integrals
  *         from string arguments (four-center)
  *
@@ -237,6 +418,33 @@ void mirp_integral4_exact(double * integrals,
     }
 
 
+/*! \brief Create a function that computes single cartesian integrals
+ *         correctly rounded to a given floating-point format (four-center)
+ *
+ *  A function computing single cartesian integrals is
+ *  expected to exist and be named `mirp_{name}_single`
+ *
+ *  The created function is named `mirp_{name}_single_target`.
+ *
+ *  \sa mirp_integral4_single_target
+ */
+#define MIRP_WRAP_SINGLE4_TARGET(name) \
+    static inline \
+    int mirp_##name##_single_target(void * integral, mirp_format fmt, \
+                                    const int * lmn1, const double * A, double alpha1, \
+                                    const int * lmn2, const double * B, double alpha2, \
+                                    const int * lmn3, const double * C, double alpha3, \
+                                    const int * lmn4, const double * D, double alpha4) \
+    { \
+        return mirp_integral4_single_target(integral, fmt, \
+                                            lmn1, A, alpha1, \
+                                            lmn2, B, alpha2, \
+                                            lmn3, C, alpha3, \
+                                            lmn4, D, alpha4, \
+                                            mirp_##name##_single); \
+    }
+
+
 /*! \brief Create a function that computes all cartesian integrals
  *         of a contracted shell quartet (four-center, interval arithmetic)
  *
@@ -265,6 +473,36 @@ void mirp_integral4_exact(double * integrals,
     }
 
 
+/*! \brief Create a function that computes all cartesian integrals
+ *         of a contracted shell quartet, skipping negligible primitive quartets
+ *         (four-center, interval arithmetic)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}`.
+ *
+ *  \sa mirp_integral4_screened
+ */
+#define MIRP_WRAP_SHELL4_SCREENED(name) \
+    static inline \
+    void mirp_##name(arb_t integrals, \
+                     int am1, arb_srcptr A, int nprim1, int ngen1, arb_srcptr alpha1, arb_srcptr coeff1, \
+                     int am2, arb_srcptr B, int nprim2, int ngen2, arb_srcptr alpha2, arb_srcptr coeff2, \
+                     int am3, arb_srcptr C, int nprim3, int ngen3, arb_srcptr alpha3, arb_srcptr coeff3, \
+                     int am4, arb_srcptr D, int nprim4, int ngen4, arb_srcptr alpha4, arb_srcptr coeff4, \
+                     slong working_prec) \
+    { \
+        mirp_integral4_screened(integrals, \
+                                am1, A, nprim1, ngen1, alpha1, coeff1, \
+                                am2, B, nprim2, ngen2, alpha2, coeff2, \
+                                am3, C, nprim3, ngen3, alpha3, coeff3, \
+                                am4, D, nprim4, ngen4, alpha4, coeff4, \
+                                working_prec, mirp_##name##_single, mirp_##name##_bound); \
+    }
+
+
 /*! \brief Create a function that computes all cartesian integrals
  *         of a contracted shell quartet from string arguments 
  *         (four-center)
@@ -307,18 +545,106 @@ void mirp_integral4_exact(double * integrals,
  */
 #define MIRP_WRAP_SHELL4_EXACT(name) \
     static inline \
-    void mirp_##name##_exact(double * integrals, \
+    long mirp_##name##_exact(double * integrals, \
                              int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1, \
                              int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2, \
                              int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3, \
                              int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4) \
     { \
-        mirp_integral4_exact(integrals, \
-                             am1, A, nprim1, ngen1, alpha1, coeff1, \
-                             am2, B, nprim2, ngen2, alpha2, coeff2, \
-                             am3, C, nprim3, ngen3, alpha3, coeff3, \
-                             am4, D, nprim4, ngen4, alpha4, coeff4, \
-                             mirp_##name); \
+        return mirp_integral4_exact(integrals, \
+                                    am1, A, nprim1, ngen1, alpha1, coeff1, \
+                                    am2, B, nprim2, ngen2, alpha2, coeff2, \
+                                    am3, C, nprim3, ngen3, alpha3, coeff3, \
+                                    am4, D, nprim4, ngen4, alpha4, coeff4, \
+                                    mirp_##name); \
+    }
+
+
+/*! \brief Create a function that computes all cartesian integrals
+ *         of a contracted shell quartet to exact double precision,
+ *         reusing converged components (four-center)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}_exact`.
+ *
+ *  \sa mirp_integral4_exact_screened
+ */
+#define MIRP_WRAP_SHELL4_EXACT_SCREENED(name) \
+    static inline \
+    long mirp_##name##_exact(double * integrals, \
+                             int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1, \
+                             int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2, \
+                             int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3, \
+                             int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4) \
+    { \
+        return mirp_integral4_exact_screened(integrals, \
+                                             am1, A, nprim1, ngen1, alpha1, coeff1, \
+                                             am2, B, nprim2, ngen2, alpha2, coeff2, \
+                                             am3, C, nprim3, ngen3, alpha3, coeff3, \
+                                             am4, D, nprim4, ngen4, alpha4, coeff4, \
+                                             mirp_##name##_single, mirp_##name##_bound); \
+    }
+
+
+/*! \brief Create a function that computes all cartesian integrals
+ *         of a contracted shell quartet, correctly rounded to a given
+ *         floating-point format (four-center)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}_target`.
+ *
+ *  \sa mirp_integral4_target
+ */
+#define MIRP_WRAP_SHELL4_TARGET(name) \
+    static inline \
+    long mirp_##name##_target(void * integrals, mirp_format fmt, \
+                              int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1, \
+                              int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2, \
+                              int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3, \
+                              int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4) \
+    { \
+        return mirp_integral4_target(integrals, fmt, \
+                                     am1, A, nprim1, ngen1, alpha1, coeff1, \
+                                     am2, B, nprim2, ngen2, alpha2, coeff2, \
+                                     am3, C, nprim3, ngen3, alpha3, coeff3, \
+                                     am4, D, nprim4, ngen4, alpha4, coeff4, \
+                                     mirp_##name##_single, mirp_##name##_bound); \
+    }
+
+
+/*! \brief Create a function that computes all cartesian integrals
+ *         of a contracted shell quartet, correctly rounded to a given
+ *         floating-point format unless negligible (four-center)
+ *
+ *  A function computing single cartesian integrals is expected to exist and
+ *  be named `mirp_{name}_single`, and a function computing bounds of primitive
+ *  quartets is expected to exist and be named `mirp_{name}_bound`
+ *
+ *  The created function is named `mirp_{name}_target_tol`.
+ *
+ *  \sa mirp_integral4_target_tol
+ */
+#define MIRP_WRAP_SHELL4_TARGET_TOL(name) \
+    static inline \
+    long mirp_##name##_target_tol(void * integrals, char * inexact, mirp_format fmt, \
+                                  double abs_tol, double rel_tol, \
+                                  int am1, const double * A, int nprim1, int ngen1, const double * alpha1, const double * coeff1, \
+                                  int am2, const double * B, int nprim2, int ngen2, const double * alpha2, const double * coeff2, \
+                                  int am3, const double * C, int nprim3, int ngen3, const double * alpha3, const double * coeff3, \
+                                  int am4, const double * D, int nprim4, int ngen4, const double * alpha4, const double * coeff4) \
+    { \
+        return mirp_integral4_target_tol(integrals, inexact, fmt, abs_tol, rel_tol, \
+                                         am1, A, nprim1, ngen1, alpha1, coeff1, \
+                                         am2, B, nprim2, ngen2, alpha2, coeff2, \
+                                         am3, C, nprim3, ngen3, alpha3, coeff3, \
+                                         am4, D, nprim4, ngen4, alpha4, coeff4, \
+                                         mirp_##name##_single, mirp_##name##_bound); \
     }
 
 
@@ -5,6 +5,7 @@
  */
 
 #include "mirp/math.h"
+#include <math.h>
 #include <assert.h>
 
 
@@ -21,6 +22,29 @@ slong mirp_min_accuracy_bits(arb_srcptr v, size_t n)
     return min;
 }
 
+slong mirp_exact_start_prec(slong target_prec, double loss_bits)
+{
+    assert(target_prec > 0);
+
+    slong extra = 64;
+
+    /* Also guards against NaN and extremely large estimates */
+    if(loss_bits > 64.0 && loss_bits < 65536.0)
+        extra = ((slong)ceil(loss_bits) + 63) / 64 * 64;
+
+    return target_prec + extra;
+}
+
+
+slong mirp_exact_next_prec(slong working_prec)
+{
+    assert(working_prec > 0);
+
+    const slong step = MAX(64, working_prec / 2);
+    return (working_prec + step + 63) / 64 * 64;
+}
+
+
 void mirp_pow_si(arb_t output, const arb_t b, long e, slong prec)
 {
     if(e >= 0)
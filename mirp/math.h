@@ -60,6 +60,30 @@ extern "C" {
 slong mirp_min_accuracy_bits(arb_srcptr v, size_t n);
 
 
+/*! \brief Working precision of the first attempt of an exact (double precision) function
+ *
+ * The result is the target precision plus the estimated number of bits lost to
+ * cancellation and rounding, rounded up to a multiple of 64. At least 64 extra
+ * bits are always used.
+ *
+ * \param [in] target_prec The number of accurate bits required in the result
+ * \param [in] loss_bits   Estimated number of bits lost during the calculation
+ * \return The working precision to start with
+ */
+slong mirp_exact_start_prec(slong target_prec, double loss_bits);
+
+
+/*! \brief Working precision of the next attempt of an exact (double precision) function
+ *
+ * The precision grows geometrically (by half, rounded up to a multiple of 64),
+ * so that cases that were badly underestimated do not require many attempts.
+ *
+ * \param [in] working_prec The working precision of the previous (insufficient) attempt
+ * \return The working precision of the next attempt
+ */
+slong mirp_exact_next_prec(slong working_prec);
+
+
 /*! \brief Calculates b^e with e being a signed integer */
 void mirp_pow_si(arb_t output, const arb_t b, long e, slong prec);
 
@@ -6,3 +6,7 @@
 #pragma once
 
 #include "mirp/kernels/all.h"
+#include "mirp/format.h"
+#include "mirp/basis.h"
+#include "mirp/runtime.h"
+#include "mirp/scheduler.h"
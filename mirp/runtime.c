@@ -0,0 +1,217 @@
+/*! \file
+ *
+ * \brief Initialization and cleanup of the MIRP runtime (threads and caches)
+ */
+
+#include "mirp/runtime.h"
+#include <flint/flint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/* Number of threads set via mirp_init (0 = OpenMP default) */
+static int mirp_nthreads = 0;
+
+#ifdef _OPENMP
+/* Workspace kept by a thread
+ *
+ * All workspaces are also kept in a global list (protected by the
+ * mirp_workspace_registry critical section), so that mirp_finalize can
+ * free them no matter which threads created them.
+ */
+typedef struct mirp_workspace_entry
+{
+    arb_ptr v;
+    slong size;
+    struct mirp_workspace_entry * next;
+} mirp_workspace_entry;
+
+static mirp_workspace_entry * mirp_workspace_list = NULL;
+
+/* Incremented by mirp_finalize. A thread whose workspace is from an
+ * earlier generation no longer owns it (it has been freed) */
+static long mirp_workspace_generation = 0;
+
+/* Workspace of each thread, and the generation in which it was created */
+static mirp_workspace_entry * mirp_workspace = NULL;
+static long mirp_workspace_gen = 0;
+#pragma omp threadprivate(mirp_workspace, mirp_workspace_gen)
+
+
+/* Removes a workspace from the global list and frees it */
+static void mirp_workspace_unregister(mirp_workspace_entry * ws)
+{
+    #pragma omp critical(mirp_workspace_registry)
+    {
+        mirp_workspace_entry ** p = &mirp_workspace_list;
+        while(*p && *p != ws)
+            p = &(*p)->next;
+        if(*p)
+            *p = ws->next;
+    }
+
+    if(ws->v)
+        _arb_vec_clear(ws->v, ws->size);
+    free(ws);
+}
+
+
+/* Frees all workspaces of all threads */
+static void mirp_workspace_free_all(void)
+{
+    #pragma omp critical(mirp_workspace_registry)
+    {
+        while(mirp_workspace_list)
+        {
+            mirp_workspace_entry * ws = mirp_workspace_list;
+            mirp_workspace_list = ws->next;
+
+            if(ws->v)
+                _arb_vec_clear(ws->v, ws->size);
+            free(ws);
+        }
+
+        #pragma omp atomic
+        mirp_workspace_generation++;
+    }
+}
+
+
+/* Returns the workspace of the calling thread (if it still owns one) */
+static mirp_workspace_entry * mirp_workspace_current(void)
+{
+    long gen;
+    #pragma omp atomic read
+    gen = mirp_workspace_generation;
+
+    if(mirp_workspace_gen != gen)
+    {
+        /* Freed by mirp_finalize */
+        mirp_workspace = NULL;
+        mirp_workspace_gen = gen;
+    }
+
+    return mirp_workspace;
+}
+#endif
+
+
+void mirp_init(int nthreads, slong max_prec)
+{
+    mirp_nthreads = (nthreads > 0) ? nthreads : 0;
+
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(mirp_num_threads())
+    #endif
+    mirp_thread_init(max_prec);
+}
+
+
+void mirp_finalize(void)
+{
+    #ifdef _OPENMP
+    /* Workspaces are freed from the global list, since the threads
+     * that created them may not be part of the team below */
+    mirp_workspace_free_all();
+
+    /* The arb/flint caches can only be freed by the thread that owns them */
+    #pragma omp parallel num_threads(mirp_num_threads())
+    #endif
+    flint_cleanup();
+
+    mirp_nthreads = 0;
+}
+
+
+void mirp_thread_init(slong max_prec)
+{
+    assert(max_prec > 0);
+
+    arb_t tmp;
+    arb_init(tmp);
+
+    /* Constants used by the kernels. Arb caches these for
+     * each thread, and reuses them for any lower precision */
+    arb_const_pi(tmp, max_prec);
+    arb_const_sqrt_pi(tmp, max_prec);
+
+    /* Initializes the caches used by exp */
+    arb_one(tmp);
+    arb_exp(tmp, tmp, max_prec);
+
+    arb_clear(tmp);
+}
+
+
+void mirp_thread_cleanup(void)
+{
+    #ifdef _OPENMP
+    mirp_workspace_entry * ws = mirp_workspace_current();
+    if(ws)
+        mirp_workspace_unregister(ws);
+    mirp_workspace = NULL;
+    #endif
+
+    flint_cleanup();
+}
+
+
+int mirp_num_threads(void)
+{
+    #ifdef _OPENMP
+    if(mirp_nthreads > 0)
+        return mirp_nthreads;
+    return omp_get_max_threads();
+    #else
+    return 1;
+    #endif
+}
+
+
+arb_ptr mirp_workspace_get(slong n)
+{
+    assert(n >= 0);
+
+    #ifdef _OPENMP
+    mirp_workspace_entry * ws = mirp_workspace_current();
+
+    if(ws == NULL)
+    {
+        ws = (mirp_workspace_entry *)calloc(1, sizeof(mirp_workspace_entry));
+
+        #pragma omp critical(mirp_workspace_registry)
+        {
+            ws->next = mirp_workspace_list;
+            mirp_workspace_list = ws;
+        }
+
+        mirp_workspace = ws;
+    }
+
+    if(ws->size < n)
+    {
+        if(ws->v)
+            _arb_vec_clear(ws->v, ws->size);
+        ws->v = _arb_vec_init(n);
+        ws->size = n;
+    }
+    return ws->v;
+    #else
+    return _arb_vec_init(n);
+    #endif
+}
+
+
+void mirp_workspace_release(arb_ptr workspace, slong n)
+{
+    #ifdef _OPENMP
+    (void)workspace;
+    (void)n;
+    #else
+    _arb_vec_clear(workspace, n);
+    #endif
+}
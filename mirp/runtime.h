@@ -0,0 +1,109 @@
+/*! \file
+ *
+ * \brief Initialization and cleanup of the MIRP runtime (threads and caches)
+ */
+
+#pragma once
+
+#include <arb.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! \brief Initializes the MIRP runtime
+ *
+ * This sets the number of threads used by MIRP and prepares each of them
+ * (see \ref mirp_thread_init). Calling this is optional - all functions
+ * work without it, but the first calls in each thread will be slower.
+ *
+ * Threads are taken from the OpenMP runtime, which keeps them alive
+ * between parallel regions. Therefore, caches and workspaces kept by each thread
+ * are reused between calls.
+ *
+ * \param [in] nthreads Number of threads that MIRP should use. If less than
+ *                      or equal to zero, the OpenMP default is used. Ignored
+ *                      if MIRP was not compiled with OpenMP support.
+ * \param [in] max_prec Largest working precision expected to be used.
+ *                      Constants are cached to (at least) this precision
+ */
+void mirp_init(int nthreads, slong max_prec);
+
+
+/*! \brief Frees all workspaces, and the caches held by MIRP threads
+ *
+ * All workspaces kept by MIRP are freed, no matter which thread created them
+ * (including threads not created by MIRP, and threads that have since exited).
+ * The caches kept by arb/flint can only be freed by the thread that owns them. They
+ * are freed for the threads of a parallel region of \ref mirp_num_threads threads;
+ * other threads must call \ref mirp_thread_cleanup themselves.
+ *
+ * The number of threads is reset to the default. MIRP may be used (and
+ * initialized) again afterwards. This must not be called while any
+ * MIRP function is running in any thread.
+ */
+void mirp_finalize(void);
+
+
+/*! \brief Prepares the calling thread for use with MIRP
+ *
+ * This computes constants used by the kernels (which are cached by arb for
+ * each thread) up to the given precision.
+ *
+ * This is only needed for threads not created by MIRP itself, and even then
+ * it is optional.
+ *
+ * \param [in] max_prec Largest working precision expected to be used
+ */
+void mirp_thread_init(slong max_prec);
+
+
+/*! \brief Frees caches and workspaces held by the calling thread
+ *
+ * This should be called by threads created outside of MIRP before they exit,
+ * if they have called any MIRP functions. Otherwise, the memory used by arb/flint
+ * caches for that thread is leaked.
+ *
+ * The thread may still call MIRP functions afterwards (caches will be rebuilt).
+ */
+void mirp_thread_cleanup(void);
+
+
+/*! \brief Obtain the number of threads MIRP will use by default
+ *
+ * \return The number of threads set via \ref mirp_init, or the OpenMP
+ *         default if it was not set. Always 1 if MIRP was not compiled with
+ *         OpenMP support.
+ */
+int mirp_num_threads(void);
+
+
+/*! \brief Obtain a workspace for the calling thread
+ *
+ * The returned vector has at least \p n elements, with unspecified
+ * contents. It must be given back via \ref mirp_workspace_release before
+ * another workspace is obtained by the same thread.
+ *
+ * If compiled with OpenMP, the vector is kept by the thread and reused
+ * by later calls (until \ref mirp_thread_cleanup or \ref mirp_finalize). Otherwise,
+ * it is allocated and freed on every use.
+ *
+ * \param [in] n Minimum number of elements
+ * \return Vector of at least \p n elements
+ */
+arb_ptr mirp_workspace_get(slong n);
+
+
+/*! \brief Gives back a workspace obtained via \ref mirp_workspace_get
+ *
+ * \param [in] workspace The workspace to release
+ * \param [in] n         The number of elements that was requested
+ */
+void mirp_workspace_release(arb_ptr workspace, slong n);
+
+
+#ifdef __cplusplus
+}
+#endif
+
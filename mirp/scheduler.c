@@ -0,0 +1,196 @@
+/*! \file
+ *
+ * \brief Distribution of independent tasks over multiple threads
+ */
+
+#include "mirp/scheduler.h"
+#include "mirp/runtime.h"
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#include <sched.h>
+#endif
+
+
+int mirp_scheduler_nthreads(int nthreads)
+{
+    #ifdef _OPENMP
+    if(nthreads <= 0)
+        nthreads = mirp_num_threads();
+    return nthreads;
+    #else
+    (void)nthreads;
+    return 1;
+    #endif
+}
+
+
+void mirp_scheduler_run(long ntasks, int nthreads,
+                        cb_workspace_init ws_init, cb_workspace_clear ws_clear,
+                        cb_task run, void * data)
+{
+    assert(ntasks >= 0);
+    assert(run != NULL);
+
+    const int nth = mirp_scheduler_nthreads(nthreads);
+    (void)nth; /* Unused without OpenMP */
+
+    /* Tasks are handed out dynamically, one at a time.
+     *
+     * With a single thread, the region is not made active, so that
+     * the tasks themselves may still use all threads */
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(nth) if(nth > 1)
+    #endif
+    {
+        void * workspace = ws_init ? ws_init(data) : NULL;
+
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 1)
+        #endif
+        for(long i = 0; i < ntasks; i++)
+            run(i, workspace, data);
+
+        if(ws_clear)
+            ws_clear(workspace, data);
+    }
+}
+
+
+void mirp_scheduler_run_ordered(long ntasks, int nthreads, long window,
+                                cb_workspace_init ws_init, cb_workspace_clear ws_clear,
+                                cb_task run, cb_task_complete complete,
+                                void * data)
+{
+    assert(ntasks >= 0);
+    assert(window > 0);
+    assert(run != NULL);
+    assert(complete != NULL);
+
+    const int nth = mirp_scheduler_nthreads(nthreads);
+
+    if(ntasks == 0)
+        return;
+
+    /* With a single thread, each task is completed right after it is run */
+    if(nth == 1)
+        window = 1;
+    else if(window > ntasks)
+        window = ntasks;
+
+    void ** slots = (void **)malloc((size_t)window * sizeof(void *));
+    char * ready = (char *)calloc((size_t)window, 1);
+    for(long s = 0; s < window; s++)
+        slots[s] = ws_init ? ws_init(data) : NULL;
+
+    /* Index of the next task to be completed, and whether complete asked to stop.
+     * Both are only changed while holding lock, but are read without it
+     * (atomically) by threads waiting for their slot */
+    long next = 0;
+    int stop = 0;
+
+    #ifdef _OPENMP
+    omp_lock_t lock;
+    omp_init_lock(&lock);
+    #endif
+
+    /* Tasks are handed out dynamically, one at a time, in increasing order.
+     * The task with the lowest index that has not been run never has to wait
+     * for its slot (all tasks before it have been completed), so this cannot
+     * deadlock.
+     *
+     * With a single thread, the region is not made active, so that
+     * the tasks themselves may still use all threads */
+    #ifdef _OPENMP
+    #pragma omp parallel num_threads(nth) if(nth > 1)
+    #endif
+    {
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 1)
+        #endif
+        for(long i = 0; i < ntasks; i++)
+        {
+            const long s = i % window;
+            int skip = 0;
+
+            /* Wait until the previous task in this slot has been completed.
+             * The lock is not taken, so waiting threads do not compete with
+             * the thread that is completing tasks. Instead, the processor is
+             * given up to other threads between attempts */
+            for(;;)
+            {
+                long n;
+                #ifdef _OPENMP
+                #pragma omp atomic read
+                #endif
+                n = next;
+
+                #ifdef _OPENMP
+                #pragma omp atomic read
+                #endif
+                skip = stop;
+
+                if(i < n + window || skip)
+                    break;
+
+                #ifdef _OPENMP
+                sched_yield();
+                #endif
+            }
+
+            /* Make the results of completing the slot visible to this thread */
+            #ifdef _OPENMP
+            #pragma omp flush
+            #endif
+
+            if(skip)
+                continue;
+
+            run(i, slots[s], data);
+
+            /* Whoever finishes the next task in order completes
+             * everything that has been run from there */
+            #ifdef _OPENMP
+            omp_set_lock(&lock);
+            #endif
+
+            ready[s] = 1;
+            while(!stop && ready[next % window])
+            {
+                const long n = next % window;
+                ready[n] = 0;
+
+                #ifdef _OPENMP
+                #pragma omp atomic write
+                #endif
+                stop = complete(next, slots[n], data);
+
+                /* The slot must be finished with before it is given to the next task */
+                #ifdef _OPENMP
+                #pragma omp flush
+                #pragma omp atomic write
+                #endif
+                next = next + 1;
+            }
+
+            #ifdef _OPENMP
+            omp_unset_lock(&lock);
+            #endif
+        }
+    }
+
+    #ifdef _OPENMP
+    omp_destroy_lock(&lock);
+    #endif
+
+    for(long s = 0; s < window; s++)
+    {
+        if(ws_clear)
+            ws_clear(slots[s], data);
+    }
+
+    free(slots);
+    free(ready);
+}
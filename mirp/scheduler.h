@@ -0,0 +1,120 @@
+/*! \file
+ *
+ * \brief Distribution of independent tasks (such as shell quartets)
+ *        over multiple threads
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! \brief Pointer to a function that creates a per-thread (or per-slot) workspace
+ *
+ * The returned pointer is passed unchanged to every task run by that thread
+ * (or stored in that slot).
+ */
+typedef void * (*cb_workspace_init)(void * data);
+
+
+/*! \brief Pointer to a function that destroys a per-thread (or per-slot) workspace */
+typedef void (*cb_workspace_clear)(void * workspace, void * data);
+
+
+/*! \brief Pointer to a function that runs a single task
+ *
+ * The first argument is the index of the task.
+ */
+typedef void (*cb_task)(long, void * workspace, void * data);
+
+
+/*! \brief Pointer to a function that completes a single task
+ *
+ * The first argument is the index of the task. If nonzero is returned,
+ * no further tasks are started or completed.
+ */
+typedef int (*cb_task_complete)(long, void * workspace, void * data);
+
+
+/*! \brief Obtain the number of threads that will be used by the scheduler
+ *
+ * \param [in] nthreads Requested number of threads. If less than
+ *                      or equal to zero, the default (see \ref mirp_num_threads) is used.
+ * \return The number of threads that would be used. This is always 1 if
+ *         MIRP was not compiled with OpenMP support.
+ */
+int mirp_scheduler_nthreads(int nthreads);
+
+
+/*! \brief Runs a number of independent tasks over multiple threads
+ *
+ * Tasks are handed out one at a time to whichever thread becomes free, so
+ * tasks of very different cost (for example, shell quartets of different
+ * angular momentum) are still balanced across threads. Expensive tasks should
+ * be given small indices where possible.
+ *
+ * Each thread creates its own workspace via \p ws_init before running any task,
+ * and destroys it with \p ws_clear after all tasks have been run. Both may
+ * be NULL, in which case the workspace is NULL.
+ *
+ * Any parallel regions within \p run are executed by a single thread, unless
+ * only one thread is used by the scheduler.
+ *
+ * \param [in] ntasks   The number of tasks to run. Tasks are numbered from 0 to \p ntasks - 1
+ * \param [in] nthreads Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] ws_init  Function to create a per-thread workspace (may be NULL)
+ * \param [in] ws_clear Function to destroy a per-thread workspace (may be NULL)
+ * \param [in] run      Function that runs a single task
+ * \param [in] data     Arbitrary data to pass to all the callbacks
+ */
+void mirp_scheduler_run(long ntasks, int nthreads,
+                        cb_workspace_init ws_init, cb_workspace_clear ws_clear,
+                        cb_task run, void * data);
+
+
+/*! \brief Runs a number of independent tasks over multiple threads, and completes
+ *         them in task order
+ *
+ * Tasks are handed out as in \ref mirp_scheduler_run. The result of each task
+ * is kept in one of \p window slots (task \p i uses slot `i % window`), each with its
+ * own workspace created by \p ws_init. After a task has been run, the thread that
+ * ran it calls \p complete for all tasks that are next in order and have been run.
+ * Calls to \p complete are made strictly in order of the task index and
+ * never concurrently, but may be made from any thread. This can be used to
+ * write results in a deterministic order.
+ *
+ * A finished task does not wait for the tasks before it, so a single slow task
+ * does not hold up the other threads. A task is only started once its slot has been
+ * completed for the task \p window places before it. At most \p window results are
+ * therefore held at any time, regardless of the number of tasks. A thread that
+ * waits for its slot yields the processor between checks (without taking the lock
+ * used for \p complete), but \p window should still be several times the number
+ * of threads so that this is rare.
+ *
+ * If \p complete returns nonzero, tasks that have not yet been started are skipped,
+ * and \p complete is not called again.
+ *
+ * Any parallel regions within \p run are executed by a single thread, unless
+ * only one thread is used by the scheduler.
+ *
+ * \param [in] ntasks   The number of tasks to run. Tasks are numbered from 0 to \p ntasks - 1
+ * \param [in] nthreads Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] window   Number of slots (at least 1). Only one slot is used with a single thread.
+ * \param [in] ws_init  Function to create the workspace of a slot (may be NULL)
+ * \param [in] ws_clear Function to destroy the workspace of a slot (may be NULL)
+ * \param [in] run      Function that runs a single task, given the workspace of its slot
+ * \param [in] complete Function to call, in task order, after a task has been run
+ * \param [in] data     Arbitrary data to pass to all the callbacks
+ */
+void mirp_scheduler_run_ordered(long ntasks, int nthreads, long window,
+                                cb_workspace_init ws_init, cb_workspace_clear ws_clear,
+                                cb_task run, cb_task_complete complete,
+                                void * data);
+
+
+#ifdef __cplusplus
+}
+#endif
+
@@ -3,12 +3,29 @@
  * \brief Functions related to gaussians and shells
  */
 
+#pragma once
+
 #include <arb.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*! \brief A contracted shell of gaussians (double precision)
+ *
+ * The shell does not own the exponent and coefficient arrays.
+ */
+typedef struct
+{
+    int am;               /*!< Angular momentum of the shell (0 = s, 1 = p, etc) */
+    int nprim;            /*!< Number of primitives in the shell */
+    int ngeneral;         /*!< Number of general contractions in the shell */
+    double xyz[3];        /*!< XYZ coordinates of the center of the shell */
+    const double * alpha; /*!< Exponents of the shell (length \p nprim) */
+    const double * coeff; /*!< Unnormalized contraction coefficients (length \p nprim * \p ngeneral) */
+} mirp_shell;
+
+
 /*! \brief Number of cartesian functions for a given angular momentum */
 #define MIRP_NCART(am) ((((am)+1)*((am)+2))/2)
 
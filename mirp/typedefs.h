@@ -44,6 +44,20 @@ typedef void (*cb_integral4_single_exact)(double * integral,
                                           const int * lmn4, const double * D, double alpha4);
 
 
+/*! \brief Pointer to a function that computes an upper bound of the magnitude
+ *         of all cartesian integrals of a primitive quartet (four-center)
+ *
+ * The arguments are the output bound, followed by the angular momentum, center,
+ * and exponent of each of the four primitives, and the working precision.
+ */
+typedef void (*cb_integral4_bound)(mag_t,
+                                   int, arb_srcptr, const arb_t,
+                                   int, arb_srcptr, const arb_t,
+                                   int, arb_srcptr, const arb_t,
+                                   int, arb_srcptr, const arb_t,
+                                   slong);
+
+
 /*! \brief Pointer to a function that computes all cartesian integrals
  *         for a contracted shell quartet (four-center, interval arithmetic)
  */
@@ -68,13 +82,37 @@ typedef void (*cb_integral4_str)(arb_ptr,
 
 /*! \brief Pointer to a function that computes all cartesian integrals
  *         for a contracted shell quartet to exact double precision (four-center)
+ *
+ * The return value is the number of integrals that may not be correctly rounded.
  */
-typedef void (*cb_integral4_exact)(double *,
+typedef long (*cb_integral4_exact)(double *,
                                    int, const double *, int, int, const double *, const double *,
                                    int, const double *, int, int, const double *, const double *,
                                    int, const double *, int, int, const double *, const double *,
                                    int, const double *, int, int, const double *, const double *);
 
+
+/*! \brief Pointer to a function that receives all cartesian integrals
+ *         for a contracted shell quartet (four-center, interval arithmetic)
+ *
+ * The arguments are the indices of the four shells (length 4), the integrals,
+ * the number of integrals, and arbitrary user data. A nonzero return value
+ * stops the calculation (no more quartets are passed to the function).
+ */
+typedef int (*cb_integral4_sink)(const int * shells, arb_srcptr integrals,
+                                 long nintegrals, void * data);
+
+
+/*! \brief Pointer to a function that receives all cartesian integrals
+ *         for a contracted shell quartet (four-center, exact double precision)
+ *
+ * The arguments are the indices of the four shells (length 4), the integrals,
+ * the number of integrals, and arbitrary user data. A nonzero return value
+ * stops the calculation (no more quartets are passed to the function).
+ */
+typedef int (*cb_integral4_sink_exact)(const int * shells, const double * integrals,
+                                       long nintegrals, void * data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+/*! \file
+ *
+ * \brief Helpers for reading and writing binary files
+ */
+
+#include "mirp_bin/binary_io.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define MIRP_HAVE_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace mirp {
+
+bool file_has_magic(const std::string & filepath, const char * magic, size_t size)
+{
+    std::ifstream fs(filepath, std::ifstream::binary);
+    std::vector<char> buf(size);
+
+    if(!fs.read(buf.data(), static_cast<std::streamsize>(size)))
+        return false;
+    return std::memcmp(buf.data(), magic, size) == 0;
+}
+
+
+void file_truncate(const std::string & filepath, uint64_t size)
+{
+    const std::string err = "Error truncating file " + filepath + ": ";
+
+    std::ifstream fs(filepath, std::ifstream::binary | std::ifstream::ate);
+    if(!fs.is_open())
+        throw std::runtime_error(err + "Cannot open file");
+    if(static_cast<uint64_t>(fs.tellg()) < size)
+        throw std::runtime_error(err + "File is shorter than expected");
+
+    #ifdef MIRP_HAVE_MMAP
+    fs.close();
+    if(truncate(filepath.c_str(), static_cast<off_t>(size)) != 0)
+        throw std::runtime_error(err + "Cannot truncate the file");
+    #else
+    // Rewrite the part of the file that is kept
+    std::vector<char> buf(static_cast<size_t>(size));
+    fs.seekg(0);
+    if(!fs.read(buf.data(), static_cast<std::streamsize>(size)))
+        throw std::runtime_error(err + "Cannot read the file");
+    fs.close();
+
+    std::ofstream out(filepath, std::ofstream::binary | std::ofstream::trunc);
+    if(!out.write(buf.data(), static_cast<std::streamsize>(size)))
+        throw std::runtime_error(err + "Cannot write the file");
+    #endif
+}
+
+
+mapped_file::mapped_file(const std::string & filepath)
+    : data_(nullptr), size_(0), mapped_(false)
+{
+    const std::string err = "Error reading file " + filepath + ": ";
+
+    #ifdef MIRP_HAVE_MMAP
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error(err + "Cannot open file");
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error(err + "Cannot determine the size of the file");
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if(size_ > 0)
+    {
+        void * p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error(err + "Cannot map the file into memory");
+        }
+
+        data_ = static_cast<const unsigned char *>(p);
+        mapped_ = true;
+    }
+    close(fd);
+    #else
+    std::ifstream fs(filepath, std::ifstream::binary | std::ifstream::ate);
+    if(!fs.is_open())
+        throw std::runtime_error(err + "Cannot open file");
+
+    size_ = static_cast<size_t>(fs.tellg());
+    fs.seekg(0);
+
+    unsigned char * buf = new unsigned char[size_ > 0 ? size_ : 1];
+    if(!fs.read(reinterpret_cast<char *>(buf), static_cast<std::streamsize>(size_)))
+    {
+        delete [] buf;
+        throw std::runtime_error(err + "Cannot read the file");
+    }
+    data_ = buf;
+    #endif
+}
+
+
+mapped_file::~mapped_file(void)
+{
+    if(data_ == nullptr)
+        return;
+
+    #ifdef MIRP_HAVE_MMAP
+    if(mapped_)
+        munmap(const_cast<unsigned char *>(data_), size_);
+    #else
+    delete [] data_;
+    #endif
+}
+
+} // close namespace mirp
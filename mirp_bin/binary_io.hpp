@@ -0,0 +1,131 @@
+/*! \file
+ *
+ * \brief Helpers for reading and writing binary files
+ *
+ * All binary files written by MIRP are little-endian, regardless
+ * of the host, and are read through a \ref mapped_file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mirp {
+
+
+/*! \brief Reads an unsigned little-endian integer of \p nbytes bytes */
+inline uint64_t load_le(const unsigned char * p, int nbytes)
+{
+    uint64_t v = 0;
+    for(int i = nbytes-1; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+
+/*! \brief Writes an unsigned little-endian integer of \p nbytes bytes */
+inline void store_le(unsigned char * p, uint64_t v, int nbytes)
+{
+    for(int i = 0; i < nbytes; i++)
+    {
+        p[i] = static_cast<unsigned char>(v & 0xFF);
+        v >>= 8;
+    }
+}
+
+
+/*! \brief Reads a little-endian double */
+inline double load_double(const unsigned char * p)
+{
+    const uint64_t bits = load_le(p, 8);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+
+/*! \brief Writes a little-endian double */
+inline void store_double(unsigned char * p, double d)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(d));
+    store_le(p, bits, 8);
+}
+
+
+/*! \brief Appends an unsigned little-endian integer to a buffer */
+inline void append_le(std::vector<unsigned char> & buf, uint64_t v, int nbytes)
+{
+    const size_t pos = buf.size();
+    buf.resize(pos + static_cast<size_t>(nbytes));
+    store_le(buf.data() + pos, v, nbytes);
+}
+
+
+/*! \brief Appends a little-endian double to a buffer */
+inline void append_double(std::vector<unsigned char> & buf, double d)
+{
+    const size_t pos = buf.size();
+    buf.resize(pos + 8);
+    store_double(buf.data() + pos, d);
+}
+
+
+/*! \brief Determines if a file starts with the given magic string
+ *
+ * \param [in] filepath Path to the file to check
+ * \param [in] magic    The magic string (without a terminating null)
+ * \param [in] size     Length of the magic string
+ */
+bool file_has_magic(const std::string & filepath, const char * magic, size_t size);
+
+
+/*! \brief Shortens a file to the given size
+ *
+ * \throw std::runtime_error if the file cannot be truncated, or is
+ *        shorter than \p size
+ *
+ * \param [in] filepath Path to the file
+ * \param [in] size     New size of the file (bytes)
+ */
+void file_truncate(const std::string & filepath, uint64_t size);
+
+
+/*! \brief The contents of a file, opened for reading
+ *
+ * The file is memory mapped where supported (and read into memory otherwise).
+ */
+class mapped_file
+{
+public:
+    /*! \brief Opens and maps a file
+     *
+     * \throw std::runtime_error if the file cannot be opened or mapped
+     *
+     * \param [in] filepath Path to the file
+     */
+    explicit mapped_file(const std::string & filepath);
+
+    ~mapped_file(void);
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+
+    /*! \brief Contents of the file (nullptr for empty files) */
+    const unsigned char * data(void) const { return data_; }
+
+    /*! \brief Size of the file in bytes */
+    size_t size(void) const { return size_; }
+
+
+private:
+    const unsigned char * data_;  /*!< Contents of the file */
+    size_t size_;                 /*!< Size of the file in bytes */
+    bool mapped_;                 /*!< Whether data_ is memory mapped (or allocated) */
+};
+
+} // close namespace mirp
@@ -8,6 +8,7 @@
 #include <array>
 #include <vector>
 #include <mirp/typedefs.h>
+#include <mirp/basis.h>
 
 namespace mirp {
 
@@ -62,7 +63,7 @@ struct callback_helper<4>
     }
 
 
-    static void
+    static long
     call_exact(double * integrals,
                std::array<int, 4> & am,
                std::array<std::array<double, 3>, 4> & xyz,
@@ -72,11 +73,27 @@ struct callback_helper<4>
                std::array<std::vector<double>, 4> & coeff,
                cb_exact_type cb)
     {
-        cb(integrals,
-           am[0], xyz[0].data(), nprim[0], ngeneral[0], alpha[0].data(), coeff[0].data(),
-           am[1], xyz[1].data(), nprim[1], ngeneral[1], alpha[1].data(), coeff[1].data(),
-           am[2], xyz[2].data(), nprim[2], ngeneral[2], alpha[2].data(), coeff[2].data(),
-           am[3], xyz[3].data(), nprim[3], ngeneral[3], alpha[3].data(), coeff[3].data());
+        return cb(integrals,
+                  am[0], xyz[0].data(), nprim[0], ngeneral[0], alpha[0].data(), coeff[0].data(),
+                  am[1], xyz[1].data(), nprim[1], ngeneral[1], alpha[1].data(), coeff[1].data(),
+                  am[2], xyz[2].data(), nprim[2], ngeneral[2], alpha[2].data(), coeff[2].data(),
+                  am[3], xyz[3].data(), nprim[3], ngeneral[3], alpha[3].data(), coeff[3].data());
+    }
+
+
+    static long
+    call_exact_basis(double * integrals,
+                     const mirp_basis * b,
+                     const std::array<size_t, 4> & idx,
+                     cb_exact_type cb)
+    {
+        const size_t i = idx[0], j = idx[1], k = idx[2], l = idx[3];
+
+        return cb(integrals,
+                  b->am[i], b->xyz + 3*i, b->nprim[i], b->ngeneral[i], b->alpha + b->prim_start[i], b->coeff + b->coeff_start[i],
+                  b->am[j], b->xyz + 3*j, b->nprim[j], b->ngeneral[j], b->alpha + b->prim_start[j], b->coeff + b->coeff_start[j],
+                  b->am[k], b->xyz + 3*k, b->nprim[k], b->ngeneral[k], b->alpha + b->prim_start[k], b->coeff + b->coeff_start[k],
+                  b->am[l], b->xyz + 3*l, b->nprim[l], b->ngeneral[l], b->alpha + b->prim_start[l], b->coeff + b->coeff_start[l]);
     }
 
 
@@ -0,0 +1,295 @@
+/*! \file
+ *
+ * \brief Checks of basis set screening and of computing integrals over a basis
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/kernels/all.h>
+#include <mirp/basis.h>
+#include <mirp/shell.h>
+
+#include <vector>
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief Working precision used in the checks (same as for screening) */
+const slong check_prec = 128;
+
+
+/*! \brief A quartet received from mirp_gtoeri_basis */
+struct sink_quartet
+{
+    int shells[4];
+    std::vector<double> integrals;  //!< Midpoints of the integrals
+    std::vector<double> radii;      //!< Radii of the integrals
+};
+
+
+/*! \brief Copies the midpoints and radii of the integrals of a quartet */
+sink_quartet copy_quartet(const int * shells, arb_srcptr integrals, long nintegrals)
+{
+    sink_quartet q;
+    for(int i = 0; i < 4; i++)
+        q.shells[i] = shells[i];
+
+    for(long i = 0; i < nintegrals; i++)
+    {
+        q.integrals.push_back(arf_get_d(arb_midref(integrals + i), ARF_RND_NEAR));
+        q.radii.push_back(mag_get_d(arb_radref(integrals + i)));
+    }
+
+    return q;
+}
+
+
+/*! \brief Stores every quartet passed to the sink */
+int store_quartet(const int * shells, arb_srcptr integrals, long nintegrals, void * data)
+{
+    std::vector<sink_quartet> * v = static_cast<std::vector<sink_quartet> *>(data);
+    v->push_back(copy_quartet(shells, integrals, nintegrals));
+    return 0;
+}
+
+
+/*! \brief Computes a shell quartet of a basis
+ *
+ * \return The number of integrals. The largest magnitude is stored in \p max_mag
+ */
+long compute_quartet(const mirp_basis & b, const int * idx, mag_t max_mag, arb_ptr integrals)
+{
+    const int i = idx[0], j = idx[1], k = idx[2], l = idx[3];
+
+    mirp_gtoeri(integrals,
+                b.am[i], b.xyz_arb + 3*i, b.nprim[i], b.ngeneral[i], b.alpha_arb + b.prim_start[i], b.coeff_arb + b.coeff_start[i],
+                b.am[j], b.xyz_arb + 3*j, b.nprim[j], b.ngeneral[j], b.alpha_arb + b.prim_start[j], b.coeff_arb + b.coeff_start[j],
+                b.am[k], b.xyz_arb + 3*k, b.nprim[k], b.ngeneral[k], b.alpha_arb + b.prim_start[k], b.coeff_arb + b.coeff_start[k],
+                b.am[l], b.xyz_arb + 3*l, b.nprim[l], b.ngeneral[l], b.alpha_arb + b.prim_start[l], b.coeff_arb + b.coeff_start[l],
+                check_prec);
+
+    const long n = mirp_basis_nfunction(&b, i) * mirp_basis_nfunction(&b, j)
+                 * mirp_basis_nfunction(&b, k) * mirp_basis_nfunction(&b, l);
+
+    mag_t tmp;
+    mag_init(tmp);
+    mag_zero(max_mag);
+
+    for(long m = 0; m < n; m++)
+    {
+        arb_get_mag(tmp, integrals + m);
+        mag_max(max_mag, max_mag, tmp);
+    }
+
+    mag_clear(tmp);
+    return n;
+}
+
+
+/*! \brief Shells of the test basis
+ *
+ * Three centers at increasing distance, each with a tight and a diffuse
+ * s shell, so that some pairs are negligible. The first center also has a p shell.
+ */
+std::vector<mirp_shell> screen_shells(void)
+{
+    static const double alpha_s[2] = { 5.0, 0.8 };
+    static const double coeff_s[2] = { 0.6, 0.45 };
+    static const double alpha_d[1] = { 0.11 };
+    static const double coeff_d[1] = { 1.0 };
+    static const double alpha_p[1] = { 1.2 };
+    static const double coeff_p[1] = { 1.0 };
+    static const double z[3] = { 0.0, 3.0, 9.0 };
+
+    std::vector<mirp_shell> shells;
+    for(double zc : z)
+    {
+        mirp_shell s = { 0, 2, 1, { 0.0, 0.5, zc }, alpha_s, coeff_s };
+        mirp_shell d = { 0, 1, 1, { 0.0, 0.5, zc }, alpha_d, coeff_d };
+        shells.push_back(s);
+        shells.push_back(d);
+    }
+
+    mirp_shell p = { 1, 1, 1, { 0.0, 0.5, z[0] }, alpha_p, coeff_p };
+    shells.push_back(p);
+
+    return shells;
+}
+
+} // close anonymous namespace
+
+
+long check_basis_screen(int nthreads)
+{
+    const double thresholds[4] = { 0.0, 1e-10, 1e-4, 1e-2 };
+    const std::vector<mirp_shell> shells = screen_shells();
+    const int nshell = static_cast<int>(shells.size());
+
+    /* A quartet of p shells has the most integrals */
+    arb_ptr integrals = _arb_vec_init(81);
+
+    mag_t max_mag, diag_lower, tmp;
+    arf_t diag_arf;
+    arf_init(diag_arf);
+    mag_init(max_mag);
+    mag_init(diag_lower);
+    mag_init(tmp);
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(double threshold : thresholds)
+    {
+        mirp_basis basis;
+        mirp_basis_init(&basis, nshell, shells.data());
+
+        /* All shell pairs, before screening */
+        std::vector<int> all_pairs(basis.pair_shells, basis.pair_shells + 2*basis.npair);
+        const long nall = basis.npair;
+
+        mirp_basis_screen(&basis, threshold, nthreads, mirp_gtoeri);
+
+        /* Brute force: every integral involving a removed pair must be below the
+         * threshold, and a kept pair must have a bound that does not rule it out */
+        const double threshold2 = threshold * threshold;
+        double max_diag = 0.0;
+        std::vector<double> diag(static_cast<size_t>(nall));
+
+        for(long p = 0; p < nall; p++)
+        {
+            const int idx[4] = { all_pairs[2*p], all_pairs[2*p+1], all_pairs[2*p], all_pairs[2*p+1] };
+            const long n = compute_quartet(basis, idx, max_mag, integrals);
+
+            mag_zero(diag_lower);
+            for(long m = 0; m < n; m++)
+            {
+                arb_get_mag_lower(tmp, integrals + m);
+                mag_max(diag_lower, diag_lower, tmp);
+            }
+
+            arf_set_mag(diag_arf, diag_lower);
+            diag[static_cast<size_t>(p)] = arf_get_d(diag_arf, ARF_RND_DOWN);
+            if(diag[static_cast<size_t>(p)] > max_diag)
+                max_diag = diag[static_cast<size_t>(p)];
+        }
+
+        long kept = 0;
+        for(long p = 0; p < nall; p++)
+        {
+            const int i = all_pairs[2*p];
+            const int j = all_pairs[2*p+1];
+
+            const bool is_kept = (kept < basis.npair && basis.pair_shells[2*kept] == i
+                                                    && basis.pair_shells[2*kept+1] == j);
+
+            if(is_kept)
+            {
+                /* The bound must be valid, and must not allow removing the pair */
+                const double bound = basis.pair_bound[kept];
+                if(bound < diag[static_cast<size_t>(p)] ||
+                   diag[static_cast<size_t>(p)] * max_diag < threshold2 * (1.0 - 1e-12))
+                {
+                    std::cout << "Threshold " << threshold << ": pair " << i << " " << j
+                              << " is kept with bound " << bound
+                              << " (lower bound of |(ij|ij)| is " << diag[static_cast<size_t>(p)] << ")\n";
+                    nfailed++;
+                }
+
+                kept++;
+                ntests++;
+                continue;
+            }
+
+            /* Removed pair. Check every quartet with it */
+            for(long q = 0; q < nall; q++)
+            {
+                const int idx[4] = { i, j, all_pairs[2*q], all_pairs[2*q+1] };
+                compute_quartet(basis, idx, max_mag, integrals);
+
+                if(mag_get_d(max_mag) >= threshold)
+                {
+                    std::cout << "Threshold " << threshold << ": pair " << i << " " << j
+                              << " was removed, but (" << idx[0] << idx[1] << "|" << idx[2] << idx[3]
+                              << ") has an integral of magnitude " << mag_get_d(max_mag) << "\n";
+                    nfailed++;
+                }
+
+                ntests++;
+            }
+        }
+
+        /* Any pairs left over are out of order, or not pairs of the basis */
+        if(kept != basis.npair)
+        {
+            std::cout << "Threshold " << threshold << ": pair list has " << basis.npair - kept
+                      << " unexpected pairs\n";
+            nfailed++;
+        }
+        ntests++;
+
+        if(threshold > 0.0 && basis.npair == nall)
+            std::cout << "Threshold " << threshold << ": no pairs were removed\n";
+
+        /* All quartets of the remaining pairs through the basis driver. Quartets
+         * that are not passed to the sink must be negligible, and the rest must be
+         * identical to computing them one at a time */
+        std::vector<sink_quartet> received;
+        mirp_gtoeri_basis(&basis, nthreads, check_prec, store_quartet, &received);
+
+        size_t next = 0;
+        for(long p = 0; p < basis.npair; p++)
+        for(long q = 0; q <= p; q++)
+        {
+            const int idx[4] = { basis.pair_shells[2*p], basis.pair_shells[2*p+1],
+                                 basis.pair_shells[2*q], basis.pair_shells[2*q+1] };
+            const long n = compute_quartet(basis, idx, max_mag, integrals);
+
+            bool found = next < received.size();
+            for(int c = 0; c < 4 && found; c++)
+                found = (received[next].shells[c] == idx[c]);
+
+            bool ok;
+            if(found)
+            {
+                const sink_quartet & r = received[next++];
+                const sink_quartet ref = copy_quartet(idx, integrals, n);
+                ok = (r.integrals == ref.integrals && r.radii == ref.radii);
+            }
+            else
+                ok = (threshold > 0.0 && mag_get_d(max_mag) < threshold);
+
+            if(!ok)
+            {
+                std::cout << "Threshold " << threshold << ": quartet (" << idx[0] << idx[1] << "|"
+                          << idx[2] << idx[3] << ") " << (found ? "differs" : "is missing") << "\n";
+                nfailed++;
+            }
+
+            ntests++;
+        }
+
+        if(next != received.size())
+        {
+            std::cout << "Threshold " << threshold << ": sink received "
+                      << received.size() - next << " unexpected quartets\n";
+            nfailed++;
+        }
+        ntests++;
+
+        mirp_basis_clear(&basis);
+    }
+
+    _arb_vec_clear(integrals, 81);
+    mag_clear(max_mag);
+    mag_clear(diag_lower);
+    mag_clear(tmp);
+    arf_clear(diag_arf);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
@@ -0,0 +1,630 @@
+/*! \file
+ *
+ * \brief Checks of the exact (double precision) wrappers
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+#include "mirp_bin/reffile_io.hpp"
+
+#include <mirp/kernels/all.h>
+#include <mirp/shell.h>
+#include <mirp/math.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief A contracted shell quartet used in the checks */
+struct exact_quartet
+{
+    int am[4];
+    double xyz[4][3];
+    int nprim;
+    int ngen;
+    std::vector<double> alpha;  //!< Exponents (shared by all shells)
+    std::vector<double> coeff;  //!< Coefficients (shared by all shells)
+};
+
+
+/*! \brief Quartets used in the checks
+ *
+ * In the first set, the exponents range from very tight to diffuse, and the
+ * centers are far apart, so that some primitive quartets are negligible.
+ * In the second set, the first general contraction is the difference of two
+ * primitives with nearly equal exponents. Components with that contraction lose
+ * many bits to cancellation, so they converge at a higher precision than the rest.
+ * The third set only has that contraction (without general contractions).
+ */
+std::vector<exact_quartet> exact_quartets(void)
+{
+    const int am[4][4] = { { 0, 0, 0, 0 }, { 1, 0, 1, 0 }, { 1, 1, 0, 0 }, { 1, 1, 1, 0 } };
+    const double xyz[2][4][3] = { { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 3.0 },
+                                    { 4.0, 0.0, 0.0 }, { 4.0, 0.5, 3.0 } },
+                                  { { 0.1, -0.2, 0.3 }, { 0.1, 1.2, 0.3 },
+                                    { -0.7, 0.4, 0.3 }, { 0.25, 0.5, -0.125 } } };
+    const std::vector<double> alpha[3] = { { 80.0, 1.1, 0.13 },
+                                           { 1.0, 1.0 + DBL_EPSILON, 0.3 },
+                                           { 1.0, 1.0 + DBL_EPSILON, 0.3 } };
+    const std::vector<double> coeff[3] = { { 0.05, 0.6, 0.4, -0.02, 0.5, 1.0 },
+                                           { 1.0, -1.0, 0.0, 0.2, 0.5, 0.7 },
+                                           { 1.0, -1.0, 0.0 } };
+
+    std::vector<exact_quartet> ret;
+
+    for(int set = 0; set < 3; set++)
+    for(const auto & a : am)
+    {
+        exact_quartet q;
+        q.nprim = 3;
+        q.ngen = (set < 2 ? 2 : 1);
+        q.alpha = alpha[set];
+        q.coeff = coeff[set];
+
+        for(int n = 0; n < 4; n++)
+        {
+            q.am[n] = a[n];
+            for(int c = 0; c < 3; c++)
+                q.xyz[n][c] = xyz[set == 0 ? 0 : 1][n][c];
+        }
+
+        ret.push_back(q);
+    }
+
+    return ret;
+}
+
+
+/*! \brief Number of integrals of a quartet */
+size_t exact_nintegrals(const exact_quartet & q)
+{
+    const size_t ngen = static_cast<size_t>(q.ngen);
+    return MIRP_NCART4(q.am[0], q.am[1], q.am[2], q.am[3]) * ngen*ngen*ngen*ngen;
+}
+
+
+/*! \brief Computes a quartet with mirp_integral4_exact_screened */
+std::vector<double> compute_exact_screened(const exact_quartet & q, cb_integral4_bound cb_bound)
+{
+    std::vector<double> ret(exact_nintegrals(q));
+    const double * a = q.alpha.data();
+    const double * c = q.coeff.data();
+
+    mirp_integral4_exact_screened(ret.data(),
+                                  q.am[0], q.xyz[0], q.nprim, q.ngen, a, c,
+                                  q.am[1], q.xyz[1], q.nprim, q.ngen, a, c,
+                                  q.am[2], q.xyz[2], q.nprim, q.ngen, a, c,
+                                  q.am[3], q.xyz[3], q.nprim, q.ngen, a, c,
+                                  mirp_gtoeri_single, cb_bound);
+    return ret;
+}
+
+
+/*! \brief Compares two sets of exact integrals bit for bit */
+bool compare_exact(const exact_quartet & q, const char * desc,
+                   const std::vector<double> & result, const std::vector<double> & ref)
+{
+    if(result.size() == ref.size() &&
+       std::memcmp(result.data(), ref.data(), result.size() * sizeof(double)) == 0)
+        return true;
+
+    std::cout << "Quartet " << q.am[0] << q.am[1] << q.am[2] << q.am[3] << " " << desc << ":\n";
+    for(size_t i = 0; i < result.size() && i < ref.size(); i++)
+    {
+        if(std::memcmp(&result[i], &ref[i], sizeof(double)) == 0)
+            continue;
+
+        std::cout << "    integral " << i << ": ";
+        write_hexdouble(result[i], std::cout);
+        std::cout << " vs ";
+        write_hexdouble(ref[i], std::cout);
+        std::cout << "\n";
+    }
+
+    return false;
+}
+
+
+/*! \brief Largest working precision passed to recording_single */
+std::atomic<slong> recorded_prec(0);
+
+
+/*! \brief Computes a primitive integral with mirp_gtoeri_single, and records the working precision */
+void recording_single(arb_t integral,
+                      const int * lmn1, arb_srcptr A, const arb_t alpha1,
+                      const int * lmn2, arb_srcptr B, const arb_t alpha2,
+                      const int * lmn3, arb_srcptr C, const arb_t alpha3,
+                      const int * lmn4, arb_srcptr D, const arb_t alpha4,
+                      slong working_prec)
+{
+    slong prev = recorded_prec.load();
+    while(prev < working_prec && !recorded_prec.compare_exchange_weak(prev, working_prec))
+        ;
+
+    mirp_gtoeri_single(integral, lmn1, A, alpha1, lmn2, B, alpha2,
+                                 lmn3, C, alpha3, lmn4, D, alpha4, working_prec);
+}
+
+
+/*! \brief Checks a value computed with a tolerance against a very high precision reference
+ *
+ * Values that are not flagged as inexact must be correctly rounded. Flagged
+ * values, and their exact results, must be within the tolerance.
+ */
+bool check_tol_value(double result, char inexact, const arb_t ref, slong ref_prec, double tol)
+{
+    double ref_dbl;
+    mirp_format_set_arb(&ref_dbl, 0, ref, MIRP_BINARY64);
+
+    if(!mirp_format_certified(ref, MIRP_BINARY64, ref_prec))
+        throw std::logic_error("Reference value is not certified. Contact the developer");
+
+    if(!inexact)
+        return std::memcmp(&result, &ref_dbl, sizeof(double)) == 0;
+
+    /* The library uses a lower bound of the largest value for the
+     * relative tolerance, so its tolerance can only be smaller */
+    const double limit = tol * (1.0 + 1e-10);
+    return std::fabs(result) <= limit && std::fabs(ref_dbl) <= limit;
+}
+
+
+/*! \brief Tolerance (as used by the target_tol functions) for the exact values in \p ref */
+double tol_limit(arb_srcptr ref, long n, double abs_tol, double rel_tol)
+{
+    double max_ref = 0.0;
+    for(long i = 0; i < n; i++)
+        max_ref = std::max(max_ref, std::fabs(arf_get_d(arb_midref(ref + i), ARF_RND_NEAR)));
+    return std::max(abs_tol, rel_tol * max_ref);
+}
+
+} // close anonymous namespace
+
+
+long check_exact_masked(void)
+{
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(const auto & q : exact_quartets())
+    {
+        /* Converged components are kept between rounds (without abandoning any) */
+        std::vector<double> masked = compute_exact_screened(q, NULL);
+
+        /* The entire quartet is recomputed in every round */
+        std::vector<double> full(exact_nintegrals(q));
+        const double * a = q.alpha.data();
+        const double * c = q.coeff.data();
+
+        mirp_integral4_exact(full.data(),
+                             q.am[0], q.xyz[0], q.nprim, q.ngen, a, c,
+                             q.am[1], q.xyz[1], q.nprim, q.ngen, a, c,
+                             q.am[2], q.xyz[2], q.nprim, q.ngen, a, c,
+                             q.am[3], q.xyz[3], q.nprim, q.ngen, a, c,
+                             mirp_gtoeri);
+
+        if(!compare_exact(q, "differs when keeping converged components", masked, full))
+            nfailed++;
+        ntests++;
+    }
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+
+long check_exact_abandon(void)
+{
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(const auto & q : exact_quartets())
+    {
+        /* Components that can no longer converge at the current precision
+         * are abandoned part way through */
+        std::vector<double> abandoned = compute_exact_screened(q, mirp_gtoeri_bound);
+
+        /* Without a bound, every component is computed to completion */
+        std::vector<double> complete = compute_exact_screened(q, NULL);
+
+        if(!compare_exact(q, "differs when abandoning components", abandoned, complete))
+            nfailed++;
+        ntests++;
+    }
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+
+long check_exact_prec(void)
+{
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    /* Starting precision: the target plus the estimated loss, rounded up to a
+     * multiple of 64 (and at least 64 extra bits). Unreasonable estimates are ignored */
+    const struct { slong target; double loss; slong expected; } start[] = {
+        { 64, 0.0, 128 }, { 64, 64.0, 128 }, { 64, 64.5, 192 }, { 64, 200.0, 320 },
+        { 124, 10.0, 188 }, { 124, 129.0, 316 }, { 64, -5.0, 128 }, { 64, 1e9, 128 },
+        { 64, NAN, 128 }, { 64, INFINITY, 128 } };
+
+    for(const auto & st : start)
+    {
+        const slong prec = mirp_exact_start_prec(st.target, st.loss);
+        if(prec != st.expected)
+        {
+            std::cout << "mirp_exact_start_prec(" << st.target << ", " << st.loss << ") = "
+                      << prec << " (expected " << st.expected << ")\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    /* Next precision: grows by half, rounded up to a multiple of 64 */
+    const slong next[][2] = { { 64, 128 }, { 128, 192 }, { 192, 320 }, { 320, 512 },
+                              { 188, 320 }, { 1000, 1536 } };
+
+    for(const auto & nx : next)
+    {
+        const slong prec = mirp_exact_next_prec(nx[0]);
+        if(prec != nx[1])
+        {
+            std::cout << "mirp_exact_next_prec(" << nx[0] << ") = "
+                      << prec << " (expected " << nx[1] << ")\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    /* Wherever the calculation starts, exact results must be the correctly-rounded
+     * value. The reference is computed at a very high precision */
+    const slong ref_prec = 2048;
+
+    arb_t ref_mp, t_mp;
+    arb_init(ref_mp);
+    arb_init(t_mp);
+
+    const int boys_m[3] = { 0, 5, 20 };
+    const double boys_t[6] = { 0.0, 1e-10, 0.5, 30.0, 117.25, 1e4 };
+
+    for(int m : boys_m)
+    for(double t : boys_t)
+    {
+        std::vector<double> F(static_cast<size_t>(m+1));
+        mirp_boys_exact(F.data(), m, t);
+
+        arb_ptr F_mp = _arb_vec_init(m+1);
+        arb_set_d(t_mp, t);
+        mirp_boys(F_mp, m, t_mp, ref_prec);
+
+        for(int i = 0; i <= m; i++)
+        {
+            double ref;
+            mirp_format_set_arb(&ref, 0, F_mp + i, MIRP_BINARY64);
+
+            if(!mirp_format_certified(F_mp + i, MIRP_BINARY64, ref_prec) ||
+               std::memcmp(&ref, &F[static_cast<size_t>(i)], sizeof(double)) != 0)
+            {
+                std::cout << "Boys function F_" << i << "(" << t << "): ";
+                write_hexdouble(F[static_cast<size_t>(i)], std::cout);
+                std::cout << " vs ";
+                write_hexdouble(ref, std::cout);
+                std::cout << "\n";
+                nfailed++;
+            }
+            ntests++;
+        }
+
+        _arb_vec_clear(F_mp, m+1);
+    }
+
+    /* Primitive integrals where the estimated loss is large: very different
+     * exponents (with angular momentum), centers far from the origin, and
+     * large values of the Boys function argument */
+    struct single_case
+    {
+        int lmn[4][3];
+        double xyz[4][3];
+        double alpha[4];
+    };
+
+    const single_case singles[] = {
+        { { { 1, 0, 0 }, { 0, 0, 0 }, { 0, 1, 0 }, { 0, 0, 0 } },
+          { { 0.0, 0.0, 0.0 }, { 1.5, 0.0, 0.0 }, { 0.0, 1.0, 0.5 }, { 0.0, 1.0, 0.5 } },
+          { 1e5, 0.01, 1.2, 0.4 } },
+        { { { 2, 0, 0 }, { 0, 1, 1 }, { 0, 0, 2 }, { 1, 1, 0 } },
+          { { 0.0, 0.0, 0.0 }, { 0.5, 0.0, 0.0 }, { 30.0, 0.0, 0.0 }, { 30.0, 0.25, 0.5 } },
+          { 1.3, 0.42, 2.7, 0.093 } },
+        { { { 1, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { 0, 0, 0 } },
+          { { 1000.0, 0.0, 0.0 }, { 1000.5, 0.0, 0.0 }, { 1000.0, 0.0, 0.75 }, { 1000.25, 0.0, 0.0 } },
+          { 4.5e3, 0.8, 0.35, 1.9 } },
+        { { { 3, 0, 0 }, { 0, 2, 1 }, { 1, 1, 1 }, { 0, 0, 3 } },
+          { { 0.1, -0.2, 0.3 }, { 0.1, 1.2, 0.3 }, { -0.7, 0.4, 0.3 }, { 0.25, 0.5, -0.125 } },
+          { 0.31, 7.5, 0.05, 22.0 } } };
+
+    arb_ptr X = _arb_vec_init(12);
+    arb_ptr alpha = _arb_vec_init(4);
+
+    for(const auto & sc : singles)
+    {
+        double result;
+        mirp_gtoeri_single_exact(&result, sc.lmn[0], sc.xyz[0], sc.alpha[0],
+                                          sc.lmn[1], sc.xyz[1], sc.alpha[1],
+                                          sc.lmn[2], sc.xyz[2], sc.alpha[2],
+                                          sc.lmn[3], sc.xyz[3], sc.alpha[3]);
+
+        for(int n = 0; n < 4; n++)
+        {
+            arb_set_d(alpha + n, sc.alpha[n]);
+            for(int c = 0; c < 3; c++)
+                arb_set_d(X + 3*n + c, sc.xyz[n][c]);
+        }
+
+        mirp_gtoeri_single(ref_mp, sc.lmn[0], X+0, alpha+0,
+                                   sc.lmn[1], X+3, alpha+1,
+                                   sc.lmn[2], X+6, alpha+2,
+                                   sc.lmn[3], X+9, alpha+3,
+                                   ref_prec);
+
+        double ref;
+        mirp_format_set_arb(&ref, 0, ref_mp, MIRP_BINARY64);
+
+        if(!mirp_format_certified(ref_mp, MIRP_BINARY64, ref_prec) ||
+           std::memcmp(&ref, &result, sizeof(double)) != 0)
+        {
+            std::cout << "Single integral " << ntests << ": ";
+            write_hexdouble(result, std::cout);
+            std::cout << " vs ";
+            write_hexdouble(ref, std::cout);
+            std::cout << "\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    _arb_vec_clear(X, 12);
+    _arb_vec_clear(alpha, 4);
+    arb_clear(ref_mp);
+    arb_clear(t_mp);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+long check_exact_zero(void)
+{
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    /* A tight and a diffuse primitive, with all centers on the z axis. The x and y
+     * components of the p shells are exactly zero, and some primitive quartets
+     * are small enough to be skipped */
+    const std::vector<double> alpha = { 500.0, 0.2 };
+    const std::vector<double> coeff = { 0.5, 0.5 };
+    const int am[2][4] = { { 1, 0, 0, 0 }, { 1, 1, 0, 0 } };
+    const double dist[2] = { 1.0, 2.0 };
+
+    for(const auto & a : am)
+    for(double d : dist)
+    {
+        exact_quartet q;
+        q.nprim = 2;
+        q.ngen = 1;
+        q.alpha = alpha;
+        q.coeff = coeff;
+
+        const double z[4] = { 0.0, d, d, 0.0 };
+        for(int n = 0; n < 4; n++)
+        {
+            q.am[n] = a[n];
+            q.xyz[n][0] = q.xyz[n][1] = 0.0;
+            q.xyz[n][2] = z[n];
+        }
+
+        std::vector<double> results[2];
+        slong max_prec[2];
+
+        for(int screen = 0; screen < 2; screen++)
+        {
+            const double * pa = q.alpha.data();
+            const double * pc = q.coeff.data();
+
+            results[screen].resize(exact_nintegrals(q));
+            recorded_prec = 0;
+            mirp_integral4_exact_screened(results[screen].data(),
+                                          q.am[0], q.xyz[0], q.nprim, q.ngen, pa, pc,
+                                          q.am[1], q.xyz[1], q.nprim, q.ngen, pa, pc,
+                                          q.am[2], q.xyz[2], q.nprim, q.ngen, pa, pc,
+                                          q.am[3], q.xyz[3], q.nprim, q.ngen, pa, pc,
+                                          recording_single, screen ? mirp_gtoeri_bound : NULL);
+            max_prec[screen] = recorded_prec;
+        }
+
+        /* Screening must not require a higher working precision */
+        if(max_prec[1] > max_prec[0])
+        {
+            std::cout << "Quartet " << q.am[0] << q.am[1] << q.am[2] << q.am[3] << " at distance " << d
+                      << ": working precision is " << max_prec[1] << " with screening and "
+                      << max_prec[0] << " without\n";
+            nfailed++;
+        }
+        ntests++;
+
+        if(!compare_exact(q, "differs with screening", results[1], results[0]))
+            nfailed++;
+        ntests++;
+    }
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+
+long check_exact_tol(void)
+{
+    /* No tolerance, absolute, relative, and both */
+    const double tols[4][2] = { { 0.0, 0.0 }, { 1e-3, 0.0 }, { 0.0, 1e-2 }, { 1e-8, 1e-4 } };
+    const slong ref_prec = 1024;
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    /* Number of integrals flagged as inexact with a nonzero tolerance.
+     * Without any, the tolerance is not being checked */
+    unsigned long nflagged = 0;
+
+    /* Boys function. For large t, the higher orders are small. These are
+     * computed accurately enough that they are usually certified anyway */
+    const int m = 20;
+    const double boys_t[3] = { 0.5, 30.0, 117.25 };
+
+    arb_t t_mp;
+    arb_init(t_mp);
+    arb_ptr F_mp = _arb_vec_init(m+1);
+
+    for(double t : boys_t)
+    {
+        arb_set_d(t_mp, t);
+        mirp_boys(F_mp, m, t_mp, ref_prec);
+
+        for(const auto & tol : tols)
+        {
+            const double limit = tol_limit(F_mp, m+1, tol[0], tol[1]);
+
+            std::vector<double> F(static_cast<size_t>(m+1));
+            std::vector<double> F_noflag(static_cast<size_t>(m+1));
+            std::vector<char> inexact(static_cast<size_t>(m+1));
+            const long nret = mirp_boys_target_tol(F.data(), inexact.data(), MIRP_BINARY64, m, t, tol[0], tol[1]);
+            const long nret_noflag = mirp_boys_target_tol(F_noflag.data(), NULL, MIRP_BINARY64, m, t, tol[0], tol[1]);
+
+            /* The return value is the number of flagged values */
+            const long ninexact = static_cast<long>(std::count_if(inexact.begin(), inexact.end(),
+                                                                  [](char x) { return x != 0; }));
+            if(nret != ninexact || nret_noflag != ninexact)
+            {
+                std::cout << "Boys function at " << t << " with tolerance " << tol[0] << ", " << tol[1]
+                          << " returned " << nret << " and " << nret_noflag
+                          << " (expected " << ninexact << ")\n";
+                nfailed++;
+            }
+            ntests++;
+
+            for(int i = 0; i <= m; i++)
+            {
+                const size_t idx = static_cast<size_t>(i);
+                if(!check_tol_value(F[idx], inexact[idx], F_mp + i, ref_prec, limit) ||
+                   std::memcmp(&F[idx], &F_noflag[idx], sizeof(double)) != 0)
+                {
+                    std::cout << "Boys function F_" << i << "(" << t << ") with tolerance "
+                              << tol[0] << ", " << tol[1] << (inexact[idx] ? " (inexact): " : ": ");
+                    write_hexdouble(F[idx], std::cout);
+                    std::cout << "\n";
+                    nfailed++;
+                }
+                ntests++;
+            }
+        }
+    }
+
+    _arb_vec_clear(F_mp, m+1);
+    arb_clear(t_mp);
+
+    /* Contracted quartets of the second set, where small components lose many
+     * bits to cancellation (and so are not certified at the starting precision) */
+    const std::vector<exact_quartet> quartets = exact_quartets();
+    for(size_t iq = 4; iq < 8; iq++)
+    {
+        const exact_quartet & q = quartets[iq];
+        const size_t nint = exact_nintegrals(q);
+        const long n = static_cast<long>(nint);
+        const double * a = q.alpha.data();
+        const double * c = q.coeff.data();
+
+        arb_ptr X = _arb_vec_init(12);
+        arb_ptr alpha = _arb_vec_init(q.nprim);
+        arb_ptr coeff = _arb_vec_init(q.nprim*q.ngen);
+        arb_ptr ref = _arb_vec_init(n);
+
+        for(int i = 0; i < 4; i++)
+        for(int j = 0; j < 3; j++)
+            arb_set_d(X + 3*i + j, q.xyz[i][j]);
+        for(int i = 0; i < q.nprim; i++)
+            arb_set_d(alpha + i, a[i]);
+        for(int i = 0; i < q.nprim*q.ngen; i++)
+            arb_set_d(coeff + i, c[i]);
+
+        mirp_gtoeri(ref, q.am[0], X+0, q.nprim, q.ngen, alpha, coeff,
+                         q.am[1], X+3, q.nprim, q.ngen, alpha, coeff,
+                         q.am[2], X+6, q.nprim, q.ngen, alpha, coeff,
+                         q.am[3], X+9, q.nprim, q.ngen, alpha, coeff,
+                         ref_prec);
+
+        for(const auto & tol : tols)
+        {
+            const double limit = tol_limit(ref, n, tol[0], tol[1]);
+
+            std::vector<double> result(nint);
+            std::vector<char> inexact(nint);
+            const long nret = mirp_gtoeri_target_tol(result.data(), inexact.data(), MIRP_BINARY64, tol[0], tol[1],
+                                                     q.am[0], q.xyz[0], q.nprim, q.ngen, a, c,
+                                                     q.am[1], q.xyz[1], q.nprim, q.ngen, a, c,
+                                                     q.am[2], q.xyz[2], q.nprim, q.ngen, a, c,
+                                                     q.am[3], q.xyz[3], q.nprim, q.ngen, a, c);
+
+            const long ninexact = static_cast<long>(std::count_if(inexact.begin(), inexact.end(),
+                                                                  [](char x) { return x != 0; }));
+            if(nret != ninexact)
+            {
+                std::cout << "Quartet " << q.am[0] << q.am[1] << q.am[2] << q.am[3]
+                          << " with tolerance " << tol[0] << ", " << tol[1]
+                          << " returned " << nret << " (expected " << ninexact << ")\n";
+                nfailed++;
+            }
+            ntests++;
+
+            for(size_t i = 0; i < nint; i++)
+            {
+                if(inexact[i] && limit > 0.0)
+                    nflagged++;
+
+                if(!check_tol_value(result[i], inexact[i], ref + i, ref_prec, limit))
+                {
+                    std::cout << "Quartet " << q.am[0] << q.am[1] << q.am[2] << q.am[3]
+                              << " integral " << i << " with tolerance " << tol[0] << ", " << tol[1]
+                              << (inexact[i] ? " (inexact): " : ": ");
+                    write_hexdouble(result[i], std::cout);
+                    std::cout << "\n";
+                    nfailed++;
+                }
+                ntests++;
+            }
+        }
+
+        _arb_vec_clear(X, 12);
+        _arb_vec_clear(alpha, q.nprim);
+        _arb_vec_clear(coeff, q.nprim*q.ngen);
+        _arb_vec_clear(ref, n);
+    }
+
+    if(nflagged == 0)
+    {
+        std::cout << "No integrals were accepted within the tolerance\n";
+        nfailed++;
+    }
+    ntests++;
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
@@ -0,0 +1,258 @@
+/*! \file
+ *
+ * \brief Checks of rounding to the binary floating-point formats
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/kernels/all.h>
+#include <mirp/format.h>
+
+#include <cstring>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief Sets a ball to the exact value (sign * m * 2^e) + (a * 2^b)
+ *
+ * The second term allows for values just above or below a value of a format.
+ */
+void set_exact(arb_t x, int sign, slong m, slong e, slong a = 0, slong b = 0)
+{
+    arf_t t;
+    arf_init(t);
+
+    arb_set_si(x, sign * m);
+    arb_mul_2exp_si(x, x, e);
+    arf_set_si(t, a);
+    arf_mul_2exp_si(t, t, b);
+    arf_add(arb_midref(x), arb_midref(x), t, ARF_PREC_EXACT, ARF_RND_DOWN);
+
+    arf_clear(t);
+}
+
+
+/*! \brief A value and its correctly-rounded bits in binary32 */
+struct binary32_case
+{
+    int sign;
+    slong m, e, a, b;
+    uint32_t expected;
+};
+
+
+/*! \brief A value and its correctly-rounded bits in binary128 */
+struct binary128_case
+{
+    int sign;
+    slong m, e, a, b;
+    uint64_t expected_hi;
+    uint64_t expected_lo;
+};
+
+} // close anonymous namespace
+
+
+long check_format(void)
+{
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    arb_t x;
+    arb_init(x);
+
+    /* Ties to even, the smallest subnormal (2^-149), overflow,
+     * and zeros (a negative value that rounds to zero gives -0) */
+    const binary32_case cases32[] = {
+        {  1, 1, 0, 0, 0, UINT32_C(0x3F800000) },                 // 1
+        {  1, 1, 0, 1, -24, UINT32_C(0x3F800000) },               // 1 + 2^-24 (tie, down to even)
+        {  1, 1, 0, 3, -24, UINT32_C(0x3F800002) },               // 1 + 3*2^-24 (tie, up to even)
+        {  1, (slong(1) << 60) + (slong(1) << 36) + 1, -60, 0, 0, UINT32_C(0x3F800001) }, // 1 + 2^-24 + 2^-60
+        { -1, 1, 0, -1, -24, UINT32_C(0xBF800000) },              // -(1 + 2^-24)
+        {  1, 1, -149, 0, 0, UINT32_C(0x00000001) },              // smallest subnormal
+        {  1, 1, -150, 0, 0, UINT32_C(0x00000000) },              // half of it (tie, down to zero)
+        {  1, 3, -151, 0, 0, UINT32_C(0x00000001) },              // 0.75 of it
+        {  1, 3, -150, 0, 0, UINT32_C(0x00000002) },              // 1.5 of it (tie, up to even)
+        {  1, 1, -200, 0, 0, UINT32_C(0x00000000) },
+        { -1, 1, -200, 0, 0, UINT32_C(0x80000000) },              // -0
+        {  1, 0, 0, 0, 0, UINT32_C(0x00000000) },                 // +0
+        {  1, 1, -126, -1, -150, UINT32_C(0x00800000) },          // just below the smallest normal
+        {  1, 1, 128, 0, 0, UINT32_C(0x7F800000) },               // 2^128 overflows
+        { -1, 1, 128, 0, 0, UINT32_C(0xFF800000) },
+        {  1, (slong(1) << 24) - 1, 104, 1, 103, UINT32_C(0x7F800000) }, // tie between FLT_MAX and 2^128
+        {  1, (slong(1) << 24) - 1, 104, 1, 90, UINT32_C(0x7F7FFFFF) },  // just above FLT_MAX
+    };
+
+    for(const auto & c : cases32)
+    {
+        set_exact(x, c.sign, c.m, c.e, c.a, c.b);
+
+        float result;
+        uint32_t bits;
+        mirp_format_set_arb(&result, 0, x, MIRP_BINARY32);
+        std::memcpy(&bits, &result, sizeof(float));
+
+        if(bits != c.expected)
+        {
+            std::cout << "binary32 case " << ntests << ": 0x" << std::hex << bits
+                      << " (expected 0x" << c.expected << ")" << std::dec << "\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    /* The same in binary128, where the smallest subnormal is 2^-16494 */
+    const uint64_t one_hi = UINT64_C(0x3FFF000000000000);
+    const binary128_case cases128[] = {
+        {  1, 1, 0, 0, 0, one_hi, 0 },
+        { -1, 2, 0, 0, 0, UINT64_C(0xC000000000000000), 0 },
+        {  1, 1, 0, 1, -112, one_hi, 1 },
+        {  1, 1, 0, 1, -113, one_hi, 0 },                          // tie, down to even
+        {  1, 1, 0, 3, -113, one_hi, 2 },                          // tie, up to even
+        {  1, 1, 0, 1, -114, one_hi, 0 },
+        {  1, 1, -16494, 0, 0, 0, 1 },                             // smallest subnormal
+        {  1, 1, -16495, 0, 0, 0, 0 },                             // half of it (tie, down to zero)
+        {  1, 3, -16495, 0, 0, 0, 2 },                             // 1.5 of it (tie, up to even)
+        {  1, 1, -16383, 0, 0, UINT64_C(0x0000800000000000), 0 },  // largest power of two that is subnormal
+        {  1, 1, -16382, 0, 0, UINT64_C(0x0001000000000000), 0 },  // smallest normal
+        { -1, 1, -16600, 0, 0, UINT64_C(0x8000000000000000), 0 },  // -0
+        {  1, 0, 0, 0, 0, 0, 0 },                                  // +0
+        {  1, 1, 16384, 0, 0, UINT64_C(0x7FFF000000000000), 0 },   // overflow
+        { -1, 1, 16384, 0, 0, UINT64_C(0xFFFF000000000000), 0 },
+    };
+
+    for(const auto & c : cases128)
+    {
+        set_exact(x, c.sign, c.m, c.e, c.a, c.b);
+
+        mirp_binary128 result;
+        mirp_format_set_arb(&result, 0, x, MIRP_BINARY128);
+
+        if(result.hi != c.expected_hi || result.lo != c.expected_lo)
+        {
+            std::cout << "binary128 case " << ntests << ": 0x" << std::hex << std::setfill('0')
+                      << std::setw(16) << result.hi << std::setw(16) << result.lo
+                      << " (expected 0x" << std::setw(16) << c.expected_hi
+                      << std::setw(16) << c.expected_lo << ")" << std::dec << "\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    /* 1/3 is not exactly representable, and is rounded down in all formats */
+    arb_set_ui(x, 1);
+    arb_div_ui(x, x, 3, 512);
+
+    float third32;
+    double third64;
+    mirp_binary128 third128;
+    mirp_format_set_arb(&third32, 0, x, MIRP_BINARY32);
+    mirp_format_set_arb(&third64, 0, x, MIRP_BINARY64);
+    mirp_format_set_arb(&third128, 0, x, MIRP_BINARY128);
+
+    const float ref32 = 1.0f/3.0f;
+    const double ref64 = 1.0/3.0;
+
+    if(std::memcmp(&third32, &ref32, sizeof(float)) != 0 ||
+       std::memcmp(&third64, &ref64, sizeof(double)) != 0 ||
+       third128.hi != UINT64_C(0x3FFD555555555555) || third128.lo != UINT64_C(0x5555555555555555))
+    {
+        std::cout << "1/3 is not correctly rounded\n";
+        nfailed++;
+    }
+    ntests++;
+
+    /* Certification. A ball around a tie of binary32 is not certified there,
+     * but is certified for the formats with more bits */
+    const struct { slong a, b, rad; mirp_format fmt; int expected; } certified[] = {
+        { 1, -24, -60, MIRP_BINARY32, 0 },
+        { 1, -24, -60, MIRP_BINARY64, 1 },
+        { 1, -24, -60, MIRP_BINARY128, 0 },    // tie of binary128 is 2^-113 away
+        { 1, -24, -120, MIRP_BINARY128, 1 },
+        { 1, -25, -60, MIRP_BINARY32, 1 },
+        { 1, -25, -20, MIRP_BINARY32, 0 },
+    };
+
+    for(const auto & c : certified)
+    {
+        set_exact(x, 1, 1, 0, c.a, c.b);
+        mag_set_ui_2exp_si(arb_radref(x), 1, c.rad);
+
+        if(mirp_format_certified(x, c.fmt, 256) != c.expected)
+        {
+            std::cout << "Certification case " << ntests << " should"
+                      << (c.expected ? "" : " not") << " be certified\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    /* Balls that are not finite are never certified */
+    arb_indeterminate(x);
+    if(mirp_format_certified(x, MIRP_BINARY32, 256))
+    {
+        std::cout << "A ball that is not finite was certified\n";
+        nfailed++;
+    }
+    ntests++;
+
+    /* Correctly-rounded primitive integrals in the other formats, compared with
+     * a very high precision reference. These must also report being certified */
+    const int lmn1[3] = { 1, 0, 0 };
+    const int lmn2[3] = { 0, 1, 1 };
+    const int lmn3[3] = { 0, 0, 2 };
+    const int lmn4[3] = { 0, 0, 0 };
+    const double xyz[4][3] = { { 0.0, 0.0, 0.0 }, { 0.5, 0.0, 0.0 },
+                               { 0.0, 1.25, 0.0 }, { 0.0, 0.0, -0.75 } };
+    const double alpha[4] = { 1.3, 0.42, 2.7, 0.093 };
+
+    arb_ptr X = _arb_vec_init(12);
+    arb_ptr alpha_mp = _arb_vec_init(4);
+    for(int n = 0; n < 4; n++)
+    {
+        arb_set_d(alpha_mp + n, alpha[n]);
+        for(int c = 0; c < 3; c++)
+            arb_set_d(X + 3*n + c, xyz[n][c]);
+    }
+
+    mirp_gtoeri_single(x, lmn1, X+0, alpha_mp+0, lmn2, X+3, alpha_mp+1,
+                          lmn3, X+6, alpha_mp+2, lmn4, X+9, alpha_mp+3, 2048);
+
+    const mirp_format formats[3] = { MIRP_BINARY32, MIRP_BINARY64, MIRP_BINARY128 };
+
+    for(mirp_format fmt : formats)
+    {
+        mirp_binary128 result, ref;
+        std::memset(&result, 0, sizeof(result));
+        std::memset(&ref, 0, sizeof(ref));
+
+        const int ok = mirp_gtoeri_single_target(&result, fmt, lmn1, xyz[0], alpha[0],
+                                                               lmn2, xyz[1], alpha[1],
+                                                               lmn3, xyz[2], alpha[2],
+                                                               lmn4, xyz[3], alpha[3]);
+        mirp_format_set_arb(&ref, 0, x, fmt);
+
+        if(!ok || !mirp_format_certified(x, fmt, 2048) ||
+           std::memcmp(&result, &ref, mirp_format_size(fmt)) != 0)
+        {
+            std::cout << "Single integral in format " << static_cast<int>(fmt)
+                      << " is not correctly rounded or not certified\n";
+            nfailed++;
+        }
+        ntests++;
+    }
+
+    _arb_vec_clear(X, 12);
+    _arb_vec_clear(alpha_mp, 4);
+    arb_clear(x);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
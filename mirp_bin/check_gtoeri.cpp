@@ -0,0 +1,335 @@
+/*! \file
+ *
+ * \brief Checks of the gtoeri kernel
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/kernels/all.h>
+#include <mirp/shell.h>
+
+#include <array>
+#include <cassert>
+#include <vector>
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief Working precision used in the checks */
+const slong check_prec = 256;
+
+/*! \brief All lmn triplets of a shell */
+std::vector<std::array<int, 3>> all_lmn(int am)
+{
+    std::vector<std::array<int, 3>> ret(MIRP_NCART(am));
+    mirp_gaussian_fill_lmn(am, ret[0].data());
+    return ret;
+}
+
+
+/*! \brief The first and last lmn triplets of a shell (the same for s shells) */
+std::vector<std::array<int, 3>> end_lmn(int am)
+{
+    std::vector<std::array<int, 3>> ret = all_lmn(am);
+    if(ret.size() > 2)
+        ret.erase(ret.begin() + 1, ret.end() - 1);
+    return ret;
+}
+
+
+/*! \brief Sets a center from doubles, optionally as a tiny inexact ball */
+void set_center(arb_ptr X, const double * xyz, bool inexact)
+{
+    for(int i = 0; i < 3; i++)
+    {
+        arb_set_d(X + i, xyz[i]);
+        if(inexact)
+            arb_add_error_2exp_si(X + i, -2*check_prec);
+    }
+}
+
+
+/*! \brief Sets a contracted shell with the exponents and coefficients used in the checks
+ *
+ * The exponents range from very tight to diffuse, so that many
+ * primitive quartets of distant shells are negligible.
+ */
+void set_contracted(arb_ptr alpha, arb_ptr coeff, int nprim, int ngen)
+{
+    const double a[3] = { 80.0, 1.1, 0.13 };
+    const double c[6] = { 0.05, 0.6, 0.4,
+                          -0.02, 0.5, 1.0 };
+
+    assert(nprim <= 3 && ngen <= 2);
+
+    for(int i = 0; i < nprim; i++)
+        arb_set_d(alpha + i, a[i]);
+    for(int g = 0; g < ngen; g++)
+    for(int i = 0; i < nprim; i++)
+        arb_set_d(coeff + g*nprim + i, c[g*3 + i]);
+}
+
+} // close anonymous namespace
+
+
+long check_gtoeri_coincident(void)
+{
+    const double xyz1[3] = { 0.125, -0.75, 0.375 };
+    const double xyz2[3] = { -0.5, 0.25, 1.125 };
+    const int max_am = 2;
+
+    /* The exponents of the one-center quartets differ a lot, which
+     * is where the general expression loses the most */
+    const double alpha_one[4] = { 35.1, 0.21, 4.2, 0.77 };
+    const double alpha_two[4] = { 1.3, 0.42, 2.7, 0.093 };
+
+    arb_ptr X1 = _arb_vec_init(3);
+    arb_ptr X2 = _arb_vec_init(3);
+    arb_ptr X1_ball = _arb_vec_init(3);
+    arb_ptr X2_ball = _arb_vec_init(3);
+    arb_ptr alpha = _arb_vec_init(4);
+
+    set_center(X1, xyz1, false);
+    set_center(X2, xyz2, false);
+    set_center(X1_ball, xyz1, true);
+    set_center(X2_ball, xyz2, true);
+
+    arb_t fast, general;
+    arb_init(fast);
+    arb_init(general);
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(int one_center = 1; one_center >= 0; one_center--)
+    {
+        const double * a = one_center ? alpha_one : alpha_two;
+        for(int i = 0; i < 4; i++)
+            arb_set_d(alpha + i, a[i]);
+
+        /* Only the second pair is moved for two-center quartets */
+        arb_srcptr C = one_center ? X1 : X2;
+        arb_srcptr C_ball = one_center ? X1_ball : X2_ball;
+
+        for(int am1 = 0; am1 <= max_am; am1++)
+        for(int am2 = 0; am2 <= max_am; am2++)
+        for(int am3 = 0; am3 <= max_am; am3++)
+        for(int am4 = 0; am4 <= max_am; am4++)
+        for(const auto & lmn1 : all_lmn(am1))
+        for(const auto & lmn2 : all_lmn(am2))
+        for(const auto & lmn3 : all_lmn(am3))
+        for(const auto & lmn4 : all_lmn(am4))
+        {
+            mirp_gtoeri_single(fast, lmn1.data(), X1, alpha + 0,
+                                     lmn2.data(), X1, alpha + 1,
+                                     lmn3.data(), C,  alpha + 2,
+                                     lmn4.data(), C,  alpha + 3,
+                                     check_prec);
+
+            /* Inexact centers are never treated as coincident */
+            mirp_gtoeri_single(general, lmn1.data(), X1_ball, alpha + 0,
+                                        lmn2.data(), X1_ball, alpha + 1,
+                                        lmn3.data(), C_ball,  alpha + 2,
+                                        lmn4.data(), C_ball,  alpha + 3,
+                                        check_prec);
+
+            /* The fast path must agree with the general expression, and
+             * not lose more than the general expression does */
+            bool ok = arb_overlaps(fast, general) && arb_is_finite(fast);
+            if(!arb_is_zero(fast) && !arb_contains_zero(general))
+                ok = ok && arb_rel_accuracy_bits(fast) >= arb_rel_accuracy_bits(general);
+
+            if(!ok)
+            {
+                std::cout << (one_center ? "One" : "Two") << "-center quartet "
+                          << am1 << am2 << am3 << am4 << " failed:\n";
+                std::cout << "    fast path: ";
+                arb_printd(fast, 20);
+                std::cout << "\n    general:   ";
+                arb_printd(general, 20);
+                std::cout << "\n";
+                nfailed++;
+            }
+
+            ntests++;
+        }
+    }
+
+    _arb_vec_clear(X1, 3);
+    _arb_vec_clear(X2, 3);
+    _arb_vec_clear(X1_ball, 3);
+    _arb_vec_clear(X2_ball, 3);
+    _arb_vec_clear(alpha, 4);
+    arb_clear(fast);
+    arb_clear(general);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+
+long check_gtoeri_bound(void)
+{
+    /* The second set of centers is far apart, where the bound
+     * decays the same way as the integrals */
+    const double xyz[2][4][3] = { { { 0.0, 0.0, 0.0 }, { 0.5, -0.25, 0.75 },
+                                    { -0.5, 1.0, 0.25 }, { 0.0, 0.0, 0.0 } },
+                                  { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 2.5 },
+                                    { 3.0, 0.0, 0.0 }, { 3.0, 1.5, 1.0 } } };
+    const double a[4][4] = { { 1.3, 0.42, 2.7, 0.093 },
+                             { 35.1, 0.21, 4.2, 0.77 },
+                             { 0.05, 0.05, 12.0, 12.0 },
+                             { 150.0, 0.6, 0.6, 150.0 } };
+    const int max_am = 2;
+    const slong prec = check_prec/2;
+
+    arb_ptr X = _arb_vec_init(12);
+    arb_ptr alpha = _arb_vec_init(4);
+
+    arb_t integral;
+    mag_t bound, lower;
+    arb_init(integral);
+    mag_init(bound);
+    mag_init(lower);
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(int geo = 0; geo < 2; geo++)
+    for(int e = 0; e < 4; e++)
+    {
+        for(int n = 0; n < 4; n++)
+            set_center(X + 3*n, xyz[geo][n], false);
+        for(int i = 0; i < 4; i++)
+            arb_set_d(alpha + i, a[e][i]);
+
+        for(int am1 = 0; am1 <= max_am; am1++)
+        for(int am2 = 0; am2 <= max_am; am2++)
+        for(int am3 = 0; am3 <= max_am; am3++)
+        for(int am4 = 0; am4 <= max_am; am4++)
+        {
+            mirp_gtoeri_bound(bound, am1, X+0, alpha+0, am2, X+3, alpha+1,
+                                     am3, X+6, alpha+2, am4, X+9, alpha+3,
+                                     prec);
+
+            /* Only the first and last components of each shell (x^L and z^L) */
+            for(const auto & lmn1 : end_lmn(am1))
+            for(const auto & lmn2 : end_lmn(am2))
+            for(const auto & lmn3 : end_lmn(am3))
+            for(const auto & lmn4 : end_lmn(am4))
+            {
+                mirp_gtoeri_single(integral, lmn1.data(), X+0, alpha+0,
+                                             lmn2.data(), X+3, alpha+1,
+                                             lmn3.data(), X+6, alpha+2,
+                                             lmn4.data(), X+9, alpha+3,
+                                             prec);
+
+                /* The smallest magnitude the integral can have must not exceed the bound */
+                arb_get_mag_lower(lower, integral);
+                if(!arb_is_finite(integral) || mag_cmp(lower, bound) > 0)
+                {
+                    std::cout << "Bound of quartet " << am1 << am2 << am3 << am4
+                              << " (geometry " << geo << ", exponents " << e << ") failed:\n";
+                    std::cout << "    integral: ";
+                    arb_printd(integral, 20);
+                    std::cout << "\n    bound:    " << mag_get_d(bound) << "\n";
+                    nfailed++;
+                }
+
+                ntests++;
+            }
+        }
+    }
+
+    _arb_vec_clear(X, 12);
+    _arb_vec_clear(alpha, 4);
+    arb_clear(integral);
+    mag_clear(bound);
+    mag_clear(lower);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+
+long check_gtoeri_screened(void)
+{
+    const double xyz[4][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 3.0 },
+                               { 4.0, 0.0, 0.0 }, { 4.0, 0.5, 3.0 } };
+    const int nprim = 3;
+    const int ngen = 2;
+
+    /* Angular momenta of the quartets to compute */
+    const int am[4][4] = { { 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 1, 0, 1, 0 }, { 1, 1, 1, 1 } };
+
+    /* Screening drops the most at a low working precision. The unscreened
+     * integrals are computed at a much higher precision, so that their balls
+     * are much smaller than those of the screened integrals */
+    const slong screened_prec = 64;
+    const slong unscreened_prec = check_prec;
+
+    const long max_nintegrals = MIRP_NCART4(1, 1, 1, 1) * ngen*ngen*ngen*ngen;
+
+    arb_ptr X = _arb_vec_init(12);
+    arb_ptr alpha = _arb_vec_init(nprim);
+    arb_ptr coeff = _arb_vec_init(nprim*ngen);
+    arb_ptr screened = _arb_vec_init(max_nintegrals);
+    arb_ptr unscreened = _arb_vec_init(max_nintegrals);
+
+    for(int n = 0; n < 4; n++)
+        set_center(X + 3*n, xyz[n], false);
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    set_contracted(alpha, coeff, nprim, ngen);
+
+    for(const auto & q : am)
+    {
+        const int am1 = q[0], am2 = q[1], am3 = q[2], am4 = q[3];
+        const long nintegrals = MIRP_NCART4(am1, am2, am3, am4) * ngen*ngen*ngen*ngen;
+
+        mirp_gtoeri(screened, am1, X+0, nprim, ngen, alpha, coeff,
+                              am2, X+3, nprim, ngen, alpha, coeff,
+                              am3, X+6, nprim, ngen, alpha, coeff,
+                              am4, X+9, nprim, ngen, alpha, coeff,
+                              screened_prec);
+
+        mirp_integral4(unscreened, am1, X+0, nprim, ngen, alpha, coeff,
+                                   am2, X+3, nprim, ngen, alpha, coeff,
+                                   am3, X+6, nprim, ngen, alpha, coeff,
+                                   am4, X+9, nprim, ngen, alpha, coeff,
+                                   unscreened_prec, mirp_gtoeri_single);
+
+        for(long i = 0; i < nintegrals; i++)
+        {
+            if(!arb_is_finite(screened + i) || !arb_contains(screened + i, unscreened + i))
+            {
+                std::cout << "Screened quartet " << am1 << am2 << am3 << am4
+                          << ", integral " << i << " failed:\n";
+                std::cout << "    screened:   ";
+                arb_printd(screened + i, 20);
+                std::cout << "\n    unscreened: ";
+                arb_printd(unscreened + i, 20);
+                std::cout << "\n";
+                nfailed++;
+            }
+
+            ntests++;
+        }
+    }
+
+    _arb_vec_clear(X, 12);
+    _arb_vec_clear(alpha, nprim);
+    _arb_vec_clear(coeff, nprim*ngen);
+    _arb_vec_clear(screened, max_nintegrals);
+    _arb_vec_clear(unscreened, max_nintegrals);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
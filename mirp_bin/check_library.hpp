@@ -0,0 +1,155 @@
+/*! \file
+ *
+ * \brief Checks of library functionality that are not covered by test files
+ *
+ * Each check computes results in two different ways (or compares against
+ * known values), prints a summary, and returns the number of failures.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace mirp {
+
+/*! \brief Checks one- and two-center primitive quartets against the general expression
+ *
+ * Integrals with coincident centers are computed with the fast path of
+ * mirp_gtoeri_single. They are compared with the same integrals where
+ * the centers are given as (very small) inexact balls, which forces
+ * the general expression.
+ *
+ * \return The number of failed checks
+ */
+long check_gtoeri_coincident(void);
+
+
+/*! \brief Checks that mirp_gtoeri_bound is never below the integrals it bounds
+ *
+ * Integrals of primitive quartets (for several geometries and exponents, and
+ * the x^L and z^L components of each shell) are computed, and the lower bound
+ * of their magnitude must not exceed the bound.
+ *
+ * \return The number of failed checks
+ */
+long check_gtoeri_bound(void);
+
+
+/*! \brief Checks that screening primitive quartets keeps the integrals rigorous
+ *
+ * Contracted quartets are computed with primitive screening (mirp_gtoeri) at a low
+ * working precision, and without screening at a high precision. Each screened
+ * ball must contain the corresponding unscreened ball.
+ *
+ * \return The number of failed checks
+ */
+long check_gtoeri_screened(void);
+
+
+/*! \brief Checks rounding to the binary floating-point formats
+ *
+ * Exact values (ties, subnormal values, overflow, and zeros) are stored in
+ * binary32 and binary128 and compared with their known bit patterns. Certification
+ * of balls near ties, and primitive integrals correctly rounded to each format,
+ * are also checked.
+ *
+ * \return The number of failed checks
+ */
+long check_format(void);
+
+
+/*! \brief Checks that mirp_scheduler_run_ordered completes tasks in order
+ *
+ * Tasks of very different cost are run, so that they finish out of order.
+ * They must be completed strictly in order, never concurrently, and
+ * not at all after the completion function asks to stop.
+ *
+ * \param [in] nthreads Number of threads to use (0 for the default)
+ * \return The number of failed checks
+ */
+long check_scheduler_ordered(int nthreads);
+
+
+/*! \brief Checks repeated initialization and cleanup of the MIRP runtime
+ *
+ * A generally-contracted quartet (which uses the per-thread workspaces) is computed
+ * over several cycles of mirp_init and mirp_finalize, with a different number of
+ * threads each time. Every result must be identical to one computed before.
+ *
+ * \return The number of failed checks
+ */
+long check_runtime_cycles(void);
+
+
+/*! \brief Checks the significant shell pairs found by mirp_basis_screen
+ *
+ * A small basis is screened with several thresholds. For every removed pair,
+ * all integrals with any other pair are computed and must be smaller than the
+ * threshold. The bounds of the kept pairs must be valid. All quartets of the kept
+ * pairs are then computed with mirp_gtoeri_basis, and must either be identical
+ * to computing them one at a time, or be negligible and not passed to the sink.
+ *
+ * \param [in] nthreads Number of threads to use (0 for the default)
+ * \return The number of failed checks
+ */
+long check_basis_screen(int nthreads);
+
+
+/*! \brief Checks that keeping converged components does not change exact results
+ *
+ * Contracted quartets are computed with mirp_integral4_exact_screened (where
+ * converged components are not recomputed) and with mirp_integral4_exact (where the
+ * entire quartet is recomputed in every round). The results must be identical.
+ *
+ * \return The number of failed checks
+ */
+long check_exact_masked(void);
+
+
+/*! \brief Checks the working precision used by the exact functions
+ *
+ * The starting and next precision are compared with known values. Exact
+ * Boys function values and primitive integrals (including cases where a lot
+ * of precision is lost) must equal the correctly-rounded result of a
+ * very high precision calculation.
+ *
+ * \return The number of failed checks
+ */
+long check_exact_prec(void);
+
+
+/*! \brief Checks that abandoning components does not change exact results
+ *
+ * Contracted quartets are computed with mirp_integral4_exact_screened, with a
+ * bound (so that components that cannot converge are abandoned part way through)
+ * and without one. The results must be identical.
+ *
+ * \return The number of failed checks
+ */
+long check_exact_abandon(void);
+
+/*! \brief Checks that screening does not increase the precision needed for zero components
+ *
+ * Contracted quartets with components that are exactly zero by symmetry are
+ * computed with mirp_integral4_exact_screened, with and without a bound. The
+ * largest working precision used with screening must not be larger than without,
+ * and the results must be identical.
+ *
+ * \return The number of failed checks
+ */
+long check_exact_zero(void);
+
+
+/*! \brief Checks the target functions that accept values within a tolerance
+ *
+ * Boys function values and contracted quartets are computed with several absolute
+ * and relative tolerances, and compared with a very high precision calculation.
+ * Values that are not flagged as inexact must be correctly rounded, and flagged
+ * values (and their exact results) must be within the tolerance. The functions
+ * must return the number of flagged values.
+ *
+ * \return The number of failed checks
+ */
+long check_exact_tol(void);
+
+} // close namespace mirp
@@ -0,0 +1,155 @@
+/*! \file
+ *
+ * \brief Checks of the MIRP runtime (initialization, workspaces, and cleanup)
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/kernels/all.h>
+#include <mirp/runtime.h>
+#include <mirp/scheduler.h>
+#include <mirp/shell.h>
+
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief Generally-contracted shell quartet computed by the runtime check */
+struct runtime_quartet
+{
+    static const int am = 0;
+    static const int nprim = 3;
+    static const int ngen = 2;
+    static const long nintegrals = MIRP_NCART4(am, am, am, am) * ngen*ngen*ngen*ngen;
+
+    arb_ptr xyz;     //!< Centers (4*3)
+    arb_ptr alpha;   //!< Exponents (shared by all shells)
+    arb_ptr coeff;   //!< Coefficients (shared by all shells)
+    arb_ptr ref;     //!< Reference integrals
+    long nfailed;    //!< Number of tasks that did not reproduce the reference
+};
+
+
+/*! \brief Computes the quartet (general contractions use the per-thread workspaces) */
+void compute_quartet(arb_ptr integrals, const runtime_quartet & q)
+{
+    const int am = runtime_quartet::am;
+    const int np = runtime_quartet::nprim;
+    const int ng = runtime_quartet::ngen;
+
+    mirp_integral4(integrals,
+                   am, q.xyz+0, np, ng, q.alpha, q.coeff,
+                   am, q.xyz+3, np, ng, q.alpha, q.coeff,
+                   am, q.xyz+6, np, ng, q.alpha, q.coeff,
+                   am, q.xyz+9, np, ng, q.alpha, q.coeff,
+                   128, mirp_gtoeri_single);
+}
+
+
+void quartet_task(long, void *, void * data)
+{
+    runtime_quartet * q = static_cast<runtime_quartet *>(data);
+
+    arb_ptr integrals = _arb_vec_init(runtime_quartet::nintegrals);
+    compute_quartet(integrals, *q);
+
+    /* Results do not depend on the number of threads */
+    bool ok = true;
+    for(long i = 0; i < runtime_quartet::nintegrals; i++)
+        ok = ok && arb_equal(integrals + i, q->ref + i);
+
+    if(!ok)
+    {
+        #ifdef _OPENMP
+        #pragma omp atomic
+        #endif
+        q->nfailed++;
+    }
+
+    _arb_vec_clear(integrals, runtime_quartet::nintegrals);
+}
+
+} // close anonymous namespace
+
+
+long check_runtime_cycles(void)
+{
+    const double xyz[12] = { 0.0, 0.0, 0.0,   0.5, -1.25, 0.75,
+                            -1.0, 0.25, 1.5,   2.0, 0.5, -0.5 };
+    const double alpha[3] = { 7.5, 1.25, 0.3 };
+    const double coeff[6] = { 0.2, 0.5, 0.4,   -0.1, 0.3, 0.8 };
+
+    runtime_quartet q;
+    q.xyz = _arb_vec_init(12);
+    q.alpha = _arb_vec_init(3);
+    q.coeff = _arb_vec_init(6);
+    q.ref = _arb_vec_init(runtime_quartet::nintegrals);
+    q.nfailed = 0;
+
+    for(int i = 0; i < 12; i++)
+        arb_set_d(q.xyz + i, xyz[i]);
+    for(int i = 0; i < 3; i++)
+        arb_set_d(q.alpha + i, alpha[i]);
+    for(int i = 0; i < 6; i++)
+        arb_set_d(q.coeff + i, coeff[i]);
+
+    compute_quartet(q.ref, q);
+
+    /* Repeated cycles, where the number of threads used
+     * by the tasks is different from that given to mirp_init */
+    const int init_threads[4] = { 4, 2, 0, 3 };
+    const int task_threads[4] = { 2, 4, 3, 1 };
+    const long ntasks = 16;
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(int c = 0; c < 4; c++)
+    {
+        mirp_init(init_threads[c], 256);
+
+        q.nfailed = 0;
+        mirp_scheduler_run(ntasks, task_threads[c], nullptr, nullptr, quartet_task, &q);
+
+        /* Also from the main thread, after the workspaces of other threads were used */
+        quartet_task(0, nullptr, &q);
+
+        mirp_finalize();
+
+        if(q.nfailed)
+        {
+            std::cout << "Cycle " << c << ": " << q.nfailed << " of " << ntasks+1
+                      << " computations did not reproduce the reference\n";
+            nfailed++;
+        }
+
+        ntests++;
+    }
+
+    /* Finalizing twice, and using MIRP without initializing */
+    mirp_finalize();
+    q.nfailed = 0;
+    quartet_task(0, nullptr, &q);
+    mirp_thread_cleanup();
+    mirp_finalize();
+
+    if(q.nfailed)
+    {
+        std::cout << "Computation after repeated cleanup did not reproduce the reference\n";
+        nfailed++;
+    }
+    ntests++;
+
+    _arb_vec_clear(q.xyz, 12);
+    _arb_vec_clear(q.alpha, 3);
+    _arb_vec_clear(q.coeff, 6);
+    _arb_vec_clear(q.ref, runtime_quartet::nintegrals);
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
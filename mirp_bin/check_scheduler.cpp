@@ -0,0 +1,106 @@
+/*! \file
+ *
+ * \brief Checks of the task scheduler
+ */
+
+#include "mirp_bin/check_library.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/scheduler.h>
+#include <arb.h>
+
+#include <atomic>
+#include <iostream>
+
+namespace mirp {
+
+namespace {
+
+/*! \brief Data shared by all tasks of the ordered scheduler check */
+struct ordered_data
+{
+    long stop_at;                   //!< Task at which complete asks to stop (-1 for never)
+    long ncompleted;                //!< Number of tasks completed so far
+    long nbad;                      //!< Number of tasks completed out of order, or with the wrong result
+    std::atomic<int> in_complete;   //!< Number of threads currently in complete
+};
+
+void * slot_init(void *)
+{
+    return new long(-1);
+}
+
+void slot_clear(void * slot, void *)
+{
+    delete static_cast<long *>(slot);
+}
+
+void task_run(long i, void * slot, void *)
+{
+    /* Tasks of very different cost, so that they finish out of order */
+    arb_t x;
+    arb_init(x);
+    arb_set_si(x, i);
+    arb_exp(x, x, 64 + 4096*(i % 5 == 0));
+    arb_clear(x);
+
+    *static_cast<long *>(slot) = i;
+}
+
+int task_complete(long i, void * slot, void * data)
+{
+    ordered_data * d = static_cast<ordered_data *>(data);
+
+    if(d->in_complete++ != 0)
+        d->nbad++;
+
+    if(i != d->ncompleted || *static_cast<long *>(slot) != i)
+        d->nbad++;
+
+    d->ncompleted++;
+    d->in_complete--;
+    return i == d->stop_at;
+}
+
+} // close anonymous namespace
+
+
+long check_scheduler_ordered(int nthreads)
+{
+    const long ntasks = 1000;
+    const long stop_at[3] = { -1, 0, 517 };
+    const long window[3] = { 1, 4, 64 };
+
+    unsigned long ntests = 0;
+    unsigned long nfailed = 0;
+
+    for(long s : stop_at)
+    for(long w : window)
+    {
+        ordered_data d;
+        d.stop_at = s;
+        d.ncompleted = 0;
+        d.nbad = 0;
+        d.in_complete = 0;
+
+        mirp_scheduler_run_ordered(ntasks, nthreads, w,
+                                   slot_init, slot_clear,
+                                   task_run, task_complete, &d);
+
+        const long expected = (s < 0) ? ntasks : s + 1;
+        if(d.nbad != 0 || d.ncompleted != expected)
+        {
+            std::cout << "Window " << w << ", stopping at " << s << ": "
+                      << d.ncompleted << " tasks completed (expected " << expected << "), "
+                      << d.nbad << " completed out of order or concurrently\n";
+            nfailed++;
+        }
+
+        ntests++;
+    }
+
+    print_results(nfailed, ntests);
+    return static_cast<long>(nfailed);
+}
+
+} // close namespace mirp
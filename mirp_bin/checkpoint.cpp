@@ -0,0 +1,155 @@
+/*! \file
+ *
+ * \brief Checkpointing of long-running programs that write a file in order
+ */
+
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/binary_io.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace mirp {
+
+/* First line of a checkpoint file */
+static const char checkpoint_magic[] = "# MIRP checkpoint version 1";
+
+
+std::string checkpoint_path(const std::string & output_filepath)
+{
+    return output_filepath + ".checkpoint";
+}
+
+
+/* Offset basis of the 64-bit FNV-1a hash */
+static const uint64_t fnv_offset = UINT64_C(14695981039346656037);
+
+
+/* Continues a 64-bit FNV-1a hash with some bytes */
+static uint64_t fnv_update(uint64_t h, const char * data, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= UINT64_C(1099511628211);
+    }
+    return h;
+}
+
+
+uint64_t checkpoint_fingerprint(const std::string & s)
+{
+    return fnv_update(fnv_offset, s.data(), s.size());
+}
+
+
+uint64_t checkpoint_fingerprint_file(const std::string & filepath)
+{
+    std::ifstream fs(filepath, std::ifstream::binary);
+    if(!fs.is_open())
+        throw std::runtime_error("Cannot open file \"" + filepath + "\" to compute its fingerprint");
+
+    uint64_t h = fnv_offset;
+    char buf[65536];
+
+    while(fs)
+    {
+        fs.read(buf, sizeof(buf));
+        h = fnv_update(h, buf, static_cast<size_t>(fs.gcount()));
+    }
+
+    if(fs.bad())
+        throw std::runtime_error("Error reading file \"" + filepath + "\" to compute its fingerprint");
+
+    return h;
+}
+
+
+checkpoint checkpoint_resume(const std::string & output_filepath, uint64_t fingerprint)
+{
+    const std::string path = checkpoint_path(output_filepath);
+    const std::string err = "Error reading checkpoint " + path + ": ";
+
+    std::ifstream fs(path);
+    if(!fs.is_open())
+        throw std::runtime_error(err + "Cannot open file (is there an earlier run to resume?)");
+
+    std::string line;
+    std::getline(fs, line);
+    if(line != checkpoint_magic)
+        throw std::runtime_error(err + "Not a checkpoint file");
+
+    checkpoint ckpt;
+    std::string key;
+    size_t nblock = 0;
+
+    fs >> key >> std::hex >> ckpt.fingerprint >> std::dec;
+    if(key != "fingerprint")
+        throw std::runtime_error(err + "Missing fingerprint");
+    fs >> key >> ckpt.ncomplete;
+    if(key != "ncomplete")
+        throw std::runtime_error(err + "Missing number of completed tasks");
+    fs >> key >> ckpt.offset;
+    if(key != "offset")
+        throw std::runtime_error(err + "Missing file offset");
+    fs >> key >> nblock;
+    if(key != "nblock")
+        throw std::runtime_error(err + "Missing number of blocks");
+
+    ckpt.block_sizes.resize(nblock);
+    for(auto & it : ckpt.block_sizes)
+        fs >> it;
+
+    if(fs.fail())
+        throw std::runtime_error(err + "File is truncated or corrupted");
+
+    if(ckpt.fingerprint != fingerprint)
+        throw std::runtime_error(err + "The checkpoint was written by a run with different arguments");
+
+    file_truncate(output_filepath, ckpt.offset);
+    return ckpt;
+}
+
+
+void checkpoint_write(const std::string & output_filepath, const checkpoint & ckpt)
+{
+    const std::string path = checkpoint_path(output_filepath);
+    const std::string tmppath = path + ".tmp";
+
+    {
+        std::ofstream fs(tmppath, std::ofstream::out | std::ofstream::trunc);
+        if(!fs.is_open())
+            throw std::runtime_error("Unable to open file \"" + tmppath + "\" for writing");
+
+        fs << checkpoint_magic << "\n";
+        fs << "fingerprint " << std::hex << ckpt.fingerprint << std::dec << "\n";
+        fs << "ncomplete " << ckpt.ncomplete << "\n";
+        fs << "offset " << ckpt.offset << "\n";
+        fs << "nblock " << ckpt.block_sizes.size() << "\n";
+        for(auto it : ckpt.block_sizes)
+            fs << it << "\n";
+
+        fs.close();
+        if(fs.fail())
+            throw std::runtime_error("Error writing checkpoint " + tmppath);
+    }
+
+    // Replaces any existing checkpoint in one step on POSIX systems.
+    // Some other systems do not replace existing files
+    if(std::rename(tmppath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(path.c_str());
+        if(std::rename(tmppath.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Error replacing checkpoint " + path);
+    }
+}
+
+
+void checkpoint_remove(const std::string & output_filepath)
+{
+    std::remove(checkpoint_path(output_filepath).c_str());
+}
+
+} // close namespace mirp
@@ -0,0 +1,138 @@
+/*! \file
+ *
+ * \brief Checkpointing of long-running programs that write a file in order
+ *
+ * A checkpoint records how many tasks (quartets or entries) are completely
+ * written to an output file, and the size of the file at that point. It is
+ * stored next to the output file (see \ref checkpoint_path), is replaced
+ * atomically, and is removed once the output file is complete.
+ *
+ * Since the output files do not depend on how the work is scheduled, a
+ * run that is continued from a checkpoint produces the same file as one
+ * that was never interrupted.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mirp {
+
+
+/*! \brief Options for checkpointing and continuing a program */
+struct checkpoint_options
+{
+    bool resume;       //!< Continue from the checkpoint of an earlier run
+    double interval;   //!< Minimum time between checkpoints (seconds)
+    long stop_after;   //!< Stop after computing this many tasks (0 for no limit)
+
+    checkpoint_options(void) : resume(false), interval(60.0), stop_after(0) { }
+};
+
+
+/*! \brief Position in a partially written output file */
+struct checkpoint
+{
+    uint64_t fingerprint;              //!< Hash of everything that determines the file contents
+    uint64_t ncomplete;                //!< Number of tasks completely written to the file
+    uint64_t offset;                   //!< Size of the file after those tasks (bytes)
+    std::vector<uint64_t> block_sizes; //!< Sizes of the blocks written (binary reference files only)
+
+    checkpoint(void) : fingerprint(0), ncomplete(0), offset(0) { }
+};
+
+
+/*! \brief Path to the checkpoint of an output file */
+std::string checkpoint_path(const std::string & output_filepath);
+
+
+/*! \brief Computes a hash (64-bit FNV-1a) of a string
+ *
+ * This is used to detect a checkpoint that was written by a run with
+ * different arguments. It is the same on all platforms.
+ */
+uint64_t checkpoint_fingerprint(const std::string & s);
+
+
+/*! \brief Computes a hash (64-bit FNV-1a) of the contents of a file
+ *
+ * This is the same as \ref checkpoint_fingerprint of the whole file as a string.
+ *
+ * \throw std::runtime_error if the file cannot be read
+ */
+uint64_t checkpoint_fingerprint_file(const std::string & filepath);
+
+
+/*! \brief Reads the checkpoint of an output file, and prepares the file for continuing
+ *
+ * The output file is truncated to the size given in the checkpoint, so that
+ * anything written after the checkpoint was taken is discarded.
+ *
+ * \throw std::runtime_error if the checkpoint does not exist or cannot be read,
+ *        if it was written by a run with different arguments, or if the output
+ *        file is missing or too short
+ *
+ * \param [in] output_filepath Path to the output file
+ * \param [in] fingerprint     Fingerprint of the current run (see \ref checkpoint_fingerprint)
+ * \return The checkpoint that was read
+ */
+checkpoint checkpoint_resume(const std::string & output_filepath, uint64_t fingerprint);
+
+
+/*! \brief Writes the checkpoint of an output file
+ *
+ * The checkpoint is written to a temporary file first, which then
+ * replaces any existing checkpoint.
+ *
+ * \throw std::runtime_error if there is a problem writing the checkpoint
+ *
+ * \param [in] output_filepath Path to the output file
+ * \param [in] ckpt            The checkpoint to write
+ */
+void checkpoint_write(const std::string & output_filepath, const checkpoint & ckpt);
+
+
+/*! \brief Removes the checkpoint of an output file (if it exists) */
+void checkpoint_remove(const std::string & output_filepath);
+
+
+/*! \brief Determines when to take a checkpoint
+ *
+ * This is not thread safe. It is meant to be used from the
+ * (serialized) function that writes the results.
+ */
+class checkpoint_timer
+{
+public:
+    /*! \brief Starts the clock
+     *
+     * \param [in] interval Minimum time between checkpoints (in seconds)
+     */
+    explicit checkpoint_timer(double interval)
+        : interval_(interval), last_(clock::now())
+    { }
+
+
+    /*! \brief Returns true (and restarts the clock) if a checkpoint is due */
+    bool due(void)
+    {
+        const clock::time_point now = clock::now();
+        if(std::chrono::duration<double>(now - last_).count() < interval_)
+            return false;
+
+        last_ = now;
+        return true;
+    }
+
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    const double interval_;    /*!< Minimum time between checkpoints (seconds) */
+    clock::time_point last_;   /*!< When the last checkpoint was taken */
+};
+
+} // close namespace mirp
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <mirp/basis.h>
+
 #include <array>
 #include <vector>
 #include <string>
@@ -84,6 +86,7 @@ struct integral_data_entry
     std::vector<gaussian_shell_str> g;      //!< Shells for which the integrals are calculated
     std::vector<int> idx;               //!< Indices of the shells
     std::vector<std::string> integrals; //!< Computed integrals
+    std::vector<unsigned char> integrals_bin; //!< Serialized integrals (binary test files only)
 };
 
 
@@ -114,5 +117,16 @@ std::vector<gaussian_shell> read_construct_basis(const std::string & xyzfile,
                                                  const std::string & basfile);
 
 
+/*! \brief Creates a library basis from a vector of shells
+ *
+ * All data is copied into \p basis, which must be destroyed
+ * with mirp_basis_clear.
+ *
+ * \param [out] basis  The basis to initialize
+ * \param [in]  shells Shells to store in the basis
+ */
+void basis_init_from_shells(mirp_basis * basis, const std::vector<gaussian_shell> & shells);
+
+
 } // close namespace mirp
 
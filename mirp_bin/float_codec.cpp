@@ -0,0 +1,176 @@
+/*! \file
+ *
+ * \brief Lossless compression of blocks of double precision values
+ */
+
+#include "mirp_bin/float_codec.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace mirp {
+
+/* Mask for all bits except the sign bit */
+static const uint64_t magnitude_mask = UINT64_C(0x7FFFFFFFFFFFFFFF);
+
+
+/*! \brief The most recent literals of a block */
+class literal_window
+{
+public:
+    literal_window(void) : head_(0), count_(0) { }
+
+    /*! \brief Number of literals that can be referenced */
+    int size(void) const { return count_; }
+
+    /*! \brief Obtain a literal, by distance from the most recent */
+    uint64_t get(int d) const
+    {
+        return lit_[static_cast<size_t>((head_ + float_codec_window - 1 - d) % float_codec_window)];
+    }
+
+    void push(uint64_t bits)
+    {
+        lit_[static_cast<size_t>(head_)] = bits;
+        head_ = (head_ + 1) % float_codec_window;
+        if(count_ < float_codec_window)
+            count_++;
+    }
+
+private:
+    std::array<uint64_t, float_codec_window> lit_;
+    int head_;
+    int count_;
+};
+
+
+static uint64_t double_bits(double d)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(d));
+    return bits;
+}
+
+
+static double bits_double(uint64_t bits)
+{
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+
+void float_block_encode(const double * values, size_t n, std::vector<unsigned char> & out)
+{
+    literal_window window;
+    uint64_t prev = 0;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const uint64_t bits = double_bits(values[i]);
+
+        if(bits == 0)
+        {
+            out.push_back(0);
+            continue;
+        }
+
+        // Search the window for the same magnitude
+        int d = 0;
+        for(; d < window.size(); d++)
+        {
+            if(((window.get(d) ^ bits) & magnitude_mask) == 0)
+                break;
+        }
+
+        if(d < window.size())
+        {
+            const int flip = (window.get(d) != bits) ? 1 : 0;
+            out.push_back(static_cast<unsigned char>(1 + 2*d + flip));
+            continue;
+        }
+
+        // Store as a literal, without the zero bytes at either end
+        uint64_t x = bits ^ prev;
+        int nskip = 0;
+        while(nskip < 7 && (x & 0xFF) == 0)
+        {
+            x >>= 8;
+            nskip++;
+        }
+
+        int nbytes = 0;
+        for(uint64_t y = x; y != 0; y >>= 8)
+            nbytes++;
+
+        out.push_back(static_cast<unsigned char>(0x80 | (nskip << 4) | nbytes));
+        for(int j = 0; j < nbytes; j++)
+        {
+            out.push_back(static_cast<unsigned char>(x & 0xFF));
+            x >>= 8;
+        }
+
+        window.push(bits);
+        prev = bits;
+    }
+}
+
+
+void float_block_decode(const unsigned char * data, size_t size, double * values, size_t n)
+{
+    literal_window window;
+    uint64_t prev = 0;
+
+    const unsigned char * p = data;
+    const unsigned char * const end = data + size;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        if(p == end)
+            throw std::runtime_error("Compressed block is truncated");
+
+        const int tag = *p++;
+
+        if(tag == 0)
+            values[i] = 0.0;
+        else if(tag < 0x80)
+        {
+            const int d = (tag - 1) / 2;
+            if(d >= window.size())
+                throw std::runtime_error("Invalid reference in compressed block");
+
+            uint64_t bits = window.get(d);
+            if((tag - 1) % 2)
+                bits ^= ~magnitude_mask;
+            values[i] = bits_double(bits);
+        }
+        else
+        {
+            const int nskip = (tag >> 4) & 0x7;
+            const int nbytes = tag & 0xF;
+
+            if(nskip + nbytes > 8)
+                throw std::runtime_error("Invalid literal in compressed block");
+            if(end - p < nbytes)
+                throw std::runtime_error("Compressed block is truncated");
+
+            uint64_t x = 0;
+            for(int j = nbytes-1; j >= 0; j--)
+                x = (x << 8) | p[j];
+            p += nbytes;
+
+            const uint64_t bits = (x << (8*nskip)) ^ prev;
+            values[i] = bits_double(bits);
+
+            window.push(bits);
+            prev = bits;
+        }
+    }
+
+    if(p != end)
+        throw std::runtime_error("Compressed block contains extra data");
+}
+
+} // close namespace mirp
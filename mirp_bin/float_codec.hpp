@@ -0,0 +1,61 @@
+/*! \file
+ *
+ * \brief Lossless compression of blocks of double precision values
+ *
+ * Each value is encoded with a tag byte, followed by a payload:
+ *
+ * Tag         | Payload        | Value
+ * ------------|----------------|-----------------------------------------------------
+ * 0x00        | none           | +0.0
+ * 0x01 - 0x7E | none           | A recent literal (see below), possibly with the sign flipped
+ * 0x80 - 0xFF | 0 - 8 bytes    | A literal, XOR'd with the previous literal
+ *
+ * Integrals contain many zeros and many values that are repeated (up to sign)
+ * due to symmetry, while the mantissas of the other values are essentially
+ * random. Therefore, the last \ref float_codec_window literals are kept, and
+ * a value whose magnitude matches one of them is stored as a reference. For a
+ * reference, `tag - 1 = 2*d + s`, where `d` is the distance back into the list
+ * of literals (0 is the most recent), and `s` is set if the sign is flipped.
+ *
+ * Other values are stored as literals. The bits of the literal are XOR'd with the
+ * previous literal, which clears the sign and exponent bits of values with similar
+ * magnitude. Zero bytes at either end are not stored. The low 4 bits of the tag contain
+ * the number of bytes stored, and bits 4-6 the number of trailing zero bytes skipped.
+ * The bytes are stored in little-endian order.
+ *
+ * The encoding does not depend on the representation of doubles on the host,
+ * and blocks are independent of each other.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace mirp {
+
+/*! \brief Number of previous literals that may be referenced */
+static const int float_codec_window = 63;
+
+
+/*! \brief Encodes a block of values
+ *
+ * \param [in]  values Values to encode
+ * \param [in]  n      Number of values in \p values
+ * \param [out] out    The encoded block is appended to this buffer
+ */
+void float_block_encode(const double * values, size_t n, std::vector<unsigned char> & out);
+
+
+/*! \brief Decodes a block of values
+ *
+ * \throw std::runtime_error if the data is not a valid block of \p n values
+ *
+ * \param [in]  data   The encoded block
+ * \param [in]  size   Size of the encoded block (in bytes)
+ * \param [out] values Output for the decoded values
+ * \param [in]  n      Number of values in the block
+ */
+void float_block_decode(const unsigned char * data, size_t size, double * values, size_t n);
+
+} // close namespace mirp
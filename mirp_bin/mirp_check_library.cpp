@@ -0,0 +1,128 @@
+/*! \file
+ *
+ * \brief mirp_check_library main function
+ */
+
+#include "mirp_bin/cmdline.hpp"
+#include "mirp_bin/check_library.hpp"
+
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace mirp;
+
+static void print_help(void)
+{
+    std::cout << "\n"
+              << "mirp_check_library - Check MIRP functionality that is not covered by test files\n"
+              << "\n"
+              << "\n"
+              << "Required arguments:\n"
+              << "    --check        The check to run. Possibilities are:\n"
+              << "                       gtoeri_coincident\n"
+              << "                       gtoeri_bound\n"
+              << "                       gtoeri_screened\n"
+              << "                       format\n"
+              << "                       scheduler_ordered\n"
+              << "                       runtime_cycles\n"
+              << "                       basis_screen\n"
+              << "                       exact_masked\n"
+              << "                       exact_prec\n"
+              << "                       exact_abandon\n"
+              << "                       exact_zero\n"
+              << "                       exact_tol\n"
+              << "\n"
+              << "\n"
+              << "Optional arguments:\n"
+              << "    --threads      Number of threads to use, for checks that use threads.\n"
+              << "                   If 0, all available threads are used (default: 0)\n"
+              << "\n"
+              << "\n"
+              << "Other arguments:\n"
+              << "    -h, --help     Display this help screen\n"
+              << "\n";
+}
+
+/*! \brief Main function */
+int main(int argc, char ** argv)
+{
+    std::string check;
+    long nthreads = 0;
+
+    try {
+        auto cmdline = convert_cmdline(argc, argv);
+        if(cmdline.size() == 0 || cmdline_has_arg(cmdline, "-h") || cmdline_has_arg(cmdline, "--help"))
+        {
+            print_help();
+            return 0;
+        }
+
+        check = cmdline_get_arg_str(cmdline, "--check");
+
+        nthreads = cmdline_get_arg_long(cmdline, "--threads", 0);
+        if(nthreads < 0)
+            throw std::runtime_error("Number of threads must not be negative");
+
+        if(cmdline.size() != 0)
+        {
+            std::stringstream ss;
+            ss << "Unknown command line arguments:\n";
+            for(const auto & it : cmdline)
+                ss << "  " << it << "\n";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "\nError parsing command line: " << ex.what() << "\n\n";
+        std::cout << "Run \"mirp_check_library -h\" for help\n\n";
+        return 1;
+    }
+
+
+    try
+    {
+        long nfailed = -1;
+
+        if(check == "gtoeri_coincident")
+            nfailed = check_gtoeri_coincident();
+        else if(check == "gtoeri_bound")
+            nfailed = check_gtoeri_bound();
+        else if(check == "gtoeri_screened")
+            nfailed = check_gtoeri_screened();
+        else if(check == "format")
+            nfailed = check_format();
+        else if(check == "scheduler_ordered")
+            nfailed = check_scheduler_ordered(static_cast<int>(nthreads));
+        else if(check == "runtime_cycles")
+            nfailed = check_runtime_cycles();
+        else if(check == "basis_screen")
+            nfailed = check_basis_screen(static_cast<int>(nthreads));
+        else if(check == "exact_masked")
+            nfailed = check_exact_masked();
+        else if(check == "exact_prec")
+            nfailed = check_exact_prec();
+        else if(check == "exact_abandon")
+            nfailed = check_exact_abandon();
+        else if(check == "exact_zero")
+            nfailed = check_exact_zero();
+        else if(check == "exact_tol")
+            nfailed = check_exact_tol();
+        else
+        {
+            std::cout << "Check \"" << check << "\" is not valid\n";
+            return 3;
+        }
+
+        if(nfailed)
+            return 1;
+        else
+            return 0;
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "Error while running checks: " << ex.what() << "\n";
+        return 1;
+    }
+}
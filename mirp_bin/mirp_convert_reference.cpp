@@ -0,0 +1,98 @@
+/*! \file
+ *
+ * \brief mirp_convert_reference main function
+ */
+
+#include "mirp_bin/cmdline.hpp"
+#include "mirp_bin/reffile_binary.hpp"
+
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace mirp;
+
+
+static void print_help(void)
+{
+    std::cout << "\n"
+              << "mirp_convert_reference - Convert a reference data file between text and binary formats\n"
+              << "\n"
+              << "The format of the input file is detected automatically. By default, text files\n"
+              << "are converted to binary, and binary files are converted to text.\n"
+              << "\n"
+              << "\n"
+              << "Required arguments:\n"
+              << "    --infile       Reference file to convert\n"
+              << "    --outfile      Output file. Existing data will be overwritten\n"
+              << "\n"
+              << "\n"
+              << "Optional arguments:\n"
+              << "    --format       Format of the output file. Possibilities are:\n"
+              << "                       text, binary, compressed\n"
+              << "                   (compressed is the binary format with losslessly\n"
+              << "                   compressed integrals)\n"
+              << "\n"
+              << "\n"
+              << "Other arguments:\n"
+              << "    -h, --help     Display this help screen\n"
+              << "\n";
+}
+
+
+
+/*! \brief Main function */
+int main(int argc, char ** argv)
+{
+    std::string infile, outfile;
+    std::string format;
+    reffile_format outformat = reffile_format_binary;
+
+    try {
+        auto cmdline = convert_cmdline(argc, argv);
+        if(cmdline.size() == 0 || cmdline_get_switch(cmdline, "-h") || cmdline_get_switch(cmdline, "--help"))
+        {
+            print_help();
+            return 0;
+        }
+
+        infile = cmdline_get_arg_str(cmdline, "--infile");
+        outfile = cmdline_get_arg_str(cmdline, "--outfile");
+
+        // By default, convert to the other format
+        if(cmdline_has_arg(cmdline, "--format"))
+            format = cmdline_get_arg_str(cmdline, "--format");
+        else
+            format = reffile_is_binary(infile) ? "text" : "binary";
+
+        outformat = reffile_format_from_string(format);
+
+        if(cmdline.size() != 0)
+        {
+            std::stringstream ss;
+            ss << "Unknown command line arguments:\n";
+            for(const auto & it : cmdline)
+                ss << "  " << it << "\n";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "\nError parsing command line: " << ex.what() << "\n\n";
+        std::cout << "Run \"mirp_convert_reference -h\" for help\n\n";
+        return 1;
+    }
+
+    try
+    {
+        size_t nquartet = reffile_convert(infile, outfile, outformat);
+        std::cout << "Converted " << nquartet << " quartets to " << format << " format\n";
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "Error while converting: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*! \file
+ *
+ * \brief mirp_convert_test main function
+ */
+
+#include "mirp_bin/cmdline.hpp"
+#include "mirp_bin/testfile_binary.hpp"
+
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace mirp;
+
+
+static void print_help(void)
+{
+    std::cout << "\n"
+              << "mirp_convert_test - Convert a test data file from text to binary format\n"
+              << "\n"
+              << "The binary format stores the reference integrals exactly, so that they\n"
+              << "do not need to be parsed from strings when verifying. mirp_verify_test\n"
+              << "detects binary files automatically.\n"
+              << "\n"
+              << "\n"
+              << "Required arguments:\n"
+              << "    --integral     The type of integral in the file. Possibilities are:\n"
+              << "                       gtoeri\n"
+              << "    --infile       Test data file (text format) to convert\n"
+              << "    --outfile      Output file. Existing data will be overwritten\n"
+              << "\n"
+              << "\n"
+              << "Other arguments:\n"
+              << "    -h, --help     Display this help screen\n"
+              << "\n";
+}
+
+
+
+/*! \brief Main function */
+int main(int argc, char ** argv)
+{
+    std::string integral, infile, outfile;
+
+    try {
+        auto cmdline = convert_cmdline(argc, argv);
+        if(cmdline.size() == 0 || cmdline_get_switch(cmdline, "-h") || cmdline_get_switch(cmdline, "--help"))
+        {
+            print_help();
+            return 0;
+        }
+
+        integral = cmdline_get_arg_str(cmdline, "--integral");
+        infile = cmdline_get_arg_str(cmdline, "--infile");
+        outfile = cmdline_get_arg_str(cmdline, "--outfile");
+
+        if(cmdline.size() != 0)
+        {
+            std::stringstream ss;
+            ss << "Unknown command line arguments:\n";
+            for(const auto & it : cmdline)
+                ss << "  " << it << "\n";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "\nError parsing command line: " << ex.what() << "\n\n";
+        std::cout << "Run \"mirp_convert_test -h\" for help\n\n";
+        return 1;
+    }
+
+    try
+    {
+        size_t nentry = 0;
+
+        if(integral == "gtoeri")
+            nentry = testfile_convert_to_binary(infile, outfile, 4);
+        else
+        {
+            std::cout << "Integral \"" << integral << "\" is not valid\n";
+            return 2;
+        }
+
+        std::cout << "Converted " << nentry << " entries to binary format\n";
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "Error while converting: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
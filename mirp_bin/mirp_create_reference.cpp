@@ -35,6 +35,25 @@ static void print_help(void)
               << "    --am           Comma-separated list of AM classes to calculate.\n"
               << "                   The AM should be represented by their letters.\n"
               << "                   (for example, for ERI: --am ssss,psps,dddd)\n"
+              << "    --threads      Number of threads to compute quartets with. If 0, all\n"
+              << "                   available threads are used. The output does not\n"
+              << "                   depend on the number of threads (default: 1)\n"
+              << "    --format       Format of the output file. Possibilities are:\n"
+              << "                       text, binary, compressed\n"
+              << "                   (compressed is the binary format with losslessly\n"
+              << "                   compressed integrals; default: text)\n"
+              << "    --shard        Compute only one shard of the quartets, given as i/N\n"
+              << "                   (shard i of N, starting at 0). The quartets are split\n"
+              << "                   by their estimated cost. The files of all shards can\n"
+              << "                   be combined with mirp_merge_reference\n"
+              << "    --checkpoint   Minimum time (in seconds) between checkpoints, from\n"
+              << "                   which an interrupted run can be continued. If 0, a\n"
+              << "                   checkpoint is taken whenever possible (default: 60)\n"
+              << "    --resume       Continue an interrupted run from its checkpoint. All\n"
+              << "                   other arguments (except --threads) must be the same\n"
+              << "                   as for the interrupted run\n"
+              << "    --stop-after   Stop after computing this many quartets, leaving a\n"
+              << "                   checkpoint to continue from (default: 0, no limit)\n"
               << "\n"
               << "\n"
               << "Other arguments:\n"
@@ -50,6 +69,10 @@ int main(int argc, char ** argv)
     std::string basfile, xyzfile, outfile;
     std::string integral;
     std::vector<std::vector<int>> amlist;
+    long nthreads;
+    reffile_format format = reffile_format_text;
+    shard_spec shard;
+    checkpoint_options ckpt_opt;
 
     try {
         auto cmdline = convert_cmdline(argc, argv);
@@ -63,21 +86,28 @@ int main(int argc, char ** argv)
         xyzfile = cmdline_get_arg_str(cmdline, "--geometry");
         outfile = cmdline_get_arg_str(cmdline, "--outfile");
         integral = cmdline_get_arg_str(cmdline, "--integral");
+        nthreads = cmdline_get_arg_long(cmdline, "--threads", 1);
 
-        if(cmdline_has_arg(cmdline, "--am"))
-        {
-            std::string amlist_str = cmdline_get_arg_str(cmdline, "--am");
-            std::vector<std::string> amlist_split = split(amlist_str, ',');
+        if(nthreads < 0)
+            throw std::runtime_error("Number of threads must not be negative");
 
-            for(const auto & s : amlist_split)
-            {
-                std::vector<int> am_ntet;
-                for(char c : s)
-                    am_ntet.push_back(amchar_to_int(c));
-                amlist.push_back(std::move(am_ntet));
-            }
+        if(cmdline_has_arg(cmdline, "--shard"))
+            shard = shard_from_string(cmdline_get_arg_str(cmdline, "--shard"));
 
-        }
+        ckpt_opt.resume = cmdline_get_switch(cmdline, "--resume");
+        ckpt_opt.interval = static_cast<double>(cmdline_get_arg_long(cmdline, "--checkpoint", 60));
+        ckpt_opt.stop_after = cmdline_get_arg_long(cmdline, "--stop-after", 0);
+
+        if(ckpt_opt.interval < 0)
+            throw std::runtime_error("Checkpoint interval must not be negative");
+        if(ckpt_opt.stop_after < 0)
+            throw std::runtime_error("Number of quartets to stop after must not be negative");
+
+        if(cmdline_has_arg(cmdline, "--format"))
+            format = reffile_format_from_string(cmdline_get_arg_str(cmdline, "--format"));
+
+        if(cmdline_has_arg(cmdline, "--am"))
+            amlist = amlist_from_string(cmdline_get_arg_str(cmdline, "--am"));
 
         if(cmdline.size() != 0)
         {
@@ -95,21 +125,36 @@ int main(int argc, char ** argv)
         return 1;
     }
 
-    // Create a header from the command line
+    // Create a header from the command line. The number of threads, the format,
+    // and the checkpointing options are left out, since they do not change the
+    // contents of the file. The shard is left out so that all shards have the
+    // same header as the merged file
     std::string header("# Reference values for the ");
     header += integral;
     header += " integral generated with:\n";
     header += "#  ";
     for(int i = 0; i < argc; i++)
-        header += " " + std::string(argv[i]);
+    {
+        const std::string arg(argv[i]);
+        if(arg == "--threads" || arg == "--format" || arg == "--shard" ||
+           arg == "--checkpoint" || arg == "--stop-after")
+        {
+            i++;
+            continue;
+        }
+        if(arg == "--resume")
+            continue;
+        header += " " + arg;
+    }
     header += "\n#\n";
 
     try
     {
         if(integral == "gtoeri")
         {
-            integral4_create_reference(xyzfile, basfile, outfile, header,
-                                       amlist, mirp_gtoeri_exact);
+            integral4_create_reference(xyzfile, basfile, outfile, format, header,
+                                       amlist, static_cast<int>(nthreads),
+                                       shard, ckpt_opt, integral, mirp_gtoeri_single, mirp_gtoeri_bound);
         }
         else
         {
@@ -34,6 +34,23 @@ static void print_help(void)
               << "    --ndigits      Number of decimal digits to write for each integral\n"
               << "\n"
               << "\n"
+              << "Optional arguments:\n"
+              << "    --threads      Number of threads to use for gtoeri. If 0, all available\n"
+              << "                   threads are used. The output does not depend on the\n"
+              << "                   number of threads (default: 0)\n"
+              << "    --shard        Compute only one shard of the entries for gtoeri, given\n"
+              << "                   as i/N (shard i of N, starting at 0). The entries are\n"
+              << "                   split by their estimated cost\n"
+              << "    --checkpoint   Minimum time (in seconds) between checkpoints for gtoeri,\n"
+              << "                   from which an interrupted run can be continued. If 0,\n"
+              << "                   a checkpoint is taken whenever possible (default: 60)\n"
+              << "    --resume       Continue an interrupted run of gtoeri from its checkpoint.\n"
+              << "                   All other arguments (except --threads) must be the same\n"
+              << "                   as for the interrupted run\n"
+              << "    --stop-after   Stop after computing this many entries for gtoeri, leaving\n"
+              << "                   a checkpoint to continue from (default: 0, no limit)\n"
+              << "\n"
+              << "\n"
               << "Other arguments:\n"
               << "    -h, --help     Display this help screen\n"
               << "\n";
@@ -48,6 +65,9 @@ int main(int argc, char ** argv)
     std::string integral;
     long ndigits;
     long working_prec;
+    long nthreads;
+    shard_spec shard;
+    checkpoint_options ckpt_opt;
 
     try {
         auto cmdline = convert_cmdline(argc, argv);
@@ -62,6 +82,22 @@ int main(int argc, char ** argv)
         integral = cmdline_get_arg_str(cmdline, "--integral");
         ndigits = cmdline_get_arg_long(cmdline, "--ndigits");
         working_prec = cmdline_get_arg_long(cmdline, "--prec");
+        nthreads = cmdline_get_arg_long(cmdline, "--threads", 0);
+
+        if(nthreads < 0)
+            throw std::runtime_error("Number of threads must not be negative");
+
+        if(cmdline_has_arg(cmdline, "--shard"))
+            shard = shard_from_string(cmdline_get_arg_str(cmdline, "--shard"));
+
+        ckpt_opt.resume = cmdline_get_switch(cmdline, "--resume");
+        ckpt_opt.interval = static_cast<double>(cmdline_get_arg_long(cmdline, "--checkpoint", 60));
+        ckpt_opt.stop_after = cmdline_get_arg_long(cmdline, "--stop-after", 0);
+
+        if(ckpt_opt.interval < 0)
+            throw std::runtime_error("Checkpoint interval must not be negative");
+        if(ckpt_opt.stop_after < 0)
+            throw std::runtime_error("Number of entries to stop after must not be negative");
 
         if(cmdline.size() != 0)
         {
@@ -79,15 +115,37 @@ int main(int argc, char ** argv)
         return 1;
     }
 
-    // Create a header from the command line
+    // Create a header from the command line. The number of threads and the
+    // checkpointing options are left out, since they do not change the
+    // contents of the file. The shard is left out so that all shards have
+    // the same header
     std::string header("# Reference values for the ");
     header += integral;
     header += " integral generated with:\n";
     header += "#  ";
     for(int i = 0; i < argc; i++)
-        header += " " + std::string(argv[i]);
+    {
+        const std::string arg(argv[i]);
+        if(arg == "--threads" || arg == "--shard" ||
+           arg == "--checkpoint" || arg == "--stop-after")
+        {
+            i++;
+            continue;
+        }
+        if(arg == "--resume")
+            continue;
+        header += " " + arg;
+    }
     header += "\n#\n";
 
+    // Only gtoeri test files are written in a pipeline that can be sharded or checkpointed
+    const bool has_ckpt_opt = ckpt_opt.resume || ckpt_opt.stop_after > 0;
+    if((has_ckpt_opt || !shard.all()) && integral != "gtoeri")
+    {
+        std::cout << "Sharding and checkpointing options are not valid for integral \"" << integral << "\"\n";
+        return 3;
+    }
+
     try
     {
         if(integral == "boys")
@@ -96,6 +154,7 @@ int main(int argc, char ** argv)
         {
             integral_create_test<4>(infile, outfile,
                                     working_prec, ndigits, header,
+                                    static_cast<int>(nthreads), shard, ckpt_opt,
                                     mirp_gtoeri_str);
         }
         else if(integral == "gtoeri_single")
@@ -0,0 +1,104 @@
+/*! \file
+ *
+ * \brief mirp_merge_reference main function
+ */
+
+#include "mirp_bin/cmdline.hpp"
+#include "mirp_bin/reffile_binary.hpp"
+
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace mirp;
+
+
+static void print_help(void)
+{
+    std::cout << "\n"
+              << "mirp_merge_reference - Combine the shards of a reference data file\n"
+              << "\n"
+              << "The input files are created by mirp_create_reference with the same arguments,\n"
+              << "except for --shard. They may be given in any order and in any format. The\n"
+              << "merged file is the same as one created without --shard. The files of all\n"
+              << "shards must be given, which is checked using the shard recorded in each file.\n"
+              << "\n"
+              << "\n"
+              << "Required arguments:\n"
+              << "    --infile       Reference file of a shard. Given once for each shard\n"
+              << "    --outfile      Output file. Existing data will be overwritten\n"
+              << "\n"
+              << "\n"
+              << "Optional arguments:\n"
+              << "    --format       Format of the output file. Possibilities are:\n"
+              << "                       text, binary, compressed\n"
+              << "                   (compressed is the binary format with losslessly\n"
+              << "                   compressed integrals; default: text)\n"
+              << "\n"
+              << "\n"
+              << "Other arguments:\n"
+              << "    -h, --help     Display this help screen\n"
+              << "\n";
+}
+
+
+
+/*! \brief Main function */
+int main(int argc, char ** argv)
+{
+    std::vector<std::string> infiles;
+    std::string outfile;
+    std::string format = "text";
+    reffile_format outformat = reffile_format_text;
+
+    try {
+        auto cmdline = convert_cmdline(argc, argv);
+        if(cmdline.size() == 0 || cmdline_get_switch(cmdline, "-h") || cmdline_get_switch(cmdline, "--help"))
+        {
+            print_help();
+            return 0;
+        }
+
+        while(cmdline_has_arg(cmdline, "--infile"))
+            infiles.push_back(cmdline_get_arg_str(cmdline, "--infile"));
+
+        if(infiles.empty())
+            throw std::runtime_error("Required argument --infile is missing");
+
+        outfile = cmdline_get_arg_str(cmdline, "--outfile");
+
+        if(cmdline_has_arg(cmdline, "--format"))
+            format = cmdline_get_arg_str(cmdline, "--format");
+
+        outformat = reffile_format_from_string(format);
+
+        if(cmdline.size() != 0)
+        {
+            std::stringstream ss;
+            ss << "Unknown command line arguments:\n";
+            for(const auto & it : cmdline)
+                ss << "  " << it << "\n";
+            throw std::runtime_error(ss.str());
+        }
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "\nError parsing command line: " << ex.what() << "\n\n";
+        std::cout << "Run \"mirp_merge_reference -h\" for help\n\n";
+        return 1;
+    }
+
+    try
+    {
+        size_t nquartet = reffile_merge(infiles, outfile, outformat);
+        std::cout << "Merged " << nquartet << " quartets from " << infiles.size()
+                  << " files to " << format << " format\n";
+    }
+    catch(std::exception & ex)
+    {
+        std::cout << "Error while merging: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,6 +4,7 @@
  */
 
 #include "mirp_bin/cmdline.hpp"
+#include "mirp_bin/test_common.hpp"
 #include "mirp_bin/ref_integral.hpp"
 
 #include <mirp/kernels/all.h>
@@ -22,11 +23,31 @@ static void print_help(void)
               << "\n"
               << "\n"
               << "Required arguments:\n"
-              << "    --file         Reference file to test\n"
+              << "    --file         Reference file to test (text or binary format)\n"
               << "    --integral     The type of integral to compute. Possibilities are:\n"
               << "                       gtoeri\n"
               << "\n"
               << "\n"
+              << "Optional arguments:\n"
+              << "    --threads      Number of threads to use. If 0, all available threads\n"
+              << "                   are used (default: 0)\n"
+              << "    --am           Comma-separated list of AM classes to test.\n"
+              << "                   The AM should be represented by their letters.\n"
+              << "                   (for example, for ERI: --am ssss,psps,dddd)\n"
+              << "    --quartet      Shell indices of a single quartet to test\n"
+              << "                   (for example, --quartet 4,2,3,0)\n"
+              << "    --range        Range of quartets to test, by their position in the\n"
+              << "                   file (starting at 0, and not including the end).\n"
+              << "                   (for example, --range 100:200)\n"
+              << "    --shard        Test only one shard of the quartets of the file, given\n"
+              << "                   as i/N (shard i of N, starting at 0). The quartets are\n"
+              << "                   split by their estimated cost, in the same way as for\n"
+              << "                   mirp_create_reference\n"
+              << "\n"
+              << "If more than one of --am, --quartet, --range, and --shard are given, only quartets\n"
+              << "matching all of them are tested.\n"
+              << "\n"
+              << "\n"
               << "Other arguments:\n"
               << "    -h, --help     Display this help screen\n"
               << "\n";
@@ -38,6 +59,8 @@ static void print_help(void)
 int main(int argc, char ** argv)
 {
     std::string infile, integral;
+    long nthreads;
+    reffile_selection sel;
 
     try {
         auto cmdline = convert_cmdline(argc, argv);
@@ -49,6 +72,40 @@ int main(int argc, char ** argv)
 
         infile = cmdline_get_arg_str(cmdline, "--file");
         integral = cmdline_get_arg_str(cmdline, "--integral");
+        nthreads = cmdline_get_arg_long(cmdline, "--threads", 0);
+
+        if(nthreads < 0)
+            throw std::runtime_error("Number of threads must not be negative");
+
+        if(cmdline_has_arg(cmdline, "--am"))
+            sel.amlist = amlist_from_string(cmdline_get_arg_str(cmdline, "--am"));
+
+        if(cmdline_has_arg(cmdline, "--quartet"))
+        {
+            const std::vector<std::string> idx = split(cmdline_get_arg_str(cmdline, "--quartet"), ',');
+            if(idx.size() != 4)
+                throw std::runtime_error("A quartet must be given by four shell indices");
+
+            std::array<size_t, 4> quartet;
+            for(size_t n = 0; n < 4; n++)
+                quartet[n] = std::stoul(idx[n]);
+            sel.quartets.push_back(quartet);
+        }
+
+        if(cmdline_has_arg(cmdline, "--range"))
+        {
+            const std::vector<std::string> range = split(cmdline_get_arg_str(cmdline, "--range"), ':');
+            if(range.size() != 2)
+                throw std::runtime_error("A range must be given as start:end");
+
+            sel.first = std::stoul(range[0]);
+            sel.last = std::stoul(range[1]);
+            if(sel.last < sel.first)
+                throw std::runtime_error("The end of the range must not be before its start");
+        }
+
+        if(cmdline_has_arg(cmdline, "--shard"))
+            sel.shard = shard_from_string(cmdline_get_arg_str(cmdline, "--shard"));
 
         if(cmdline.size() != 0)
         {
@@ -72,7 +129,7 @@ int main(int argc, char ** argv)
 
         if(integral == "gtoeri")
         {
-            nfailed = integral_test_reference<4>(infile, mirp_gtoeri_exact);
+            nfailed = integral_test_reference<4>(infile, sel, static_cast<int>(nthreads), mirp_gtoeri_exact);
         }
         else
         {
@@ -38,6 +38,13 @@ static void print_help(void)
               << "  Boys Function:\n"
               << "    --extra-m      Initially compute this many more m values (to test recursion)\n"
               << "\n"
+              << "  Contracted integrals:\n"
+              << "    --threads      Number of threads to use. If 0, all available threads\n"
+              << "                   are used (default: 0)\n"
+              << "    --shard        Test only one shard of the entries, given as i/N\n"
+              << "                   (shard i of N, starting at 0). The entries are split\n"
+              << "                   by their estimated cost\n"
+              << "\n"
               << "\n"
               << "Other arguments:\n"
               << "    -h, --help     Display this help screen\n"
@@ -52,6 +59,8 @@ int main(int argc, char ** argv)
     std::string floattype;
     long working_prec = 0;
     int extra_m = 0;
+    long nthreads = 0;
+    shard_spec shard;
 
     try {
         auto cmdline = convert_cmdline(argc, argv);
@@ -75,6 +84,23 @@ int main(int argc, char ** argv)
         else if(cmdline_has_arg(cmdline, "--extra-m"))
             throw std::runtime_error("--extra-m is not valid for this integral type");
 
+        if(integral == "gtoeri")
+        {
+            nthreads = cmdline_get_arg_long(cmdline, "--threads", 0);
+            if(nthreads < 0)
+                throw std::runtime_error("Number of threads must not be negative");
+        }
+        else if(cmdline_has_arg(cmdline, "--threads"))
+            throw std::runtime_error("--threads is not valid for this integral type");
+
+        if(integral == "gtoeri")
+        {
+            if(cmdline_has_arg(cmdline, "--shard"))
+                shard = shard_from_string(cmdline_get_arg_str(cmdline, "--shard"));
+        }
+        else if(cmdline_has_arg(cmdline, "--shard"))
+            throw std::runtime_error("--shard is not valid for this integral type");
+
         if(cmdline.size() != 0)
         {
             std::stringstream ss;
@@ -120,11 +146,11 @@ int main(int argc, char ** argv)
         {
             if(floattype == "interval")
             {
-                nfailed = integral_verify_test<4>(file, working_prec, mirp_gtoeri_str);
+                nfailed = integral_verify_test<4>(file, working_prec, static_cast<int>(nthreads), shard, mirp_gtoeri_str);
             }
             else if(floattype == "exact")
             {
-                nfailed = integral_verify_test_exact<4>(file, mirp_gtoeri_exact, mirp_gtoeri);
+                nfailed = integral_verify_test_exact<4>(file, static_cast<int>(nthreads), shard, mirp_gtoeri_exact, mirp_gtoeri);
             }
             else
             {
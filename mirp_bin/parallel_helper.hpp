@@ -0,0 +1,97 @@
+/*! \file
+ *
+ * \brief Helpers for running tasks over multiple threads
+ */
+
+#pragma once
+
+#include <mirp/scheduler.h>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace mirp {
+
+
+/*! \brief Runs tasks over multiple threads using the MIRP scheduler
+ *
+ * This wraps \ref mirp_scheduler_run. Each thread gets its own (default-constructed)
+ * workspace of type \p Workspace.
+ *
+ * Exceptions thrown by the tasks are caught in the thread that ran them
+ * (they cannot be propagated through the C library). Once a task has thrown,
+ * remaining tasks are skipped and the first exception is rethrown once
+ * all threads have finished.
+ *
+ * \tparam Workspace Type of the per-thread workspace
+ */
+template<typename Workspace>
+struct parallel_helper
+{
+    typedef std::function<void(long, Workspace &)> task_type;
+
+
+    /*! \brief Runs tasks in parallel
+     *
+     * Results that must be written in task order can be passed through
+     * a \ref reorder_buffer.
+     *
+     * \param [in] ntasks   Number of tasks to run (numbered from 0)
+     * \param [in] nthreads Number of threads to use (0 for the default)
+     * \param [in] run_func Function that runs a single task
+     */
+    static void run(long ntasks, int nthreads,
+                    const task_type & run_func)
+    {
+        state st{run_func, {}, {}, {false}};
+
+        mirp_scheduler_run(ntasks, nthreads,
+                           ws_init, ws_clear,
+                           task_run, &st);
+
+        if(st.exception)
+            std::rethrow_exception(st.exception);
+    }
+
+
+private:
+    struct state
+    {
+        const task_type & run_func;
+        std::mutex mtx;
+        std::exception_ptr exception;
+        std::atomic<bool> failed;
+    };
+
+    static void * ws_init(void *)
+    {
+        return new Workspace;
+    }
+
+    static void ws_clear(void * ws, void *)
+    {
+        delete static_cast<Workspace *>(ws);
+    }
+
+    static void task_run(long task, void * ws, void * data)
+    {
+        state * st = static_cast<state *>(data);
+        if(st->failed)
+            return;
+
+        try {
+            st->run_func(task, *static_cast<Workspace *>(ws));
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> l(st->mtx);
+            if(!st->exception)
+                st->exception = std::current_exception();
+            st->failed = true;
+        }
+    }
+};
+
+} // close namespace mirp
+
@@ -0,0 +1,91 @@
+/*! \file
+ *
+ * \brief Periodic progress and throughput output for long-running programs
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace mirp {
+
+
+/*! \brief Prints a progress line at most once per interval
+ *
+ * The line contains the number of tasks done (out of the total), and the
+ * throughput in tasks and integrals per second since the start.
+ *
+ * This is not thread safe. It is meant to be updated from the
+ * (serialized) function that writes the results.
+ */
+class progress
+{
+public:
+    /*! \brief Starts the clock
+     *
+     * \param [in] what     Name of the tasks (for example, "quartets")
+     * \param [in] ntasks   Total number of tasks
+     * \param [in] interval Minimum time between lines (in seconds)
+     */
+    progress(const std::string & what, long ntasks, double interval = 10.0)
+        : what_(what), ntasks_(ntasks), interval_(interval),
+          ndone_(0), nintegrals_(0),
+          start_(clock::now()), last_(start_)
+    { }
+
+
+    /*! \brief Records that a task has been finished
+     *
+     * Prints a progress line if the interval has passed since the last one.
+     *
+     * \param [in] nintegrals Number of integrals computed by the task
+     */
+    void add(long nintegrals)
+    {
+        ndone_++;
+        nintegrals_ += nintegrals;
+
+        const clock::time_point now = clock::now();
+        if(std::chrono::duration<double>(now - last_).count() >= interval_)
+        {
+            last_ = now;
+            print();
+        }
+    }
+
+
+    /*! \brief Prints the final progress line */
+    void finish(void)
+    {
+        print();
+    }
+
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    const std::string what_;   /*!< Name of the tasks */
+    const long ntasks_;        /*!< Total number of tasks */
+    const double interval_;    /*!< Minimum time between lines (seconds) */
+    long ndone_;               /*!< Number of tasks finished */
+    long nintegrals_;          /*!< Number of integrals computed */
+    clock::time_point start_;  /*!< When the clock was started */
+    clock::time_point last_;   /*!< When the last line was printed */
+
+    void print(void) const
+    {
+        const double elapsed = std::chrono::duration<double>(clock::now() - start_).count();
+        const double percent = ntasks_ > 0 ? 100.0 * static_cast<double>(ndone_) / static_cast<double>(ntasks_) : 100.0;
+        const double rate = elapsed > 0.0 ? 1.0 / elapsed : 0.0;
+
+        printf("%10ld / %ld %s (%5.1f%%)  %10.2f %s/s  %12.2f integrals/s  %9.1f s\n",
+               ndone_, ntasks_, what_.c_str(), percent,
+               static_cast<double>(ndone_) * rate, what_.c_str(),
+               static_cast<double>(nintegrals_) * rate, elapsed);
+        fflush(stdout);
+    }
+};
+
+} // close namespace mirp
@@ -210,4 +210,25 @@ std::vector<gaussian_shell> read_construct_basis(const std::string & xyzfile,
     return basis;
 }
 
+
+/*! \brief Create a library basis (see mirp_basis) from a vector of shells */
+void basis_init_from_shells(mirp_basis * basis, const std::vector<gaussian_shell> & shells)
+{
+    std::vector<mirp_shell> s(shells.size());
+
+    for(size_t i = 0; i < shells.size(); i++)
+    {
+        s[i].am = shells[i].am;
+        s[i].nprim = shells[i].nprim;
+        s[i].ngeneral = shells[i].ngeneral;
+        s[i].xyz[0] = shells[i].xyz[0];
+        s[i].xyz[1] = shells[i].xyz[1];
+        s[i].xyz[2] = shells[i].xyz[2];
+        s[i].alpha = shells[i].alpha.data();
+        s[i].coeff = shells[i].coeff.data();
+    }
+
+    mirp_basis_init(basis, static_cast<int>(s.size()), s.data());
+}
+
 } // close namespace mirp
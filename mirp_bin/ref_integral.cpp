@@ -5,97 +5,324 @@
 
 #include "mirp_bin/ref_integral.hpp"
 #include "mirp_bin/reffile_io.hpp"
+#include "mirp_bin/reffile_binary.hpp"
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/shard.hpp"
+#include "mirp_bin/reffile_index.hpp"
 #include "mirp_bin/test_common.hpp"
 #include "mirp_bin/callback_helper.hpp"
+#include "mirp_bin/parallel_helper.hpp"
+#include "mirp_bin/reorder_buffer.hpp"
+#include "mirp_bin/progress.hpp"
 
 #include <mirp/pragma.h>
 #include <mirp/shell.h>
+#include <mirp/kernels/integral4_basis.h>
 
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#include <exception>
 
 namespace mirp {
 
+/*! \brief Number of quartets per thread that may be held in memory
+ *         while waiting to be written
+ *
+ * This is the slack that allows threads to keep working while an
+ * expensive quartet ahead of them is still being computed.
+ */
+static const long reorder_window_per_thread = 16;
+
+/*! \brief Receives computed quartets from the library, in order
+ *
+ * Exceptions thrown while writing are stored and stop the calculation.
+ * They are rethrown once the library has returned.
+ */
+struct quartet_sink
+{
+    std::function<void(const int *, const double *, long)> write;
+    std::exception_ptr error;
+
+    static int call(const int * shells, const double * integrals, long nintegrals, void * data)
+    {
+        quartet_sink * sink = static_cast<quartet_sink *>(data);
+
+        try {
+            sink->write(shells, integrals, nintegrals);
+            return 0;
+        }
+        catch(...)
+        {
+            sink->error = std::current_exception();
+            return 1;
+        }
+    }
+};
+
+
+/*! \brief Number of quartets (lines of a reference file) verified in a single task */
+static const long verify_chunk_size = 16;
+
+/*! \brief Per-thread storage for verifying quartets */
+struct verify_workspace
+{
+    std::vector<double> integrals, integrals_file;
+    std::istringstream ss;
+    reffile_cursor cursor;
+};
+
+
+/*! \brief A chunk of a reference file, and the results of checking it */
+struct verify_chunk
+{
+    std::vector<std::string> lines;  //!< Lines of the chunk (text files only)
+    std::string failures;            //!< Report of the failed integrals
+    long nfailed;                    //!< Number of failed integrals
+    long ncomputed;                  //!< Number of integrals computed
+};
+
+
+/*! \brief Number of integrals in a quartet, checking the shell indices */
+template<int N>
+static size_t verify_nintegrals(const mirp_basis & basis, const std::array<size_t, N> & idx)
+{
+    size_t nintegrals = 1;
+
+    for(int n = 0; n < N; n++)
+    {
+        if(idx[n] >= static_cast<size_t>(basis.nshell))
+            throw std::runtime_error("Shell index out of range in reference file");
+
+        nintegrals *= static_cast<size_t>(mirp_basis_nfunction(&basis, static_cast<int>(idx[n])));
+    }
+
+    return nintegrals;
+}
+
+
+/*! \brief Computes the integrals of a quartet and compares them to the
+ *         values from the file (in \p ws.integrals_file)
+ */
+template<int N, typename Func>
+static void verify_quartet(const mirp_basis & basis, const std::array<size_t, N> & idx,
+                           verify_workspace & ws, Func cb, verify_chunk & c)
+{
+    const size_t nintegrals = ws.integrals_file.size();
+    ws.integrals.resize(nintegrals);
+
+    callback_helper<N>::call_exact_basis(ws.integrals.data(), &basis, idx, cb);
+
+    for(size_t k = 0; k < nintegrals; k++)
+    {
+        PRAGMA_WARNING_PUSH
+        PRAGMA_WARNING_IGNORE_FP_EQUALITY
+
+        if(ws.integrals[k] != ws.integrals_file[k])
+        {
+            char buf[128];
+
+            c.failures += "Failed entry: ";
+
+            for(int n = 0; n < N; n++)
+            {
+                snprintf(buf, sizeof(buf), "%2d ", basis.am[idx[n]]);
+                c.failures += buf;
+            }
+
+            c.failures += ") ";
+
+            for(int n = 0; n < N; n++)
+            {
+                snprintf(buf, sizeof(buf), "%4lu ", idx[n]);
+                c.failures += buf;
+            }
+
+            snprintf(buf, sizeof(buf), "%7lu  -> %26.18e %26.18e\n", k, ws.integrals[k], ws.integrals_file[k]);
+            c.failures += buf;
+            c.nfailed++;
+        }
+
+        PRAGMA_WARNING_POP
+    }
+
+    c.ncomputed += static_cast<long>(nintegrals);
+}
+
+
 template<int N, typename Func>
 long integral_test_reference(const std::string & ref_filepath,
+                             const reffile_selection & sel,
+                             int nthreads,
                              Func cb)
 {
-    std::ifstream fs(ref_filepath);
-    if(!fs.is_open())
-        throw std::runtime_error("Error opening input file");
+    // Binary files, and text files of which only some quartets are
+    // checked, are read through an index of the quartets
+    std::unique_ptr<reffile_index> index;
+    std::vector<size_t> selected;
+    std::ifstream fs;
+    std::vector<gaussian_shell> shells;
+
+    if(!sel.all() || reffile_is_binary(ref_filepath))
+    {
+        if(N != 4)
+            throw std::runtime_error("Only four-center reference files can be indexed");
+
+        index.reset(new reffile_index(ref_filepath));
+        shells = index->shells();
+        selected = index->select(sel);
+
+        if(!sel.all())
+            printf("Selected %zu of %zu quartets\n", selected.size(), index->nquartet());
+    }
+    else
+    {
+        fs.open(ref_filepath);
+        if(!fs.is_open())
+            throw std::runtime_error("Error opening input file");
 
+        file_skip(fs, '#');
+        shells = reffile_read_basis(fs);
+    }
+
+    // Shell data is read directly from the basis, without copying
+    mirp_basis basis;
+    basis_init_from_shells(&basis, shells);
 
-    file_skip(fs, '#');
-    std::vector<gaussian_shell> shells = reffile_read_basis(fs);
+    nthreads = mirp_scheduler_nthreads(nthreads);
 
-    std::string line;
     long nfailed = 0;
     long ncomputed = 0;
 
-    std::array<std::array<double, 3>, N> xyz;
-    std::array<std::vector<double>, N> alpha, coeff;
-    std::array<int, N> am, nprim, ngeneral;
-
-    //#pragma omp parallel for schedule(dynamic) collapse(2)
-    while(fs.good())
+    // Failures are printed in the order of the file
+    auto write = [&](long, verify_chunk & c)
     {
-        std::array<size_t, N> idx;
+        fputs(c.failures.c_str(), stdout);
+        nfailed += c.nfailed;
+        ncomputed += c.ncomputed;
+    };
 
-        for(auto & it : idx)
-            fs >> it;
+    reorder_buffer<verify_chunk> buffer(reorder_window_per_thread * nthreads, write);
+    task_sequencer reader;
 
-        if(!fs.good())
-            break;
+    // Verifies quartets through the index, in any order
+    auto run_indexed = [&](long i, verify_workspace & ws, verify_chunk & c)
+    {
+        const size_t first = static_cast<size_t>(i * verify_chunk_size);
+        const size_t last = std::min(first + static_cast<size_t>(verify_chunk_size), selected.size());
 
-        size_t nintegrals = 1;
+        std::array<size_t, N> idx;
 
-        for(int n = 0; n < N; n++)
+        for(size_t j = first; j < last; j++)
         {
-            const gaussian_shell & s = shells.at(idx[n]);
-            nintegrals *= (MIRP_NCART(s.am)*s.ngeneral);
+            const reffile_quartet q = index->quartet(selected[j]);
+            for(int n = 0; n < N; n++)
+                idx[n] = q.idx[n];
+
+            if(verify_nintegrals<N>(basis, idx) != q.nintegrals)
+                throw std::runtime_error("Inconsistent number of integrals in reference file");
 
-            am[n] = s.am;
-            nprim[n] = s.nprim;
-            ngeneral[n] = s.ngeneral;
+            ws.integrals_file.resize(q.nintegrals);
+            index->read_integrals(selected[j], ws.cursor, ws.integrals_file.data());
 
-            xyz[n] = s.xyz;
-            alpha[n] = s.alpha;
-            coeff[n] = s.coeff;
+            verify_quartet<N>(basis, idx, ws, cb, c);
         }
+    };
 
-        std::vector<double> integrals(nintegrals);
-        std::vector<double> integrals_file(nintegrals);
+    // Verifies the quartets of a text file. Chunks are read from the
+    // file as tasks are started, one task at a time and in order
+    auto run_text = [&](long i, verify_workspace & ws, verify_chunk & c)
+    {
+        c.lines.clear();
+
+        const bool read = reader.run(i, [&]()
+        {
+            std::string line;
+            while(static_cast<long>(c.lines.size()) < verify_chunk_size && std::getline(fs, line))
+            {
+                if(line.find_first_not_of(" \t\r") != std::string::npos)
+                    c.lines.push_back(std::move(line));
+            }
+        });
 
-        for(size_t i = 0; i < nintegrals; i++)
-            integrals_file[i] = read_hexdouble(fs);
+        // If reading was aborted, so is the buffer, and
+        // this chunk is never written
+        if(!read)
+            return;
 
-        callback_helper<N>::call_exact(integrals.data(), am, xyz, nprim, ngeneral, alpha, coeff, cb);
+        std::array<size_t, N> idx;
 
-        for(size_t i = 0; i < nintegrals; i++)
+        for(const auto & line : c.lines)
         {
-            PRAGMA_WARNING_PUSH
-            PRAGMA_WARNING_IGNORE_FP_EQUALITY
-
-            if(integrals[i] != integrals_file[i])
-            {
-                printf("Failed entry: ");
+            ws.ss.clear();
+            ws.ss.str(line);
 
-                for(int n = 0; n < N; n++)
-                    printf("%2d ", am[n]);
+            for(auto & it : idx)
+                ws.ss >> it;
 
-                printf(") ");
+            if(!ws.ss.good())
+                throw std::runtime_error("Error reading shell indices from reference file");
 
-                for(int n = 0; n < N; n++)
-                    printf("%4lu ", idx[n]);
+            ws.integrals_file.resize(verify_nintegrals<N>(basis, idx));
+            for(auto & it : ws.integrals_file)
+                it = read_hexdouble(ws.ss);
 
-                printf("%7lu  -> %26.18e %26.18e\n", i, integrals[i], integrals_file[i]);
-                nfailed++;
-            }
+            verify_quartet<N>(basis, idx, ws, cb, c);
+        }
+    };
 
-            PRAGMA_WARNING_POP
+    auto run = [&](long i, verify_workspace & ws)
+    {
+        try {
+            buffer.run(i, [&](verify_chunk & c)
+            {
+                c.failures.clear();
+                c.nfailed = 0;
+                c.ncomputed = 0;
+
+                if(index)
+                    run_indexed(i, ws, c);
+                else
+                    run_text(i, ws, c);
+            });
         }
-        ncomputed += nintegrals;
+        catch(...)
+        {
+            reader.abort();
+            throw;
+        }
+    };
+
+    long nchunk = 0;
+    if(index)
+        nchunk = (static_cast<long>(selected.size()) + verify_chunk_size - 1) / verify_chunk_size;
+    else
+    {
+        // Blank lines are skipped, so this is an upper bound on the number
+        // of chunks (the last tasks may find nothing to do)
+        const std::streampos pos = fs.tellg();
+        long nlines = 0;
+        std::string line;
+        while(std::getline(fs, line))
+            nlines++;
+
+        fs.clear();
+        fs.seekg(pos);
+        nchunk = (nlines + verify_chunk_size - 1) / verify_chunk_size;
+    }
+
+    try {
+        parallel_helper<verify_workspace>::run(nchunk, nthreads, run);
     }
+    catch(...)
+    {
+        mirp_basis_clear(&basis);
+        throw;
+    }
+
+    mirp_basis_clear(&basis);
 
     print_results(nfailed, ncomputed);
 
@@ -105,22 +332,22 @@ long integral_test_reference(const std::string & ref_filepath,
 void integral4_create_reference(const std::string & xyz_filepath,
                                 const std::string & basis_filepath,
                                 const std::string & output_filepath,
+                                reffile_format format,
                                 const std::string & header,
                                 const std::vector<std::vector<int>> & amlist,
-                                cb_integral4_exact cb)
+                                int nthreads,
+                                const shard_spec & shard,
+                                const checkpoint_options & ckpt_opt,
+                                const std::string & integral,
+                                cb_integral4_single cb,
+                                cb_integral4_bound cb_bound)
 {
     std::vector<gaussian_shell> shells = read_construct_basis(xyz_filepath, basis_filepath);
 
     const size_t nshell = shells.size();
 
-    std::ofstream fs(output_filepath);
-    if(!fs.is_open())
-        throw std::runtime_error("Error opening output file for writing");
-
-    fs << header << "\n";
-    reffile_write_basis(shells, fs);
-
-    std::vector<double> integrals;
+    // Determine all quartets to compute, in the order they are written
+    std::vector<std::array<size_t, 4>> quartets;
 
     for(size_t p = 0; p < nshell; p++)
     for(size_t r = 0; r < nshell; r++)
@@ -133,38 +360,230 @@ void integral4_create_reference(const std::string & xyz_filepath,
         if(pq < rs)
             continue;
 
-        const auto & s1 = shells[p];
-        const auto & s2 = shells[q];
-        const auto & s3 = shells[r];
-        const auto & s4 = shells[s];
-
         // skip if this isn't in the amlist
         // (if amlist is empty, always compute)
-        std::vector<int> my_quartet{s1.am, s2.am, s3.am, s4.am};
+        std::vector<int> my_quartet{shells[p].am, shells[q].am, shells[r].am, shells[s].am};
         if(amlist.size() > 0 && std::find(amlist.begin(), amlist.end(), my_quartet) == amlist.end())
             continue;
 
+        quartets.push_back({{p, q, r, s}});
+    }
+
+    // Only the quartets of this shard are written. The file records the
+    // shard, so that the files of all the shards can be checked when merged
+    std::string file_header = header;
+
+    if(!shard.all())
+    {
+        std::vector<double> costs(quartets.size());
+        for(size_t i = 0; i < quartets.size(); i++)
+        {
+            costs[i] = 1.0;
+            for(size_t n : quartets[i])
+                costs[i] *= shard_shell_cost(shells[n].am, shells[n].nprim);
+        }
+
+        const std::pair<size_t, size_t> range = shard_range(costs, shard);
+        printf("Shard %zu/%zu: quartets %zu to %zu of %zu\n", shard.index, shard.count,
+               range.first, range.second, quartets.size());
+
+        file_header += reffile_shard_comment(shard, quartets.size());
+
+        quartets.erase(quartets.begin() + static_cast<std::ptrdiff_t>(range.second), quartets.end());
+        quartets.erase(quartets.begin(), quartets.begin() + static_cast<std::ptrdiff_t>(range.first));
+    }
+
+    const long nquartet = static_cast<long>(quartets.size());
+
+    auto quartet_nintegrals = [&](const std::array<size_t, 4> & idx)
+    {
+        const auto & s1 = shells[idx[0]];
+        const auto & s2 = shells[idx[1]];
+        const auto & s3 = shells[idx[2]];
+        const auto & s4 = shells[idx[3]];
+
         const size_t ncart = MIRP_NCART4(s1.am, s2.am, s3.am, s4.am);
         const size_t ngen = s1.ngeneral * s2.ngeneral * s3.ngeneral * s4.ngeneral;
-        const size_t nintegrals = ncart * ngen;
+        return ncart * ngen;
+    };
+
+    // Everything that determines the contents of the file. The shells are
+    // included exactly (not just the names of the input files)
+    std::ostringstream fingerprint;
+    fingerprint << integral << "\n" << file_header << "\n" << static_cast<int>(format) << "\n" << nquartet
+                << "\n" << shard.index << "/" << shard.count << "\n";
+
+    for(const auto & am : amlist)
+    {
+        for(int l : am)
+            fingerprint << l << " ";
+        fingerprint << "\n";
+    }
+
+    reffile_write_basis(shells, fingerprint);
 
-        integrals.resize(nintegrals);
+    checkpoint ckpt;
+    ckpt.fingerprint = checkpoint_fingerprint(fingerprint.str());
 
-        cb(integrals.data(),
-           s1.am, s1.xyz.data(), s1.nprim, s1.ngeneral, s1.alpha.data(), s1.coeff.data(),
-           s2.am, s2.xyz.data(), s2.nprim, s2.ngeneral, s2.alpha.data(), s2.coeff.data(),
-           s3.am, s3.xyz.data(), s3.nprim, s3.ngeneral, s3.alpha.data(), s3.coeff.data(),
-           s4.am, s4.xyz.data(), s4.nprim, s4.ngeneral, s4.alpha.data(), s4.coeff.data());
+    if(ckpt_opt.resume)
+    {
+        ckpt = checkpoint_resume(output_filepath, ckpt.fingerprint);
+        if(ckpt.ncomplete > static_cast<uint64_t>(nquartet))
+            throw std::runtime_error("Checkpoint has more quartets than are to be computed");
+
+        printf("Resuming after %lu of %ld quartets\n", static_cast<unsigned long>(ckpt.ncomplete), nquartet);
+    }
 
-        fs << p << " " << q << " " << r << " " << s;
-        for(size_t i = 0; i < nintegrals; i++)
+    // Text files are written directly. Binary files store
+    // the same comment lines as text files
+    std::unique_ptr<reffile_binary_writer> writer;
+    std::ofstream fs;
+
+    if(format == reffile_format_text)
+    {
+        if(ckpt_opt.resume)
         {
-            fs << " ";
-            write_hexdouble(integrals[i], fs);
+            fs.open(output_filepath, std::ofstream::in | std::ofstream::out);
+            if(!fs.is_open())
+                throw std::runtime_error("Error opening output file for writing");
+            fs.seekp(0, std::ofstream::end);
         }
+        else
+        {
+            fs.open(output_filepath);
+            if(!fs.is_open())
+                throw std::runtime_error("Error opening output file for writing");
 
-        fs << "\n";
+            fs << file_header << "\n";
+            reffile_write_basis(shells, fs);
+        }
     }
+    else
+    {
+        const reffile_encoding encoding = (format == reffile_format_compressed ?
+                                           reffile_encoding_compressed : reffile_encoding_raw);
+
+        if(ckpt_opt.resume)
+        {
+            writer.reset(new reffile_binary_writer(output_filepath, file_header + "\n", shells, encoding, ckpt));
+            for(uint64_t i = 0; i < ckpt.ncomplete; i++)
+                writer->restore_quartet(quartets[i], quartet_nintegrals(quartets[i]));
+        }
+        else
+            writer.reset(new reffile_binary_writer(output_filepath, file_header + "\n", shells, encoding));
+    }
+
+    // Quartets computed by this run
+    const long first = static_cast<long>(ckpt.ncomplete);
+    long ntask = nquartet - first;
+    if(ckpt_opt.stop_after > 0)
+        ntask = std::min(ntask, ckpt_opt.stop_after);
+
+    progress prog("quartets", ntask);
+    checkpoint_timer timer(ckpt_opt.interval);
+
+    // Records how much of the file is complete
+    auto save_checkpoint = [&](long nwritten)
+    {
+        if(writer)
+            writer->get_checkpoint(ckpt);
+        else
+        {
+            fs.flush();
+            if(!fs.good())
+                throw std::runtime_error("Error writing to output file");
+
+            ckpt.ncomplete = static_cast<uint64_t>(first + nwritten);
+            ckpt.offset = static_cast<uint64_t>(fs.tellp());
+        }
+
+        checkpoint_write(output_filepath, ckpt);
+    };
+
+    // The library passes the quartets to the sink in order, so the file
+    // does not depend on the number of threads
+    long nwritten = 0;
+    std::ostringstream ss;
+
+    quartet_sink sink;
+    sink.write = [&](const int * idx, const double * integrals, long nintegrals)
+    {
+        if(writer)
+            writer->write_quartet(quartets[static_cast<size_t>(first + nwritten)], integrals, static_cast<size_t>(nintegrals));
+        else
+        {
+            ss.str("");
+            ss << idx[0] << " " << idx[1] << " " << idx[2] << " " << idx[3];
+            for(long n = 0; n < nintegrals; n++)
+            {
+                ss << " ";
+                write_hexdouble(integrals[n], ss);
+            }
+
+            ss << "\n";
+
+            fs << ss.str();
+            if(!fs.good())
+                throw std::runtime_error("Error writing to output file");
+        }
+
+        nwritten++;
+        prog.add(nintegrals);
+
+        if(timer.due())
+            save_checkpoint(nwritten);
+    };
+
+    // Shell indices of the quartets computed by this run
+    std::vector<int> task_quartets;
+    task_quartets.reserve(4 * static_cast<size_t>(ntask));
+    for(long i = 0; i < ntask; i++)
+    {
+        for(size_t n : quartets[static_cast<size_t>(first + i)])
+            task_quartets.push_back(static_cast<int>(n));
+    }
+
+    // Shell data is read directly from the basis, without copying
+    mirp_basis basis;
+    basis_init_from_shells(&basis, shells);
+
+    const long nuncertified = mirp_integral4_basis_list_exact(&basis, ntask, task_quartets.data(), nthreads,
+                                                              cb, cb_bound, quartet_sink::call, &sink);
+
+    mirp_basis_clear(&basis);
+
+    if(sink.error)
+        std::rethrow_exception(sink.error);
+
+    // A reference file must only contain correctly-rounded values
+    if(nuncertified > 0)
+    {
+        std::ostringstream err;
+        err << nuncertified << " integrals could not be certified. The reference file is not valid";
+        throw std::runtime_error(err.str());
+    }
+
+    prog.finish();
+
+    // Stopped early, so the file can be continued later
+    if(first + ntask < nquartet)
+    {
+        save_checkpoint(ntask);
+        printf("Stopped with %lu of %ld quartets saved. Run again with --resume to continue\n",
+               static_cast<unsigned long>(ckpt.ncomplete), nquartet);
+        return;
+    }
+
+    if(writer)
+        writer->finish();
+    else
+    {
+        fs.close();
+        if(fs.fail())
+            throw std::runtime_error("Error writing to output file");
+    }
+
+    checkpoint_remove(output_filepath);
 }
 
 
@@ -172,7 +591,8 @@ void integral4_create_reference(const std::string & xyz_filepath,
  * Template instantiations
  **********************************/
 template long
-integral_test_reference<4, cb_integral4_exact>(const std::string &, cb_integral4_exact);
+integral_test_reference<4, cb_integral4_exact>(const std::string &, const reffile_selection &,
+                                               int, cb_integral4_exact);
 
 
 } // close namespace mirp
@@ -5,6 +5,11 @@
 
 #pragma once
 
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/reffile_binary.hpp"
+#include "mirp_bin/reffile_index.hpp"
+#include "mirp_bin/shard.hpp"
+
 #include <mirp/typedefs.h>
 #include <string>
 #include <vector>
@@ -16,6 +21,23 @@ namespace mirp {
  *
  * Any existing output file (given by \p output_filepath) will be overwritten.
  *
+ * Quartets are computed in parallel with \ref mirp_integral4_basis_list_exact,
+ * which passes them back in a fixed order. The output therefore does not depend on
+ * the number of threads, and only a limited number of computed quartets are held in memory.
+ * A progress line is printed periodically.
+ *
+ * If a shard is given, only its quartets are computed (see shard.hpp). The
+ * file is a reference file with only those quartets, whose header records the
+ * shard (see \ref reffile_shard_comment), and the files of all shards can be
+ * combined with \ref reffile_merge.
+ *
+ * Checkpoints are written periodically, from which an interrupted run can be
+ * continued (see checkpoint.hpp). The continued run must use the same arguments
+ * (except for the number of threads), and results in the same file as a run that
+ * was not interrupted. The checkpoint records a fingerprint of the integral, the
+ * shells that were read, and the AM classes, so a run with a changed molecule or
+ * basis set is not continued. The checkpoint is removed once the file is complete.
+ *
  * \throw std::runtime_error if there is a problem opening the file or there
  *        there is a problem reading or writing the data
  *
@@ -25,36 +47,62 @@ namespace mirp {
  * \param [in] xyz_filepath    Path to the XYZ file containing the molecule to use
  * \param [in] basis_filepath  Path to a basis set file to use
  * \param [in] output_filepath The output file to write the computed integrals to
+ * \param [in] format          Format of the output file
  * \param [in] header          Header information to add to the file
  *                             (appended to the input file header)
  * \param [in] amlist          Vector of AM classes to compute. If empty, all will be computed
- * \param [in] cb              Function that computes contracted integrals
- *                             to exact double precision
+ * \param [in] nthreads        Number of threads to compute quartets with (see
+ *                             \ref mirp_scheduler_nthreads)
+ * \param [in] shard           Shard of the quartets to compute
+ * \param [in] ckpt_opt        Options for checkpointing, continuing, and stopping early
+ * \param [in] integral        Name of the integral (identifies the run in a checkpoint)
+ * \param [in] cb              Function that computes a single integral
+ *                             using interval arithmetic
+ * \param [in] cb_bound        Function that computes an upper bound of the magnitude
+ *                             of the integrals of a primitive quartet (may be NULL)
  */
 void integral4_create_reference(const std::string & xyz_filepath,
                                 const std::string & basis_filepath,
                                 const std::string & output_filepath,
+                                reffile_format format,
                                 const std::string & header,
                                 const std::vector<std::vector<int>> & amlist,
-                                cb_integral4_exact cb);
+                                int nthreads,
+                                const shard_spec & shard,
+                                const checkpoint_options & ckpt_opt,
+                                const std::string & integral,
+                                cb_integral4_single cb,
+                                cb_integral4_bound cb_bound);
 
 
 /*! \brief Tests a reference file for consistency
+ *
+ * The file may be in text or binary format (see \ref reffile_binary).
+ * It is read in chunks of quartets, which are checked in parallel.
+ * If only some quartets are selected, they are found through a
+ * \ref reffile_index, and the rest of the file is not read.
+ * Failures are printed in the order of the file, so the output does not
+ * depend on the number of threads.
  *
  * \throw std::runtime_error if there is a problem opening the file or there
  *        there is a problem reading the data
  *
  * \param [in] ref_filepath    Path to the reference file
+ * \param [in] sel             Quartets to check
+ * \param [in] nthreads        Number of threads to use (see \ref mirp_scheduler_nthreads)
  * \param [in] cb              Function that computes contracted integrals
  *                             to exact double precision
  * \return Number of failed tests
  */
 template<int N, typename Func>
 long integral_test_reference(const std::string & ref_filepath,
+                             const reffile_selection & sel,
+                             int nthreads,
                              Func cb);
 
 extern template long
-integral_test_reference<4, cb_integral4_exact>(const std::string &, cb_integral4_exact);
+integral_test_reference<4, cb_integral4_exact>(const std::string &, const reffile_selection &,
+                                               int, cb_integral4_exact);
 
 } // close namespace mirp
 
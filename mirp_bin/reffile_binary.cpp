@@ -0,0 +1,926 @@
+/*! \file
+ *
+ * \brief Reading/writing reference data files in binary format
+ */
+
+#include "mirp_bin/reffile_binary.hpp"
+#include "mirp_bin/reffile_io.hpp"
+#include "mirp_bin/float_codec.hpp"
+#include "mirp_bin/binary_io.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/shell.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace mirp {
+
+/* Magic string at the start of the file */
+static const char reffile_magic[8] = {'M', 'I', 'R', 'P', 'R', 'E', 'F', 'B'};
+
+/* Sizes of the fixed-size parts of the file */
+static const size_t header_size = 128;
+static const size_t shell_size = 48;
+static const size_t quartet_size = 32;
+static const size_t block_size = 32;
+
+/* Locations of the section offsets/counts in the header */
+enum header_field
+{
+    field_comment = 16,
+    field_shell = 32,
+    field_param = 48,
+    field_integral = 64,
+    field_index = 80,
+    field_block = 96,
+    field_encoding = 112
+};
+
+
+/* Pads a buffer with zeros to a multiple of 8 bytes */
+static void pad8(std::vector<unsigned char> & buf)
+{
+    buf.resize((buf.size() + 7) / 8 * 8, 0);
+}
+
+
+/* Number of integrals for a quartet of shells */
+static size_t quartet_nintegrals(const std::vector<gaussian_shell> & shells,
+                                 const std::array<size_t, 4> & idx)
+{
+    size_t n = 1;
+    for(size_t i : idx)
+        n *= static_cast<size_t>(MIRP_NCART(shells[i].am) * shells[i].ngeneral);
+    return n;
+}
+
+
+reffile_format reffile_format_from_string(const std::string & name)
+{
+    if(name == "text")
+        return reffile_format_text;
+    if(name == "binary")
+        return reffile_format_binary;
+    if(name == "compressed")
+        return reffile_format_compressed;
+
+    throw std::runtime_error("Unknown reference file format \"" + name + "\"");
+}
+
+
+/*******************************************
+ * Reading
+ *******************************************/
+bool reffile_is_binary(const std::string & filepath)
+{
+    return file_has_magic(filepath, reffile_magic, sizeof(reffile_magic));
+}
+
+
+reffile_binary::reffile_binary(const std::string & filepath)
+    : file_(filepath), data_(file_.data()), size_(file_.size()),
+      encoding_(reffile_encoding_raw), integral_offset_(0), nintegral_(0), index_offset_(0), nquartet_(0)
+{
+    load("Error reading binary reference file " + filepath + ": ");
+}
+
+
+void reffile_binary::load(const std::string & err)
+{
+    // Checks that a section lies within the file
+    auto section = [&](int field, uint64_t elsize, const char * name)
+    {
+        const uint64_t offset = load_le(data_ + field, 8);
+        const uint64_t count = load_le(data_ + field + 8, 8);
+
+        if(offset > size_ || (elsize > 0 && count > (size_ - offset) / elsize))
+            throw std::runtime_error(err + "The " + name + " section extends beyond the end of the file");
+        return std::make_pair(offset, count);
+    };
+
+    if(size_ < header_size || std::memcmp(data_, reffile_magic, sizeof(reffile_magic)) != 0)
+        throw std::runtime_error(err + "Not a binary reference file");
+
+    const uint64_t version = load_le(data_ + 8, 4);
+    if(version != reffile_binary_version)
+    {
+        std::stringstream ss;
+        ss << err << "Unsupported version " << version << " (expected " << reffile_binary_version << ")";
+        throw std::runtime_error(ss.str());
+    }
+
+    if(load_le(data_ + 12, 4) != 4)
+        throw std::runtime_error(err + "Only four-center integrals are supported");
+
+    const uint64_t encoding = load_le(data_ + field_encoding, 4);
+    if(encoding != reffile_encoding_raw && encoding != reffile_encoding_compressed)
+        throw std::runtime_error(err + "Unknown encoding of the integrals");
+    encoding_ = static_cast<reffile_encoding>(encoding);
+
+    const auto comment = section(field_comment, 1, "comment");
+    const auto shell = section(field_shell, shell_size, "shell");
+    const auto param = section(field_param, 8, "shell parameter");
+    const auto integral = section(field_integral, 1, "integral");
+    const auto index = section(field_index, quartet_size, "quartet index");
+    const auto blocks = section(field_block, block_size, "block index");
+
+    comment_.assign(reinterpret_cast<const char *>(data_ + comment.first),
+                    static_cast<size_t>(comment.second));
+
+    shells_.resize(static_cast<size_t>(shell.second));
+    for(size_t i = 0; i < shells_.size(); i++)
+    {
+        const unsigned char * p = data_ + shell.first + i*shell_size;
+        auto & s = shells_[i];
+
+        s.am = static_cast<int>(load_le(p, 4));
+        s.nprim = static_cast<int>(load_le(p+4, 4));
+        s.ngeneral = static_cast<int>(load_le(p+8, 4));
+        for(int j = 0; j < 3; j++)
+            s.xyz[j] = load_double(p + 16 + 8*j);
+
+        const uint64_t start = load_le(p+40, 8);
+        const uint64_t nparam = static_cast<uint64_t>(s.nprim) * static_cast<uint64_t>(1 + s.ngeneral);
+
+        if(s.am < 0 || s.nprim <= 0 || s.ngeneral <= 0 || start > param.second || nparam > param.second - start)
+            throw std::runtime_error(err + "Invalid shell information");
+
+        const unsigned char * pp = data_ + param.first + 8*start;
+        s.alpha.resize(static_cast<size_t>(s.nprim));
+        s.coeff.resize(static_cast<size_t>(s.nprim*s.ngeneral));
+
+        for(auto & a : s.alpha)
+        {
+            a = load_double(pp);
+            pp += 8;
+        }
+        for(auto & c : s.coeff)
+        {
+            c = load_double(pp);
+            pp += 8;
+        }
+    }
+
+    integral_offset_ = integral.first;
+    index_offset_ = index.first;
+    nquartet_ = static_cast<size_t>(index.second);
+
+    // Blocks must cover all quartets, in order
+    nintegral_ = 0;
+    uint64_t next_quartet = 0;
+
+    blocks_.resize(static_cast<size_t>(blocks.second));
+    block_data_.resize(blocks_.size());
+
+    for(size_t i = 0; i < blocks_.size(); i++)
+    {
+        const unsigned char * p = data_ + blocks.first + i*block_size;
+        const uint64_t offset = load_le(p, 8);
+        const uint64_t size = load_le(p+8, 8);
+        auto & b = blocks_[i];
+
+        b.first_quartet = static_cast<size_t>(load_le(p+16, 8));
+        b.nquartet = static_cast<size_t>(load_le(p+24, 4));
+        b.nintegrals = static_cast<size_t>(load_le(p+28, 4));
+        b.start = nintegral_;
+
+        if(offset > integral.second || size > integral.second - offset ||
+           b.first_quartet != next_quartet || b.nquartet == 0 ||
+           (encoding_ == reffile_encoding_raw && size != 8*static_cast<uint64_t>(b.nintegrals)))
+            throw std::runtime_error(err + "Invalid block information");
+
+        block_data_[i] = std::make_pair(integral.first + offset, size);
+        next_quartet += b.nquartet;
+        nintegral_ += b.nintegrals;
+    }
+
+    if(next_quartet != nquartet_)
+        throw std::runtime_error(err + "Blocks do not cover all quartets");
+}
+
+
+reffile_quartet reffile_binary::quartet(size_t i) const
+{
+    if(i >= nquartet_)
+        throw std::out_of_range("Quartet index out of range in binary reference file");
+
+    const unsigned char * p = data_ + index_offset_ + i*quartet_size;
+
+    reffile_quartet q;
+    for(int n = 0; n < 4; n++)
+    {
+        q.idx[n] = static_cast<size_t>(load_le(p + 4*n, 4));
+        q.am[n] = p[16+n];
+
+        if(q.idx[n] >= shells_.size())
+            throw std::runtime_error("Shell index out of range in binary reference file");
+    }
+
+    q.nintegrals = static_cast<size_t>(load_le(p+20, 4));
+    q.start = load_le(p+24, 8);
+
+    // The integrals must lie within the block of the quartet
+    const reffile_block & b = blocks_[find_block(i)];
+    if(q.start < b.start || q.start - b.start > b.nintegrals || q.nintegrals > b.nintegrals - (q.start - b.start))
+        throw std::runtime_error("Quartet extends beyond its block in binary reference file");
+
+    return q;
+}
+
+
+const reffile_block & reffile_binary::block(size_t b) const
+{
+    if(b >= blocks_.size())
+        throw std::out_of_range("Block index out of range in binary reference file");
+    return blocks_[b];
+}
+
+
+size_t reffile_binary::find_block(size_t i) const
+{
+    if(i >= nquartet_)
+        throw std::out_of_range("Quartet index out of range in binary reference file");
+
+    // The last block starting at or before the quartet
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), i,
+                               [](size_t j, const reffile_block & b) { return j < b.first_quartet; });
+    return static_cast<size_t>(it - blocks_.begin()) - 1;
+}
+
+
+void reffile_binary::read_block(size_t b, double * integrals) const
+{
+    const reffile_block & blk = block(b);
+    const unsigned char * p = data_ + block_data_[b].first;
+
+    if(encoding_ == reffile_encoding_compressed)
+        float_block_decode(p, static_cast<size_t>(block_data_[b].second), integrals, blk.nintegrals);
+    else
+    {
+        for(size_t i = 0; i < blk.nintegrals; i++)
+            integrals[i] = load_double(p + 8*i);
+    }
+}
+
+
+void reffile_binary::read_integrals(const reffile_quartet & q, double * integrals) const
+{
+    // The last block starting at or before the first integral
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), q.start,
+                               [](uint64_t start, const reffile_block & b) { return start < b.start; });
+    if(it == blocks_.begin())
+        throw std::runtime_error("Quartet is not part of any block in binary reference file");
+
+    const size_t b = static_cast<size_t>(it - blocks_.begin()) - 1;
+    const size_t offset = static_cast<size_t>(q.start - blocks_[b].start);
+
+    if(q.nintegrals > blocks_[b].nintegrals - offset)
+        throw std::runtime_error("Quartet extends beyond its block in binary reference file");
+
+    if(encoding_ == reffile_encoding_compressed)
+    {
+        std::vector<double> tmp(blocks_[b].nintegrals);
+        read_block(b, tmp.data());
+        std::copy(tmp.begin() + offset, tmp.begin() + offset + q.nintegrals, integrals);
+    }
+    else
+    {
+        const unsigned char * p = data_ + block_data_[b].first + 8*offset;
+        for(size_t i = 0; i < q.nintegrals; i++)
+            integrals[i] = load_double(p + 8*i);
+    }
+}
+
+
+/*******************************************
+ * Writing
+ *******************************************/
+reffile_binary_writer::reffile_binary_writer(const std::string & filepath,
+                                             const std::string & comment,
+                                             const std::vector<gaussian_shell> & shells,
+                                             reffile_encoding encoding)
+    : encoding_(encoding), integral_offset_(0), integral_size_(0),
+      nintegral_(0), nquartet_(0), block_first_(0), block_nintegral_(0),
+      restore_nquartet_(0)
+{
+    fs_.open(filepath, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if(!fs_.is_open())
+        throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
+
+    fs_.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+
+    const std::vector<unsigned char> buf = build_prefix(comment, shells);
+    fs_.write(reinterpret_cast<const char *>(buf.data()), static_cast<std::streamsize>(buf.size()));
+}
+
+
+reffile_binary_writer::reffile_binary_writer(const std::string & filepath,
+                                             const std::string & comment,
+                                             const std::vector<gaussian_shell> & shells,
+                                             reffile_encoding encoding,
+                                             const checkpoint & ckpt)
+    : encoding_(encoding), integral_offset_(0), integral_size_(0),
+      nintegral_(0), nquartet_(0), block_first_(0), block_nintegral_(0),
+      restore_nquartet_(ckpt.ncomplete), restore_sizes_(ckpt.block_sizes)
+{
+    const std::string err = "Error continuing file " + filepath + ": ";
+    const std::vector<unsigned char> buf = build_prefix(comment, shells);
+
+    // Everything before the integrals must be the same as what would be
+    // written now (the header is only completed when the file is finished)
+    {
+        std::ifstream fs(filepath, std::ifstream::binary);
+        std::vector<unsigned char> existing(buf.size());
+
+        if(!fs.read(reinterpret_cast<char *>(existing.data()), static_cast<std::streamsize>(existing.size())))
+            throw std::runtime_error(err + "File is too short");
+        if(existing != buf)
+            throw std::runtime_error(err + "File does not match the arguments");
+    }
+
+    uint64_t size = integral_offset_;
+    for(auto it : restore_sizes_)
+        size += it;
+
+    if(size != ckpt.offset)
+        throw std::runtime_error(err + "Block sizes do not match the size in the checkpoint");
+
+    fs_.open(filepath, std::ofstream::in | std::ofstream::out | std::ofstream::binary);
+    if(!fs_.is_open())
+        throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
+
+    fs_.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+    fs_.seekp(0, std::ofstream::end);
+
+    if(static_cast<uint64_t>(fs_.tellp()) != ckpt.offset)
+        throw std::runtime_error(err + "Size of the file does not match the checkpoint");
+}
+
+
+std::vector<unsigned char> reffile_binary_writer::build_prefix(const std::string & comment,
+                                                               const std::vector<gaussian_shell> & shells)
+{
+    // Everything before the integrals is built in memory
+    std::vector<unsigned char> buf(reffile_magic, reffile_magic + sizeof(reffile_magic));
+    append_le(buf, reffile_binary_version, 4);
+    append_le(buf, 4, 4);
+    buf.resize(header_size, 0);
+    store_le(buf.data() + field_encoding, encoding_, 4);
+
+    // Comment
+    store_le(buf.data() + field_comment, buf.size(), 8);
+    store_le(buf.data() + field_comment + 8, comment.size(), 8);
+    buf.insert(buf.end(), comment.begin(), comment.end());
+    pad8(buf);
+
+    // Shells
+    store_le(buf.data() + field_shell, buf.size(), 8);
+    store_le(buf.data() + field_shell + 8, shells.size(), 8);
+
+    uint64_t nparam = 0;
+    am_.clear();
+    for(const auto & s : shells)
+    {
+        append_le(buf, static_cast<uint64_t>(s.am), 4);
+        append_le(buf, static_cast<uint64_t>(s.nprim), 4);
+        append_le(buf, static_cast<uint64_t>(s.ngeneral), 4);
+        append_le(buf, 0, 4);
+        for(double x : s.xyz)
+            append_double(buf, x);
+        append_le(buf, nparam, 8);
+
+        nparam += s.alpha.size() + s.coeff.size();
+        am_.push_back(s.am);
+    }
+
+    // Shell parameters
+    store_le(buf.data() + field_param, buf.size(), 8);
+    store_le(buf.data() + field_param + 8, nparam, 8);
+
+    for(const auto & s : shells)
+    {
+        for(double a : s.alpha)
+            append_double(buf, a);
+        for(double c : s.coeff)
+            append_double(buf, c);
+    }
+
+    integral_offset_ = buf.size();
+    store_le(buf.data() + field_integral, integral_offset_, 8);
+
+    header_.assign(buf.begin(), buf.begin() + header_size);
+    return buf;
+}
+
+
+void reffile_binary_writer::append_quartet(const std::array<size_t, 4> & idx, size_t nintegrals)
+{
+    for(size_t i : idx)
+    {
+        if(i >= am_.size())
+            throw std::runtime_error("Shell index out of range when writing binary reference file");
+    }
+
+    if(nintegrals > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Too many integrals in a quartet for the binary reference format");
+
+    for(size_t i : idx)
+        append_le(index_, i, 4);
+    for(size_t i : idx)
+        index_.push_back(static_cast<unsigned char>(am_[i]));
+    append_le(index_, nintegrals, 4);
+    append_le(index_, nintegral_, 8);
+
+    nintegral_ += nintegrals;
+    block_nintegral_ += nintegrals;
+    nquartet_++;
+}
+
+
+void reffile_binary_writer::write_quartet(const std::array<size_t, 4> & idx,
+                                          const double * integrals, size_t nintegrals)
+{
+    if(nquartet_ < restore_nquartet_)
+        throw std::logic_error("Quartets before the checkpoint must be restored before writing");
+
+    append_quartet(idx, nintegrals);
+    block_.insert(block_.end(), integrals, integrals + nintegrals);
+
+    if(block_nintegral_ >= reffile_block_nintegrals)
+        write_block();
+}
+
+
+void reffile_binary_writer::restore_quartet(const std::array<size_t, 4> & idx, size_t nintegrals)
+{
+    if(nquartet_ >= restore_nquartet_)
+        throw std::logic_error("Restoring more quartets than are in the checkpoint");
+
+    append_quartet(idx, nintegrals);
+
+    // Blocks end at the same quartets as when they were written
+    if(block_nintegral_ >= reffile_block_nintegrals)
+    {
+        const size_t b = block_sizes_.size();
+        if(b >= restore_sizes_.size())
+            throw std::runtime_error("Quartets do not match the checkpoint");
+        close_block(restore_sizes_[b]);
+    }
+
+    if(nquartet_ == restore_nquartet_ &&
+       (block_first_ != nquartet_ || block_sizes_.size() != restore_sizes_.size()))
+        throw std::runtime_error("Quartets do not match the checkpoint");
+}
+
+
+void reffile_binary_writer::close_block(uint64_t size)
+{
+    if(block_nintegral_ > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Too many integrals in a block for the binary reference format");
+
+    append_le(block_index_, integral_size_, 8);
+    append_le(block_index_, size, 8);
+    append_le(block_index_, block_first_, 8);
+    append_le(block_index_, nquartet_ - block_first_, 4);
+    append_le(block_index_, block_nintegral_, 4);
+
+    integral_size_ += size;
+    block_sizes_.push_back(size);
+    block_first_ = nquartet_;
+    block_nintegral_ = 0;
+}
+
+
+void reffile_binary_writer::write_block(void)
+{
+    buf_.clear();
+    if(encoding_ == reffile_encoding_compressed)
+        float_block_encode(block_.data(), block_.size(), buf_);
+    else
+    {
+        for(double d : block_)
+            append_double(buf_, d);
+    }
+
+    fs_.write(reinterpret_cast<const char *>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+
+    close_block(buf_.size());
+    block_.clear();
+}
+
+
+void reffile_binary_writer::get_checkpoint(checkpoint & ckpt)
+{
+    fs_.flush();
+
+    ckpt.ncomplete = block_first_;
+    ckpt.offset = integral_offset_ + integral_size_;
+    ckpt.block_sizes = block_sizes_;
+}
+
+
+void reffile_binary_writer::finish(void)
+{
+    if(nquartet_ > block_first_)
+        write_block();
+
+    // Keep the indices aligned
+    const std::vector<unsigned char> padding((8 - integral_size_ % 8) % 8, 0);
+    fs_.write(reinterpret_cast<const char *>(padding.data()), static_cast<std::streamsize>(padding.size()));
+
+    const uint64_t index_offset = integral_offset_ + integral_size_ + padding.size();
+
+    store_le(header_.data() + field_integral + 8, integral_size_, 8);
+    store_le(header_.data() + field_index, index_offset, 8);
+    store_le(header_.data() + field_index + 8, nquartet_, 8);
+    store_le(header_.data() + field_block, index_offset + index_.size(), 8);
+    store_le(header_.data() + field_block + 8, block_index_.size() / block_size, 8);
+
+    fs_.write(reinterpret_cast<const char *>(index_.data()), static_cast<std::streamsize>(index_.size()));
+    fs_.write(reinterpret_cast<const char *>(block_index_.data()), static_cast<std::streamsize>(block_index_.size()));
+
+    fs_.seekp(0);
+    fs_.write(reinterpret_cast<const char *>(header_.data()), static_cast<std::streamsize>(header_.size()));
+    fs_.close();
+}
+
+
+/*******************************************
+ * Conversion
+ *******************************************/
+/*******************************************
+ * Conversion and merging
+ *******************************************/
+
+/* A reference file being read in order (text or binary) */
+struct reffile_input
+{
+    std::string filepath;
+    std::unique_ptr<reffile_binary> binfile;
+    std::ifstream fs;
+    std::string comment;
+    std::vector<gaussian_shell> shells;
+
+    /* Opens the file, and reads the comment and basis */
+    explicit reffile_input(const std::string & path)
+        : filepath(path)
+    {
+        if(reffile_is_binary(filepath))
+        {
+            binfile.reset(new reffile_binary(filepath));
+            comment = binfile->comment();
+            shells = binfile->shells();
+        }
+        else
+        {
+            fs.open(filepath);
+            if(!fs.is_open())
+                throw std::runtime_error("Error opening input file " + filepath);
+
+            comment = reffile_read_comment(fs);
+            shells = reffile_read_basis(fs);
+        }
+    }
+
+
+    /* Obtains the shell indices of the first quartet (returns false if there are none) */
+    bool first_quartet(std::array<size_t, 4> & idx)
+    {
+        if(binfile)
+        {
+            if(binfile->nquartet() == 0)
+                return false;
+            idx = binfile->quartet(0).idx;
+            return true;
+        }
+
+        const std::streampos pos = fs.tellg();
+        const bool found = file_skip(fs, '#');
+        if(found)
+        {
+            for(auto & it : idx)
+                fs >> it;
+            if(!fs.good())
+                throw std::runtime_error("Error reading shell indices from reference file " + filepath);
+        }
+
+        fs.clear();
+        fs.seekg(pos);
+        return found;
+    }
+
+
+    /* Reads all the quartets, passing each to func(idx, integrals, nintegrals) */
+    template<typename Func>
+    void read_quartets(Func func)
+    {
+        std::vector<double> integrals;
+
+        if(binfile)
+        {
+            // Binary files are decoded a block at a time
+            for(size_t b = 0; b < binfile->nblock(); b++)
+            {
+                const reffile_block & blk = binfile->block(b);
+                integrals.resize(blk.nintegrals);
+                binfile->read_block(b, integrals.data());
+
+                for(size_t i = blk.first_quartet; i < blk.first_quartet + blk.nquartet; i++)
+                {
+                    const reffile_quartet q = binfile->quartet(i);
+                    func(q.idx, integrals.data() + (q.start - blk.start), q.nintegrals);
+                }
+            }
+        }
+        else
+        {
+            std::array<size_t, 4> idx;
+
+            while(file_skip(fs, '#'))
+            {
+                for(auto & it : idx)
+                    fs >> it;
+
+                if(!fs.good())
+                    throw std::runtime_error("Error reading shell indices from reference file");
+
+                for(size_t i : idx)
+                {
+                    if(i >= shells.size())
+                        throw std::runtime_error("Shell index out of range in reference file");
+                }
+
+                integrals.resize(quartet_nintegrals(shells, idx));
+                for(auto & it : integrals)
+                    it = read_hexdouble(fs);
+
+                func(idx, integrals.data(), integrals.size());
+            }
+        }
+    }
+};
+
+
+/* A reference file being written in order (text or binary) */
+struct reffile_output
+{
+    std::unique_ptr<reffile_binary_writer> writer;
+    std::ofstream fs;
+
+    reffile_output(const std::string & filepath, reffile_format format,
+                   const std::string & comment, const std::vector<gaussian_shell> & shells)
+    {
+        if(format == reffile_format_text)
+        {
+            fs.open(filepath);
+            if(!fs.is_open())
+                throw std::runtime_error("Error opening output file for writing");
+
+            fs.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+            fs << comment;
+            reffile_write_basis(shells, fs);
+        }
+        else
+        {
+            const reffile_encoding encoding = (format == reffile_format_compressed ?
+                                               reffile_encoding_compressed : reffile_encoding_raw);
+            writer.reset(new reffile_binary_writer(filepath, comment, shells, encoding));
+        }
+    }
+
+
+    void write(const std::array<size_t, 4> & idx, const double * integrals, size_t nintegrals)
+    {
+        if(writer)
+        {
+            writer->write_quartet(idx, integrals, nintegrals);
+            return;
+        }
+
+        fs << idx[0] << " " << idx[1] << " " << idx[2] << " " << idx[3];
+        for(size_t i = 0; i < nintegrals; i++)
+        {
+            fs << " ";
+            write_hexdouble(integrals[i], fs);
+        }
+
+        fs << "\n";
+    }
+
+
+    void finish(void)
+    {
+        if(writer)
+            writer->finish();
+        else
+            fs.close();
+    }
+};
+
+
+/* Whether two bases are exactly the same */
+static bool same_shells(const std::vector<gaussian_shell> & a, const std::vector<gaussian_shell> & b)
+{
+    if(a.size() != b.size())
+        return false;
+
+    for(size_t i = 0; i < a.size(); i++)
+    {
+        if(a[i].am != b[i].am || a[i].nprim != b[i].nprim || a[i].ngeneral != b[i].ngeneral ||
+           a[i].xyz != b[i].xyz || a[i].alpha != b[i].alpha || a[i].coeff != b[i].coeff)
+            return false;
+    }
+
+    return true;
+}
+
+
+/* Replaces the output file in the command line recorded in a header */
+static std::string replace_outfile(const std::string & comment, const std::string & outfile)
+{
+    const std::string key = " --outfile ";
+    const size_t pos = comment.find(key);
+    if(pos == std::string::npos)
+        return comment;
+
+    const size_t start = pos + key.size();
+    const size_t end = comment.find_first_of(" \n", start);
+    return comment.substr(0, start) + outfile + comment.substr(end == std::string::npos ? comment.size() : end);
+}
+
+
+/* Start of the comment line recording the shard of a file */
+static const std::string shard_comment_key = "# Shard ";
+
+
+/* Finds and removes the line recording the shard from a header
+ *
+ * Returns false if the header does not have the line.
+ */
+static bool remove_shard_comment(std::string & comment, shard_spec & shard, size_t & nquartet)
+{
+    const size_t pos = comment.find("\n" + shard_comment_key);
+    if(pos == std::string::npos)
+        return false;
+
+    const size_t start = pos + 1;
+    const size_t end = comment.find('\n', start);
+    if(end == std::string::npos)
+        return false;
+
+    const size_t spec_start = start + shard_comment_key.size();
+    std::istringstream ss(comment.substr(spec_start, end - spec_start));
+    std::string spec, of, quartets;
+    if(!(ss >> spec >> of >> nquartet >> quartets) || of != "of" || quartets != "quartets")
+        return false;
+
+    shard = shard_from_string(spec);
+    comment.erase(start, end + 1 - start);
+    return true;
+}
+
+
+std::string reffile_shard_comment(const shard_spec & shard, size_t nquartet)
+{
+    std::stringstream ss;
+    ss << shard_comment_key << shard.index << "/" << shard.count << " of " << nquartet << " quartets\n";
+    return ss.str();
+}
+
+
+/* Position of a quartet in the order written by mirp_create_reference */
+static std::array<size_t, 4> quartet_order(const std::array<size_t, 4> & idx)
+{
+    return {{idx[0], idx[2], idx[1], idx[3]}};
+}
+
+
+size_t reffile_convert(const std::string & in_filepath,
+                       const std::string & out_filepath,
+                       reffile_format format)
+{
+    reffile_input in(in_filepath);
+    reffile_output out(out_filepath, format, in.comment, in.shells);
+
+    size_t nquartet = 0;
+
+    in.read_quartets([&](const std::array<size_t, 4> & idx, const double * integrals, size_t nintegrals)
+    {
+        out.write(idx, integrals, nintegrals);
+        nquartet++;
+    });
+
+    out.finish();
+    return nquartet;
+}
+
+
+size_t reffile_merge(const std::vector<std::string> & in_filepaths,
+                     const std::string & out_filepath,
+                     reffile_format format)
+{
+    if(in_filepaths.empty())
+        throw std::runtime_error("No files to merge");
+
+    // Open all the files, and order them by their first quartet.
+    // Files without any quartets are only checked
+    std::vector<std::unique_ptr<reffile_input>> inputs;
+    std::vector<std::pair<std::array<size_t, 4>, size_t>> order;
+
+    // Files of each shard, and the number of quartets of all the shards
+    std::vector<std::string> shard_files;
+    size_t nquartet_total = 0;
+
+    for(const auto & path : in_filepaths)
+    {
+        inputs.emplace_back(new reffile_input(path));
+        reffile_input & in = *inputs.back();
+        const reffile_input & in0 = *inputs.front();
+
+        shard_spec shard;
+        size_t nquartet_shards;
+        if(!remove_shard_comment(in.comment, shard, nquartet_shards))
+            throw std::runtime_error(path + " does not record a shard (it was not created with --shard)");
+
+        if(shard_files.empty())
+        {
+            shard_files.resize(shard.count);
+            nquartet_total = nquartet_shards;
+        }
+        else if(shard.count != shard_files.size() || nquartet_shards != nquartet_total)
+            throw std::runtime_error("Shards of " + path + " are different from " + in0.filepath);
+
+        if(!shard_files[shard.index].empty())
+            throw std::runtime_error("Shard " + std::to_string(shard.index) + " is in both " +
+                                     shard_files[shard.index] + " and " + path);
+        shard_files[shard.index] = path;
+
+        // Each shard was written to a different file
+        in.comment = replace_outfile(in.comment, out_filepath);
+
+        if(in.comment != in0.comment)
+            throw std::runtime_error("Header of " + path + " is different from " + in0.filepath);
+        if(!same_shells(in.shells, in0.shells))
+            throw std::runtime_error("Basis of " + path + " is different from " + in0.filepath);
+
+        std::array<size_t, 4> idx;
+        if(inputs.back()->first_quartet(idx))
+            order.emplace_back(quartet_order(idx), inputs.size()-1);
+    }
+
+    for(size_t i = 0; i < shard_files.size(); i++)
+    {
+        if(shard_files[i].empty())
+            throw std::runtime_error("Shard " + std::to_string(i) + "/" + std::to_string(shard_files.size()) +
+                                     " is missing");
+    }
+
+    std::sort(order.begin(), order.end());
+
+    reffile_output out(out_filepath, format, inputs.front()->comment, inputs.front()->shells);
+
+    // Quartets must be in order across all files, which also
+    // ensures that no quartet is in more than one file
+    size_t nquartet = 0;
+    std::array<size_t, 4> prev;
+
+    for(const auto & it : order)
+    {
+        reffile_input & in = *inputs[it.second];
+
+        in.read_quartets([&](const std::array<size_t, 4> & idx, const double * integrals, size_t nintegrals)
+        {
+            const std::array<size_t, 4> key = quartet_order(idx);
+            if(nquartet > 0 && !(prev < key))
+            {
+                std::stringstream ss;
+                ss << "Quartet " << idx[0] << " " << idx[1] << " " << idx[2] << " " << idx[3]
+                   << " of " << in.filepath << " is out of order or in more than one file";
+                throw std::runtime_error(ss.str());
+            }
+
+            out.write(idx, integrals, nintegrals);
+            prev = key;
+            nquartet++;
+        });
+    }
+
+    if(nquartet != nquartet_total)
+    {
+        std::stringstream ss;
+        ss << "Files have " << nquartet << " quartets, but the shards should have " << nquartet_total;
+        throw std::runtime_error(ss.str());
+    }
+
+    out.finish();
+    return nquartet;
+}
+
+} // close namespace mirp
@@ -0,0 +1,394 @@
+/*! \file
+ *
+ * \brief Reading/writing reference data files in binary format
+ *
+ * The binary format holds the same information as the text format, but stores
+ * all values as raw little-endian doubles, with a fixed-size index of the quartets.
+ * It is meant to be memory mapped, so that quartets can be accessed directly
+ * without parsing the file.
+ *
+ * Layout (all integers are unsigned and little-endian, all sections are
+ * aligned to 8 bytes):
+ *
+ * Offset | Size | Contents
+ * -------|------|---------------------------------------------------------
+ *      0 |    8 | Magic string "MIRPREFB"
+ *      8 |    4 | Format version (\ref reffile_binary_version)
+ *     12 |    4 | Number of centers of the integral (4)
+ *     16 |   96 | Offsets (in bytes) and counts of the sections, as 64-bit pairs:
+ *        |      | comment, shells, shell parameters, integrals, quartet index, and block index
+ *    112 |    4 | Encoding of the integrals (\ref reffile_encoding)
+ *    116 |   12 | Reserved (zero)
+ *
+ * - The comment section holds the comment lines at the top of the text file (verbatim).
+ * - Each shell is 48 bytes: AM, number of primitives, number of general contractions,
+ *   and a reserved field (32-bit each), the coordinates (3 doubles), and the index of
+ *   its first parameter (64-bit). The parameters of a shell are its exponents followed
+ *   by its coefficients (as in gaussian_shell).
+ * - The integral section holds the blocks of integrals. Its count is its size in bytes.
+ * - Each quartet in the index is 32 bytes: the four shell indices (32-bit each), their
+ *   AM (8-bit each), the number of integrals (32-bit), and the index of the first
+ *   integral (64-bit, counting the integrals of all previous quartets).
+ * - The integrals of consecutive quartets are grouped into blocks, each of which
+ *   is encoded separately. Each block in the index is 32 bytes: the offset of the block
+ *   within the integral section and its size (in bytes), the index of its first quartet
+ *   (64-bit each), and the number of quartets and integrals in the block (32-bit each).
+ *
+ * Since blocks are independent, they can be decoded in parallel and in any order.
+ */
+
+#pragma once
+
+#include "mirp_bin/data_entry.hpp"
+#include "mirp_bin/binary_io.hpp"
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/shard.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mirp {
+
+/*! \brief Current version of the binary reference format */
+static const uint32_t reffile_binary_version = 2;
+
+/*! \brief Minimum number of integrals in a block (except the last) */
+static const size_t reffile_block_nintegrals = 4096;
+
+
+/*! \brief Encoding of the integrals in a binary reference file */
+enum reffile_encoding
+{
+    reffile_encoding_raw = 0,       /*!< Raw doubles (8 bytes each) */
+    reffile_encoding_compressed = 1 /*!< Compressed with float_block_encode */
+};
+
+
+/*! \brief Format of a reference file */
+enum reffile_format
+{
+    reffile_format_text,      /*!< Text (hexadecimal doubles) */
+    reffile_format_binary,    /*!< Binary, with raw integrals */
+    reffile_format_compressed /*!< Binary, with compressed integrals */
+};
+
+
+/*! \brief Parses the name of a reference file format
+ *
+ * \throw std::runtime_error if the name is not "text", "binary", or "compressed"
+ */
+reffile_format reffile_format_from_string(const std::string & name);
+
+
+/*! \brief A quartet in the index of a binary reference file */
+struct reffile_quartet
+{
+    std::array<size_t, 4> idx;  //!< Indices of the shells
+    std::array<int, 4> am;      //!< Angular momentum of the shells
+    size_t nintegrals;          //!< Number of integrals in the quartet
+    uint64_t start;             //!< Index of the first integral of the quartet
+};
+
+
+/*! \brief A block of integrals in a binary reference file */
+struct reffile_block
+{
+    size_t first_quartet;       //!< Index of the first quartet of the block
+    size_t nquartet;            //!< Number of quartets in the block
+    uint64_t start;             //!< Index of the first integral of the block
+    size_t nintegrals;          //!< Number of integrals in the block
+};
+
+
+/*! \brief Determines if a file is a binary reference file
+ *
+ * \param [in] filepath Path to the file to check
+ * \return True if the file starts with the magic string of the binary format
+ */
+bool reffile_is_binary(const std::string & filepath);
+
+
+/*! \brief A binary reference file, opened for reading
+ *
+ * The file is memory mapped where supported (and read into memory otherwise).
+ * The comment, the basis, and the block index are read when the file is opened.
+ * Quartets and blocks are read from the mapping on demand, and the object may
+ * be used by multiple threads at once.
+ */
+class reffile_binary
+{
+public:
+    /*! \brief Opens and validates a binary reference file
+     *
+     * \throw std::runtime_error if the file cannot be opened, or if it
+     *        is not a valid binary reference file
+     *
+     * \param [in] filepath Path to the file
+     */
+    explicit reffile_binary(const std::string & filepath);
+
+
+    /*! \brief Comment lines at the top of the file */
+    const std::string & comment(void) const { return comment_; }
+
+    /*! \brief Shells of the basis */
+    const std::vector<gaussian_shell> & shells(void) const { return shells_; }
+
+    /*! \brief Encoding of the integrals */
+    reffile_encoding encoding(void) const { return encoding_; }
+
+    /*! \brief Number of quartets in the file */
+    size_t nquartet(void) const { return nquartet_; }
+
+    /*! \brief Number of blocks in the file */
+    size_t nblock(void) const { return blocks_.size(); }
+
+
+    /*! \brief Obtain a quartet from the index
+     *
+     * \param [in] i Index of the quartet (in the order of the file)
+     */
+    reffile_quartet quartet(size_t i) const;
+
+
+    /*! \brief Obtain a block from the block index
+     *
+     * \param [in] b Index of the block
+     */
+    const reffile_block & block(size_t b) const;
+
+
+    /*! \brief Finds the block containing a quartet
+     *
+     * \param [in] i Index of the quartet
+     * \return Index of the block
+     */
+    size_t find_block(size_t i) const;
+
+
+    /*! \brief Decodes all integrals of a block
+     *
+     * \throw std::runtime_error if the block cannot be decoded
+     *
+     * \param [in]  b         Index of the block
+     * \param [out] integrals Output for the integrals (\p block(b).nintegrals values)
+     */
+    void read_block(size_t b, double * integrals) const;
+
+
+    /*! \brief Copies the integrals of a quartet
+     *
+     * For compressed files, this decodes the entire block containing the
+     * quartet. When reading many quartets, decode the blocks with
+     * \ref read_block instead.
+     *
+     * \param [in]  q         A quartet obtained from \ref quartet
+     * \param [out] integrals Output for the integrals (\p q.nintegrals values)
+     */
+    void read_integrals(const reffile_quartet & q, double * integrals) const;
+
+
+private:
+    mapped_file file_;                    /*!< The mapped file */
+    const unsigned char * data_;          /*!< Contents of the file */
+    size_t size_;                         /*!< Size of the file in bytes */
+
+    std::string comment_;                 /*!< Comment lines */
+    std::vector<gaussian_shell> shells_;  /*!< Shells of the basis */
+    reffile_encoding encoding_;           /*!< Encoding of the integrals */
+    uint64_t integral_offset_;            /*!< Offset of the integral section */
+    uint64_t nintegral_;                  /*!< Total number of integrals */
+    uint64_t index_offset_;               /*!< Offset of the quartet index */
+    size_t nquartet_;                     /*!< Number of quartets */
+    std::vector<reffile_block> blocks_;   /*!< The block index */
+    std::vector<std::pair<uint64_t, uint64_t>> block_data_; /*!< Offset and size of each block */
+
+    void load(const std::string & err);
+};
+
+
+/*! \brief Writes a binary reference file
+ *
+ * The comment and basis are written when the file is created. Integrals
+ * are collected into blocks, which are encoded and written as they are filled.
+ * The indices are kept in memory (32 bytes per quartet and per block) and
+ * written by \ref finish.
+ */
+class reffile_binary_writer
+{
+public:
+    /*! \brief Creates a file and writes the comment and the basis
+     *
+     * Any existing file will be overwritten.
+     *
+     * \throw std::runtime_error if there is a problem opening or writing the file
+     *
+     * \param [in] filepath Path to the file
+     * \param [in] comment  Comment lines to store
+     * \param [in] shells   Shells of the basis
+     * \param [in] encoding Encoding of the integrals
+     */
+    reffile_binary_writer(const std::string & filepath,
+                          const std::string & comment,
+                          const std::vector<gaussian_shell> & shells,
+                          reffile_encoding encoding = reffile_encoding_raw);
+
+
+    /*! \brief Continues writing a partially written file from a checkpoint
+     *
+     * The file must have been truncated to the size in the checkpoint (see
+     * \ref checkpoint_resume), and must have been created with the same comment,
+     * shells, and encoding. The quartets written before the checkpoint must then
+     * be given to \ref restore_quartet, in order, before writing more quartets.
+     *
+     * \throw std::runtime_error if there is a problem opening the file, or
+     *        if it does not match the arguments or the checkpoint
+     *
+     * \param [in] filepath Path to the file
+     * \param [in] comment  Comment lines stored in the file
+     * \param [in] shells   Shells of the basis
+     * \param [in] encoding Encoding of the integrals
+     * \param [in] ckpt     Checkpoint to continue from (see \ref get_checkpoint)
+     */
+    reffile_binary_writer(const std::string & filepath,
+                          const std::string & comment,
+                          const std::vector<gaussian_shell> & shells,
+                          reffile_encoding encoding,
+                          const checkpoint & ckpt);
+
+
+    /*! \brief Restores a quartet that was written before the checkpoint
+     *
+     * \throw std::runtime_error if a shell index is out of range, or
+     *        the quartets do not match the checkpoint
+     *
+     * \param [in] idx        Indices of the shells
+     * \param [in] nintegrals Number of integrals in the quartet
+     */
+    void restore_quartet(const std::array<size_t, 4> & idx, size_t nintegrals);
+
+
+    /*! \brief Writes the integrals of a quartet
+     *
+     * \throw std::runtime_error if a shell index is out of range, or
+     *        there is a problem writing the file
+     *
+     * \param [in] idx        Indices of the shells
+     * \param [in] integrals  The integrals of the quartet
+     * \param [in] nintegrals Number of integrals in the quartet
+     */
+    void write_quartet(const std::array<size_t, 4> & idx,
+                       const double * integrals, size_t nintegrals);
+
+
+    /*! \brief Writes the quartet index and completes the file
+     *
+     * \throw std::runtime_error if there is a problem writing the file
+     */
+    void finish(void);
+
+
+    /*! \brief Number of quartets written so far */
+    size_t nquartet(void) const { return static_cast<size_t>(nquartet_); }
+
+
+    /*! \brief Obtains a checkpoint from which writing can be continued
+     *
+     * Integrals are written in blocks, so the checkpoint is taken after the
+     * last block that was written. The quartets of the current block are not
+     * included, and need to be written again when continuing.
+     *
+     * \param [out] ckpt Number of quartets, size of the file, and sizes of the
+     *                   blocks (the fingerprint is not changed)
+     */
+    void get_checkpoint(checkpoint & ckpt);
+
+
+private:
+    std::ofstream fs_;                    /*!< The file being written */
+    reffile_encoding encoding_;           /*!< Encoding of the integrals */
+    std::vector<int> am_;                 /*!< AM of each shell */
+    std::vector<unsigned char> header_;   /*!< Header (completed by finish) */
+    std::vector<unsigned char> index_;    /*!< Encoded quartet index */
+    std::vector<unsigned char> block_index_; /*!< Encoded block index */
+    std::vector<double> block_;           /*!< Integrals of the current block */
+    std::vector<unsigned char> buf_;      /*!< Buffer for encoding a block */
+    uint64_t integral_offset_;            /*!< Offset of the integral section */
+    uint64_t integral_size_;              /*!< Size of the blocks written so far (bytes) */
+    uint64_t nintegral_;                  /*!< Number of integrals given */
+    uint64_t nquartet_;                   /*!< Number of quartets given */
+    uint64_t block_first_;                /*!< First quartet of the current block */
+    uint64_t block_nintegral_;            /*!< Number of integrals in the current block */
+    std::vector<uint64_t> block_sizes_;   /*!< Size of each block written so far (bytes) */
+    uint64_t restore_nquartet_;           /*!< Number of quartets to restore from a checkpoint */
+    std::vector<uint64_t> restore_sizes_; /*!< Size of each block in the checkpoint (bytes) */
+
+    std::vector<unsigned char> build_prefix(const std::string & comment,
+                                            const std::vector<gaussian_shell> & shells);
+    void append_quartet(const std::array<size_t, 4> & idx, size_t nintegrals);
+    void close_block(uint64_t size);
+    void write_block(void);
+};
+
+
+/*! \brief Converts a reference file to another format
+ *
+ * The input may be a text or binary file (of any encoding). For files written
+ * by mirp_create_reference, converting to binary and back to text results in
+ * an identical file.
+ *
+ * \throw std::runtime_error if there is a problem reading or writing the files
+ *
+ * \param [in] in_filepath  Path to the reference file to convert
+ * \param [in] out_filepath Path to the file to write
+ * \param [in] format       Format of the output file
+ * \return Number of quartets converted
+ */
+size_t reffile_convert(const std::string & in_filepath,
+                       const std::string & out_filepath,
+                       reffile_format format);
+
+
+/*! \brief Comment line recording the shard a reference file was created with
+ *
+ * The line is added to the header of the file of each shard, and records the
+ * shard and the number of quartets of the file without shards. It is used by
+ * \ref reffile_merge to check that all the shards are present.
+ *
+ * \param [in] shard    The shard of the file
+ * \param [in] nquartet Total number of quartets of all the shards
+ * \return The comment line (including the newline)
+ */
+std::string reffile_shard_comment(const shard_spec & shard, size_t nquartet);
+
+
+/*! \brief Combines the files of the shards of a reference file
+ *
+ * The files are written by mirp_create_reference with different shards (see
+ * shard.hpp), and may be given in any order and in any format. They must have
+ * the same header and basis, except for the output file in the command line
+ * recorded in the header, which is replaced by \p out_filepath, and the line
+ * recording the shard (see \ref reffile_shard_comment), which is removed. The quartets
+ * are written in the order used by mirp_create_reference, so merging the files
+ * of all the shards results in the same file as creating it without shards.
+ *
+ * \throw std::runtime_error if there is a problem reading or writing the files,
+ *        if a file does not record its shard, if the headers or bases of the files
+ *        are different, if any shard is missing or given more than once, if any
+ *        quartet is out of order or is in more than one file, or if the number of
+ *        quartets is different from the number recorded in the files
+ *
+ * \param [in] in_filepaths Paths to the files of the shards
+ * \param [in] out_filepath Path to the file to write
+ * \param [in] format       Format of the output file
+ * \return Number of quartets written
+ */
+size_t reffile_merge(const std::vector<std::string> & in_filepaths,
+                     const std::string & out_filepath,
+                     reffile_format format);
+
+} // close namespace mirp
@@ -0,0 +1,229 @@
+/*! \file
+ *
+ * \brief Random access to the quartets of reference files
+ */
+
+#include "mirp_bin/reffile_index.hpp"
+#include "mirp_bin/reffile_io.hpp"
+#include "mirp_bin/shard.hpp"
+#include "mirp_bin/test_common.hpp"
+
+#include <mirp/shell.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace mirp {
+
+reffile_index::reffile_index(const std::string & filepath)
+    : filepath_(filepath)
+{
+    if(reffile_is_binary(filepath))
+    {
+        binfile_.reset(new reffile_binary(filepath));
+        shells_ = binfile_->shells();
+    }
+    else
+    {
+        std::ifstream fs(filepath);
+        if(!fs.is_open())
+            throw std::runtime_error("Error opening input file");
+
+        file_skip(fs, '#');
+        shells_ = reffile_read_basis(fs);
+
+        // Record the position of each line, and its shell indices. The
+        // integrals are only counted, and are read later if needed
+        uint64_t offset = static_cast<uint64_t>(fs.tellg());
+        uint64_t nintegral = 0;
+        std::string line;
+
+        while(std::getline(fs, line))
+        {
+            const uint64_t line_offset = offset;
+            offset += line.size() + 1;
+
+            const size_t start = line.find_first_not_of(" \t\r");
+            if(start == std::string::npos || line[start] == '#')
+                continue;
+
+            reffile_quartet q;
+            const char * p = line.c_str();
+            char * end = nullptr;
+
+            q.nintegrals = 1;
+            for(int n = 0; n < 4; n++)
+            {
+                q.idx[n] = static_cast<size_t>(std::strtoul(p, &end, 10));
+                if(end == p)
+                    throw std::runtime_error("Error reading shell indices from reference file");
+                if(q.idx[n] >= shells_.size())
+                    throw std::runtime_error("Shell index out of range in reference file");
+
+                const auto & s = shells_[q.idx[n]];
+                q.am[n] = s.am;
+                q.nintegrals *= static_cast<size_t>(MIRP_NCART(s.am) * s.ngeneral);
+                p = end;
+            }
+
+            q.start = nintegral;
+            nintegral += q.nintegrals;
+
+            quartets_.push_back(q);
+            offsets_.push_back(line_offset);
+        }
+    }
+
+    sorted_.resize(nquartet());
+    for(size_t i = 0; i < sorted_.size(); i++)
+        sorted_[i] = i;
+
+    std::vector<std::array<size_t, 4>> idx(nquartet());
+    for(size_t i = 0; i < idx.size(); i++)
+        idx[i] = shell_indices(i);
+
+    std::stable_sort(sorted_.begin(), sorted_.end(),
+                     [&idx](size_t a, size_t b) { return idx[a] < idx[b]; });
+}
+
+
+size_t reffile_index::nquartet(void) const
+{
+    return binfile_ ? binfile_->nquartet() : quartets_.size();
+}
+
+
+reffile_quartet reffile_index::quartet(size_t i) const
+{
+    if(binfile_)
+        return binfile_->quartet(i);
+
+    if(i >= quartets_.size())
+        throw std::out_of_range("Quartet index out of range in reference file");
+    return quartets_[i];
+}
+
+
+std::array<size_t, 4> reffile_index::shell_indices(size_t i) const
+{
+    return binfile_ ? binfile_->quartet(i).idx : quartets_[i].idx;
+}
+
+
+size_t reffile_index::find(const std::array<size_t, 4> & idx) const
+{
+    auto it = std::lower_bound(sorted_.begin(), sorted_.end(), idx,
+                               [this](size_t i, const std::array<size_t, 4> & v) { return shell_indices(i) < v; });
+
+    if(it == sorted_.end() || shell_indices(*it) != idx)
+        return nquartet();
+    return *it;
+}
+
+
+std::vector<size_t> reffile_index::select(const reffile_selection & sel) const
+{
+    size_t first = sel.first;
+    size_t last = std::min(sel.last, nquartet());
+
+    // The quartets of a shard are a range of the file
+    if(!sel.shard.all())
+    {
+        std::vector<double> costs(nquartet());
+        for(size_t i = 0; i < costs.size(); i++)
+        {
+            costs[i] = 1.0;
+            for(size_t n : shell_indices(i))
+                costs[i] *= shard_shell_cost(shells_[n].am, shells_[n].nprim);
+        }
+
+        const std::pair<size_t, size_t> range = shard_range(costs, sel.shard);
+        first = std::max(first, range.first);
+        last = std::min(last, range.second);
+    }
+
+    // Quartets given by their shell indices
+    std::set<size_t> requested;
+    for(const auto & idx : sel.quartets)
+    {
+        const size_t i = find(idx);
+        if(i == nquartet())
+        {
+            std::stringstream ss;
+            ss << "Quartet " << idx[0] << " " << idx[1] << " " << idx[2] << " " << idx[3]
+               << " is not in the reference file";
+            throw std::runtime_error(ss.str());
+        }
+        requested.insert(i);
+    }
+
+    std::vector<size_t> selected;
+
+    for(size_t i = first; i < last; i++)
+    {
+        if(!sel.quartets.empty() && requested.count(i) == 0)
+            continue;
+
+        if(!sel.amlist.empty())
+        {
+            const reffile_quartet q = quartet(i);
+            const std::vector<int> am(q.am.begin(), q.am.end());
+            if(std::find(sel.amlist.begin(), sel.amlist.end(), am) == sel.amlist.end())
+                continue;
+        }
+
+        selected.push_back(i);
+    }
+
+    return selected;
+}
+
+
+void reffile_index::read_integrals(size_t i, reffile_cursor & cursor, double * integrals) const
+{
+    const reffile_quartet q = quartet(i);
+
+    if(binfile_)
+    {
+        // Blocks are decoded as a whole, and kept for the following quartets
+        const size_t b = binfile_->find_block(i);
+        const reffile_block & blk = binfile_->block(b);
+
+        if(cursor.block_ != b)
+        {
+            cursor.block_integrals_.resize(blk.nintegrals);
+            binfile_->read_block(b, cursor.block_integrals_.data());
+            cursor.block_ = b;
+        }
+
+        const auto first = cursor.block_integrals_.begin() + static_cast<std::ptrdiff_t>(q.start - blk.start);
+        std::copy(first, first + static_cast<std::ptrdiff_t>(q.nintegrals), integrals);
+        return;
+    }
+
+    std::ifstream & fs = cursor.fs_;
+    if(!fs.is_open())
+    {
+        fs.open(filepath_);
+        if(!fs.is_open())
+            throw std::runtime_error("Error opening input file");
+    }
+
+    fs.clear();
+    fs.seekg(static_cast<std::streamoff>(offsets_[i]));
+
+    std::array<size_t, 4> idx;
+    for(auto & it : idx)
+        fs >> it;
+
+    if(!fs.good() || idx != q.idx)
+        throw std::runtime_error("Error reading shell indices from reference file (has the file changed?)");
+
+    for(size_t n = 0; n < q.nintegrals; n++)
+        integrals[n] = read_hexdouble(fs);
+}
+
+} // close namespace mirp
@@ -0,0 +1,140 @@
+/*! \file
+ *
+ * \brief Random access to the quartets of reference files
+ */
+
+#pragma once
+
+#include "mirp_bin/reffile_binary.hpp"
+#include "mirp_bin/shard.hpp"
+
+#include <array>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mirp {
+
+
+/*! \brief A selection of quartets of a reference file
+ *
+ * A quartet is selected if it matches all of the criteria
+ * that are given (that is, are not empty).
+ */
+struct reffile_selection
+{
+    std::vector<std::vector<int>> amlist;           //!< AM classes to select
+    std::vector<std::array<size_t, 4>> quartets;    //!< Shell indices of the quartets to select
+    size_t first = 0;                               //!< First quartet (in the order of the file)
+    size_t last = static_cast<size_t>(-1);          //!< One past the last quartet (in the order of the file)
+    shard_spec shard;                               //!< Shard of the quartets of the file (see shard.hpp)
+
+    /*! \brief Whether all quartets are selected */
+    bool all(void) const
+    {
+        return amlist.empty() && quartets.empty() && first == 0 && last == static_cast<size_t>(-1) &&
+               shard.all();
+    }
+};
+
+
+/*! \brief Per-thread state for reading from a \ref reffile_index
+ *
+ * This holds the open file (for text files), or the last decoded block
+ * (for binary files), so that reading nearby quartets is fast.
+ */
+class reffile_cursor
+{
+public:
+    reffile_cursor(void) : block_(static_cast<size_t>(-1)) { }
+
+private:
+    friend class reffile_index;
+
+    std::ifstream fs_;                     /*!< The text file */
+    size_t block_;                         /*!< Index of the block in block_integrals_ */
+    std::vector<double> block_integrals_;  /*!< The last block decoded */
+};
+
+
+/*! \brief An index of the quartets of a reference file
+ *
+ * For binary files, the index stored in the file is used. Text files are
+ * scanned once, recording the shell indices and the position of each line.
+ * After that, any quartet can be read without scanning the file again.
+ *
+ * The index may be used by multiple threads at once, as long as each thread
+ * reads through its own \ref reffile_cursor.
+ */
+class reffile_index
+{
+public:
+    /*! \brief Opens a reference file and builds its index
+     *
+     * \throw std::runtime_error if the file cannot be opened, or if
+     *        there is a problem reading it
+     *
+     * \param [in] filepath Path to the reference file (text or binary)
+     */
+    explicit reffile_index(const std::string & filepath);
+
+
+    /*! \brief Whether the file is a binary file */
+    bool is_binary(void) const { return static_cast<bool>(binfile_); }
+
+    /*! \brief Shells of the basis */
+    const std::vector<gaussian_shell> & shells(void) const { return shells_; }
+
+    /*! \brief Number of quartets in the file */
+    size_t nquartet(void) const;
+
+
+    /*! \brief Obtain a quartet from the index
+     *
+     * \param [in] i Index of the quartet (in the order of the file)
+     */
+    reffile_quartet quartet(size_t i) const;
+
+
+    /*! \brief Finds a quartet by the indices of its shells
+     *
+     * \param [in] idx Indices of the shells
+     * \return Index of the quartet, or \ref nquartet if the file does not contain it
+     */
+    size_t find(const std::array<size_t, 4> & idx) const;
+
+
+    /*! \brief Finds the quartets matching a selection
+     *
+     * \throw std::runtime_error if a quartet given in the selection is not in the file
+     *
+     * \param [in] sel The quartets to select
+     * \return Indices of the selected quartets, in the order of the file
+     */
+    std::vector<size_t> select(const reffile_selection & sel) const;
+
+
+    /*! \brief Reads the integrals of a quartet
+     *
+     * \throw std::runtime_error if there is a problem reading the file
+     *
+     * \param [in]    i         Index of the quartet
+     * \param [inout] cursor    State for reading (one per thread)
+     * \param [out]   integrals Output for the integrals (\p quartet(i).nintegrals values)
+     */
+    void read_integrals(size_t i, reffile_cursor & cursor, double * integrals) const;
+
+
+private:
+    std::string filepath_;                   /*!< Path to the file */
+    std::unique_ptr<reffile_binary> binfile_;  /*!< The binary file (if the file is binary) */
+    std::vector<gaussian_shell> shells_;     /*!< Shells of the basis */
+    std::vector<reffile_quartet> quartets_;  /*!< Quartets of a text file */
+    std::vector<uint64_t> offsets_;          /*!< Position of the line of each quartet of a text file */
+    std::vector<size_t> sorted_;             /*!< Quartets, sorted by their shell indices */
+
+    std::array<size_t, 4> shell_indices(size_t i) const;
+};
+
+} // close namespace mirp
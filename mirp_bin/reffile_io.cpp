@@ -71,6 +71,21 @@ void reffile_write_basis(const std::vector<gaussian_shell> & shells, std::ostrea
 }
 
 
+std::string reffile_read_comment(std::istream & fs)
+{
+    std::string comment;
+
+    while(fs.peek() == '#' || fs.peek() == '\n')
+    {
+        std::string line;
+        std::getline(fs, line);
+        comment += line + "\n";
+    }
+
+    return comment;
+}
+
+
 std::vector<gaussian_shell> reffile_read_basis(std::istream & fs)
 {
     size_t nshell;
@@ -39,6 +39,17 @@ void write_hexdouble(double d, std::ostream & fs);
 void reffile_write_basis(const std::vector<gaussian_shell> & shells, std::ostream & fs);
 
 
+/*! \brief Reads the comment lines at the top of a reference file
+ *
+ * Lines starting with '#', as well as blank lines, are read until
+ * the first line of data.
+ *
+ * \param [in] fs The file stream to read from
+ * \return The lines that were read (including newlines)
+ */
+std::string reffile_read_comment(std::istream & fs);
+
+
 /*! \brief Reads basis information from a reference file
  *
  * \param [in] fs The file stream to read from
@@ -0,0 +1,189 @@
+/*! \file
+ *
+ * \brief Helpers for reading and writing data of parallel tasks in task order
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace mirp {
+
+
+/*! \brief Holds the results of tasks that finished out of order until they can be written
+ *
+ * The buffer has a fixed number of slots (the window). The result of task \p i
+ * is stored in slot `i % window`, and a task is not started until the result
+ * previously held in its slot has been written. Therefore, at most \p window
+ * results are held in memory at any time, regardless of the number of tasks.
+ *
+ * Results are passed to the write function strictly in task order and never
+ * concurrently. This assumes tasks are started in (roughly) increasing order,
+ * as is done by \ref mirp_scheduler_run.
+ *
+ * \tparam T Type holding the result of a single task
+ */
+template<typename T>
+class reorder_buffer
+{
+public:
+    typedef std::function<void(long, T &)> write_type;
+
+
+    /*! \brief Creates a buffer
+     *
+     * \param [in] window     Maximum number of results held at any time (at least 1)
+     * \param [in] write_func Function that writes the result of a task
+     */
+    reorder_buffer(long window, const write_type & write_func)
+        : window_(window > 0 ? window : 1),
+          slots_(static_cast<size_t>(window_)),
+          ready_(static_cast<size_t>(window_), false),
+          write_func_(write_func),
+          next_(0),
+          aborted_(false)
+    { }
+
+
+    /*! \brief Runs a task, storing its result in the buffer
+     *
+     * Blocks until a slot is available for task \p i, then calls \p func
+     * with the slot (outside of any lock). Afterwards, all results that
+     * are next in order are written.
+     *
+     * If \p func or the write function throws, the buffer is aborted (see
+     * \ref abort) and the exception is rethrown. Tasks that are waiting for a
+     * slot, or that are run after that, return without doing anything.
+     *
+     * \param [in] i    Index of the task
+     * \param [in] func Function that computes the result of the task and stores it
+     *                  in the given object. The object may contain the result of an
+     *                  earlier task, which has already been written.
+     */
+    template<typename Func>
+    void run(long i, Func func)
+    {
+        const size_t slot = static_cast<size_t>(i % window_);
+
+        {
+            std::unique_lock<std::mutex> l(mtx_);
+            cv_.wait(l, [&]{ return aborted_ || i < next_ + window_; });
+            if(aborted_)
+                return;
+        }
+
+        try {
+            func(slots_[slot]);
+
+            std::lock_guard<std::mutex> l(mtx_);
+            ready_[slot] = true;
+
+            // Whoever finishes the next task in order writes everything
+            // that is ready from there
+            bool written = false;
+            while(!aborted_ && ready_[static_cast<size_t>(next_ % window_)])
+            {
+                const size_t s = static_cast<size_t>(next_ % window_);
+                write_func_(next_, slots_[s]);
+                ready_[s] = false;
+                next_++;
+                written = true;
+            }
+
+            if(written)
+                cv_.notify_all();
+        }
+        catch(...)
+        {
+            abort();
+            throw;
+        }
+    }
+
+
+    /*! \brief Stops all further tasks and wakes up those waiting for a slot */
+    void abort(void)
+    {
+        std::lock_guard<std::mutex> l(mtx_);
+        aborted_ = true;
+        cv_.notify_all();
+    }
+
+
+private:
+    const long window_;         /*!< Number of slots */
+    std::vector<T> slots_;      /*!< Storage for the results */
+    std::vector<bool> ready_;   /*!< Whether a slot holds a result that has not been written */
+    write_type write_func_;     /*!< Function that writes a result */
+    long next_;                 /*!< Index of the next task to be written */
+    bool aborted_;              /*!< Set if a task or a write has failed */
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
+
+
+/*! \brief Runs a section of each task strictly in task order
+ *
+ * This can be used for work that must be done sequentially, such as reading
+ * the input for each task from a file, while the rest of the tasks run in parallel.
+ * As with \ref reorder_buffer, tasks must be started in (roughly) increasing order.
+ */
+class task_sequencer
+{
+public:
+    task_sequencer(void) : next_(0), aborted_(false) { }
+
+
+    /*! \brief Runs the ordered section of a task
+     *
+     * Blocks until the sections of all previous tasks have been run. If
+     * \p func throws, the sequencer is aborted and the exception is rethrown.
+     *
+     * \param [in] i    Index of the task
+     * \param [in] func Function that runs the section
+     * \return False if the sequencer was aborted (and \p func was not called)
+     */
+    template<typename Func>
+    bool run(long i, Func func)
+    {
+        std::unique_lock<std::mutex> l(mtx_);
+        cv_.wait(l, [&]{ return aborted_ || i == next_; });
+        if(aborted_)
+            return false;
+
+        try {
+            func();
+        }
+        catch(...)
+        {
+            aborted_ = true;
+            cv_.notify_all();
+            throw;
+        }
+
+        next_++;
+        cv_.notify_all();
+        return true;
+    }
+
+
+    /*! \brief Stops all further tasks and wakes up those waiting for their turn */
+    void abort(void)
+    {
+        std::lock_guard<std::mutex> l(mtx_);
+        aborted_ = true;
+        cv_.notify_all();
+    }
+
+
+private:
+    long next_;      /*!< Index of the next task to run the section */
+    bool aborted_;   /*!< Set if a section has failed */
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
+
+} // close namespace mirp
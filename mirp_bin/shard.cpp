@@ -0,0 +1,83 @@
+/*! \file
+ *
+ * \brief Splitting the work of a program into shards
+ */
+
+#include "mirp_bin/shard.hpp"
+
+#include <mirp/shell.h>
+
+#include <stdexcept>
+
+namespace mirp {
+
+shard_spec shard_from_string(const std::string & s)
+{
+    const size_t slash = s.find('/');
+    if(slash == std::string::npos)
+        throw std::runtime_error("A shard must be given as i/N");
+
+    const std::string is = s.substr(0, slash);
+    const std::string ns = s.substr(slash+1);
+
+    if(is.empty() || ns.empty() ||
+       is.find_first_not_of("0123456789") != std::string::npos ||
+       ns.find_first_not_of("0123456789") != std::string::npos)
+        throw std::runtime_error("A shard must be given as i/N: " + s);
+
+    shard_spec shard;
+    shard.index = std::stoul(is);
+    shard.count = std::stoul(ns);
+
+    if(shard.count == 0)
+        throw std::runtime_error("Number of shards must be positive");
+    if(shard.index >= shard.count)
+        throw std::runtime_error("Shard index must be less than the number of shards (shards start at 0)");
+
+    return shard;
+}
+
+
+double shard_shell_cost(int am, int nprim)
+{
+    return static_cast<double>(MIRP_NCART(am)) * static_cast<double>(nprim);
+}
+
+
+std::pair<size_t, size_t> shard_range(const std::vector<double> & costs, const shard_spec & shard)
+{
+    if(shard.all())
+        return {0, costs.size()};
+
+    double total = 0.0;
+    for(double c : costs)
+        total += c;
+
+    // Shard containing the midpoint of each task. This does not decrease
+    // along the file, so each shard is a contiguous range
+    size_t first = costs.size();
+    size_t last = costs.size();
+    double sum = 0.0;
+
+    for(size_t i = 0; i < costs.size(); i++)
+    {
+        const double mid = sum + 0.5*costs[i];
+        sum += costs[i];
+
+        size_t s = static_cast<size_t>(static_cast<double>(shard.count) * mid / total);
+        if(s >= shard.count)
+            s = shard.count - 1;
+
+        if(s >= shard.index && first == costs.size())
+            first = i;
+        if(s > shard.index)
+        {
+            last = i;
+            break;
+        }
+    }
+
+    return {first, last};
+}
+
+} // close namespace mirp
@@ -0,0 +1,69 @@
+/*! \file
+ *
+ * \brief Splitting the work of a program into shards
+ *
+ * A shard is one of \p N parts of the quartets or entries of a file, which
+ * may be computed by separate processes (for example, on different nodes of
+ * a cluster). The tasks are split into contiguous ranges, in the order they
+ * appear in the file, so that each shard has about the same estimated cost.
+ * The split only depends on the tasks, so every process determines the same
+ * ranges without communicating.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mirp {
+
+
+/*! \brief Which shard of the work to do */
+struct shard_spec
+{
+    size_t index;  //!< Index of the shard (starting at 0)
+    size_t count;  //!< Total number of shards
+
+    shard_spec(void) : index(0), count(1) { }
+
+    /*! \brief Whether this shard is all of the work */
+    bool all(void) const { return count == 1; }
+};
+
+
+/*! \brief Parses a shard given as "i/N"
+ *
+ * \throw std::runtime_error if the string is not valid, or if
+ *        \p i is not less than \p N
+ *
+ * \param [in] s The string to parse (for example, "2/8")
+ * \return The shard described by the string
+ */
+shard_spec shard_from_string(const std::string & s);
+
+
+/*! \brief Estimated cost of a shell, relative to an s shell with one primitive
+ *
+ * The estimated cost of a quartet or entry is the product
+ * of the costs of its shells.
+ *
+ * \param [in] am    Angular momentum of the shell
+ * \param [in] nprim Number of primitives of the shell
+ */
+double shard_shell_cost(int am, int nprim);
+
+
+/*! \brief Determines the tasks belonging to a shard
+ *
+ * A task belongs to the shard containing the midpoint of its cost,
+ * when the total cost is split into \p shard.count equal parts.
+ *
+ * \param [in] costs Estimated cost of each task, in the order of the file
+ * \param [in] shard The shard to find the tasks of
+ * \return The first task of the shard, and one past its last task
+ */
+std::pair<size_t, size_t> shard_range(const std::vector<double> & costs, const shard_spec & shard);
+
+} // close namespace mirp
@@ -86,6 +86,22 @@ int amchar_to_int(char am)
 }
 
 
+std::vector<std::vector<int>> amlist_from_string(const std::string & amlist)
+{
+    std::vector<std::vector<int>> ret;
+
+    for(const auto & s : split(amlist, ','))
+    {
+        std::vector<int> am_ntet;
+        for(char c : s)
+            am_ntet.push_back(amchar_to_int(c));
+        ret.push_back(std::move(am_ntet));
+    }
+
+    return ret;
+}
+
+
 int element_to_z(const std::string & element)
 {
     std::string tmp = str_tolower(element);
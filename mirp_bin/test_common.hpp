@@ -35,6 +35,15 @@ void print_results(unsigned long nfailed, unsigned long ntests);
 int amchar_to_int(char am);
 
 
+/*! \brief Convert a comma-separated list of AM classes to integers
+ *
+ * Each AM class is given by its letters (for example, "ssss,psps,dddd")
+ *
+ * \throw std::runtime_error if a character cannot be converted to an integer
+ */
+std::vector<std::vector<int>> amlist_from_string(const std::string & amlist);
+
+
 /*! \brief Convert a string representing an element to its atomic Z number
  *
  * Converts H to 1, He to 2, etc
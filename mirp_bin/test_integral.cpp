@@ -4,6 +4,11 @@
  */
 
 #include "mirp_bin/callback_helper.hpp"
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/parallel_helper.hpp"
+#include "mirp_bin/reorder_buffer.hpp"
+#include "mirp_bin/shard.hpp"
+#include "mirp_bin/testfile_binary.hpp"
 #include "mirp_bin/testfile_io.hpp"
 #include "mirp_bin/test_integral.hpp"
 #include "mirp_bin/test_common.hpp"
@@ -12,9 +17,12 @@
 #include <mirp/math.h>
 #include <mirp/shell.h>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <sstream>
 
 namespace mirp {
 
@@ -28,31 +36,182 @@ static size_t nintegrals(const integral_data_entry & ent)
 }
 
 
-template<int N>
-void integral_create_test(const std::string & input_filepath,
-                          const std::string & output_filepath,
-                          slong working_prec, long ndigits,
-                          const std::string & header,
-                          typename callback_helper<N>::cb_str_type cb)
+/*! \brief Number of entries per thread that may be held in memory at once */
+static const long entries_per_thread = 4;
+
+
+/*! \brief A vector of arb_t that is kept between tasks, and grows as needed */
+struct arb_buffer
 {
-    integral_data data = testfile_read_integral(input_filepath, N, true);
+    arb_ptr v;
+    slong n;
 
-    data.ndigits = ndigits;
-    data.working_prec = working_prec;
-    data.header += header;
+    arb_buffer(void) : v(nullptr), n(0) { }
+    arb_buffer(const arb_buffer &) = delete;
+    arb_buffer & operator=(const arb_buffer &) = delete;
 
-    /* What we need for the number of digits (plus some safety) */
-    const slong min_prec = static_cast<slong>( static_cast<double>(ndigits+5) / MIRP_LOG_10_2 );
+    ~arb_buffer(void)
+    {
+        if(v)
+            _arb_vec_clear(v, n);
+    }
+
+    /*! \brief Obtain a vector with at least \p m elements (contents are unspecified) */
+    arb_ptr get(size_t m)
+    {
+        const slong sm = static_cast<slong>(m);
+        if(sm > n)
+        {
+            if(v)
+                _arb_vec_clear(v, n);
+            v = _arb_vec_init(sm);
+            n = sm;
+        }
+        return v;
+    }
+};
+
+
+/*! \brief An entry of a test file, and the results of computing or checking it */
+struct entry_result
+{
+    integral_data_entry ent;  //!< The entry read from the file
+    std::string report;       //!< Output to be printed for this entry
+    long nfailed;             //!< Number of failed tests in this entry
+};
+
+
+/*! \brief Reads, processes, and writes the entries of a test file in a pipeline
+ *
+ * Entries are read in order (by one thread at a time), processed in parallel,
+ * and then passed to \p write_func in the order of the file. Only a bounded
+ * number of entries are held in memory at any time.
+ *
+ * The number of entries in the file is checked once all have been read.
+ *
+ * \param [in] reader       Reader for the input file
+ * \param [in] ntask        Number of entries to process (the remaining entries
+ *                          of the file, or fewer when stopping early)
+ * \param [in] nthreads     Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] compute_func Function that processes an entry
+ * \param [in] write_func   Function that writes or reports an entry
+ */
+template<typename Workspace, typename ComputeFunc, typename WriteFunc>
+static void run_pipeline(testfile_integral_reader & reader, long ntask, int nthreads,
+                         ComputeFunc compute_func, WriteFunc write_func)
+{
+    nthreads = mirp_scheduler_nthreads(nthreads);
+
+    reorder_buffer<entry_result> buffer(entries_per_thread * nthreads,
+                                        [&](long, entry_result & r) { write_func(r); });
+    task_sequencer sequencer;
+
+    auto run = [&](long i, Workspace & ws)
+    {
+        try {
+            buffer.run(i, [&](entry_result & r)
+            {
+                r.report.clear();
+                r.nfailed = 0;
+
+                const bool read = sequencer.run(i, [&]()
+                {
+                    // Fewer entries than claimed by the file
+                    if(!reader.read_entry(r.ent))
+                        reader.finish();
+                });
+
+                // If reading was aborted, so is the buffer, and
+                // this entry is never written
+                if(read)
+                    compute_func(r, ws);
+            });
+        }
+        catch(...)
+        {
+            sequencer.abort();
+            throw;
+        }
+    };
+
+    parallel_helper<Workspace>::run(ntask, nthreads, run);
+
+    if(reader.nread() < reader.nentry())
+        return;
+
+    // More entries than claimed by the file
+    integral_data_entry extra;
+    reader.read_entry(extra);
+    reader.finish();
+}
+
+
+/*! \brief Skips entries of a file
+ *
+ * \throw std::runtime_error if the file has fewer entries
+ */
+static void skip_entries(testfile_integral_reader & reader, size_t n)
+{
+    integral_data_entry ent;
+    for(size_t i = 0; i < n; i++)
+    {
+        if(!reader.read_entry(ent))
+            reader.finish();
+    }
+}
+
+
+/*! \brief Determines the entries of a file that belong to a shard
+ *
+ * The file is read once to estimate the cost of each entry (see shard.hpp).
+ *
+ * \param [in] reader   Reader for the file, from which no entries have been read
+ * \param [in] filepath Path to the file
+ * \param [in] n        Number of centers in the integral
+ * \param [in] is_input True if the file is a test input file
+ * \param [in] shard    The shard to find the entries of
+ * \return The first entry of the shard, and one past its last entry
+ */
+static std::pair<size_t, size_t> entry_shard_range(const testfile_integral_reader & reader,
+                                                   const std::string & filepath, int n,
+                                                   bool is_input, const shard_spec & shard)
+{
+    if(shard.all())
+        return {0, reader.nentry()};
+
+    testfile_integral_reader costfile(filepath, n, is_input);
+
+    std::vector<double> costs;
+    integral_data_entry ent;
+
+    while(costfile.read_entry(ent))
+    {
+        double cost = 1.0;
+        for(const auto & g : ent.g)
+            cost *= shard_shell_cost(g.am, g.nprim);
+        costs.push_back(cost);
+    }
+    costfile.finish();
 
+    const std::pair<size_t, size_t> range = shard_range(costs, shard);
+    std::cout << "Shard " << shard.index << "/" << shard.count << ": entries " << range.first
+              << " to " << range.second << " of " << costs.size() << "\n";
+    return range;
+}
+
+
+/*! \brief Per-thread storage for unpacking entries with string parameters */
+template<int N>
+struct workspace_str
+{
     std::array<std::array<const char *, 3>, N> xyz;
     std::array<std::vector<const char *>, N> alpha, coeff;
     std::array<int, N> am, nprim, ngeneral;
+    arb_buffer integrals;
 
-    for(auto & ent : data.entries)
+    /*! \brief Unpack the shells of an entry (which must outlive the unpacked data) */
+    void unpack(const integral_data_entry & ent)
     {
-        const size_t nint = nintegrals(ent);
-        arb_ptr integrals = _arb_vec_init(nint);
-
         for(int n = 0; n < N; n++)
         {
             const auto & g = ent.g[n];
@@ -72,8 +231,87 @@ void integral_create_test(const std::string & input_filepath,
             for(int i = 0; i < g.nprim*g.ngeneral; i++)
                 coeff[n].push_back(g.coeff[i].c_str());
         }
+    }
+};
+
+
+template<int N>
+void integral_create_test(const std::string & input_filepath,
+                          const std::string & output_filepath,
+                          slong working_prec, long ndigits,
+                          const std::string & header,
+                          int nthreads,
+                          const shard_spec & shard,
+                          const checkpoint_options & ckpt_opt,
+                          typename callback_helper<N>::cb_str_type cb)
+{
+    testfile_integral_reader reader(input_filepath, N, true);
+
+    integral_data info = reader.info();
+    info.ndigits = ndigits;
+    info.working_prec = working_prec;
+    info.header += header;
+
+    // Entries of the input file written to this file
+    const std::pair<size_t, size_t> range = entry_shard_range(reader, input_filepath, N, true, shard);
+    const long nentry = static_cast<long>(range.second - range.first);
 
-        callback_helper<N>::call_str(integrals, am, xyz, nprim, ngeneral, alpha, coeff, working_prec, cb);
+    /* What we need for the number of digits (plus some safety) */
+    const slong min_prec = static_cast<slong>( static_cast<double>(ndigits+5) / MIRP_LOG_10_2 );
+
+    // Everything that determines the contents of the file, including
+    // the contents of the input file (not just its name)
+    std::ostringstream fingerprint;
+    fingerprint << info.header << "\n" << nentry << " " << ndigits << " " << working_prec
+                << "\n" << shard.index << "/" << shard.count
+                << "\n" << std::hex << checkpoint_fingerprint_file(input_filepath) << std::dec;
+
+    checkpoint ckpt;
+    ckpt.fingerprint = checkpoint_fingerprint(fingerprint.str());
+
+    std::unique_ptr<testfile_integral_writer> writer;
+
+    if(ckpt_opt.resume)
+    {
+        ckpt = checkpoint_resume(output_filepath, ckpt.fingerprint);
+        if(ckpt.ncomplete > static_cast<uint64_t>(nentry))
+            throw std::runtime_error("Checkpoint has more entries than the input file");
+
+        std::cout << "Resuming after " << ckpt.ncomplete << " of " << nentry << " entries\n";
+        writer.reset(new testfile_integral_writer(output_filepath));
+    }
+    else
+        writer.reset(new testfile_integral_writer(output_filepath, info, static_cast<size_t>(nentry)));
+
+    // Skip the entries of earlier shards, and those that were already computed
+    skip_entries(reader, range.first + static_cast<size_t>(ckpt.ncomplete));
+
+    // Entries computed by this run
+    const long first = static_cast<long>(ckpt.ncomplete);
+    long ntask = nentry - first;
+    if(ckpt_opt.stop_after > 0)
+        ntask = std::min(ntask, ckpt_opt.stop_after);
+
+    checkpoint_timer timer(ckpt_opt.interval);
+    long nwritten = 0;
+
+    auto save_checkpoint = [&](void)
+    {
+        ckpt.ncomplete = static_cast<uint64_t>(first + nwritten);
+        ckpt.offset = writer->offset();
+        checkpoint_write(output_filepath, ckpt);
+    };
+
+    auto compute = [&](entry_result & r, workspace_str<N> & ws)
+    {
+        auto & ent = r.ent;
+
+        const size_t nint = nintegrals(ent);
+        arb_ptr integrals = ws.integrals.get(nint);
+
+        ws.unpack(ent);
+        callback_helper<N>::call_str(integrals, ws.am, ws.xyz, ws.nprim, ws.ngeneral,
+                                     ws.alpha, ws.coeff, working_prec, cb);
 
         for(size_t i = 0; i < nint; i++)
         {
@@ -85,82 +323,112 @@ void integral_create_test(const std::string & input_filepath,
             ent.integrals.push_back(s);
             free(s);
         }
+    };
 
-        _arb_vec_clear(integrals, nint);
+    auto write = [&](entry_result & r)
+    {
+        writer->write_entry(r.ent);
+        nwritten++;
+
+        if(timer.due())
+            save_checkpoint();
+    };
+
+    run_pipeline<workspace_str<N>>(reader, ntask, nthreads, compute, write);
+
+    // Stopped early, so the file can be continued later
+    if(first + ntask < nentry)
+    {
+        save_checkpoint();
+        std::cout << "Stopped with " << ckpt.ncomplete << " of " << nentry
+                  << " entries saved. Run again with --resume to continue\n";
+        return;
     }
 
-    testfile_write_integral(output_filepath, data);
+    writer.reset();
+    checkpoint_remove(output_filepath);
 }
 
 
 template<int N>
 long integral_verify_test(const std::string & filepath,
                           slong working_prec,
+                          int nthreads,
+                          const shard_spec & shard,
                           typename callback_helper<N>::cb_str_type cb)
 {
     long nfailed = 0;
+    long nentry = 0;
 
-    integral_data data = testfile_read_integral(filepath, N, false);
-
-    arb_t integral_ref;
-    arb_init(integral_ref);
+    testfile_integral_reader reader(filepath, N, false);
 
-    std::array<std::array<const char *, 3>, N> xyz;
-    std::array<std::vector<const char *>, N> alpha, coeff;
-    std::array<int, N> am, nprim, ngeneral;
+    // Only the entries of this shard are checked
+    const std::pair<size_t, size_t> range = entry_shard_range(reader, filepath, N, false, shard);
+    skip_entries(reader, range.first);
+    const long ndigits = reader.info().ndigits;
 
-    for(auto & ent : data.entries)
+    /* Per-thread storage, including the reference integral */
+    struct workspace : public workspace_str<N>
     {
-        const size_t nint = nintegrals(ent);
-        arb_ptr integrals = _arb_vec_init(nint);
+        arb_t integral_ref;
 
-        for(int n = 0; n < N; n++)
-        {
-            const auto & g = ent.g[n];
+        workspace(void) { arb_init(integral_ref); }
+        ~workspace(void) { arb_clear(integral_ref); }
+    };
 
-            alpha[n].clear();
-            coeff[n].clear();
+    auto compute = [&](entry_result & r, workspace & ws)
+    {
+        const auto & ent = r.ent;
 
-            am[n] = g.am;
-            nprim[n] = g.nprim;
-            ngeneral[n] = g.ngeneral;
+        const size_t nint = nintegrals(ent);
+        arb_ptr integrals = ws.integrals.get(nint);
 
-            /* Unpack xyz, exponents, and coefficients */
-            for(int i = 0; i < 3; i++)
-                xyz[n][i] = g.xyz[i].c_str();
-            for(int i = 0; i < g.nprim; i++)
-                alpha[n].push_back(g.alpha[i].c_str());
-            for(int i = 0; i < g.nprim*g.ngeneral; i++)
-                coeff[n].push_back(g.coeff[i].c_str());
-        }
+        ws.unpack(ent);
+        callback_helper<N>::call_str(integrals, ws.am, ws.xyz, ws.nprim, ws.ngeneral,
+                                     ws.alpha, ws.coeff, working_prec, cb);
 
-        callback_helper<N>::call_str(integrals, am, xyz, nprim, ngeneral, alpha, coeff, working_prec, cb);
+        std::ostringstream ss;
+
+        // Binary files store the reference balls exactly
+        const unsigned char * p = ent.integrals_bin.data();
+        const unsigned char * end = p + ent.integrals_bin.size();
+        const bool is_binary = !ent.integrals_bin.empty();
 
         for(size_t i = 0; i < nint; i++)
         {
-            arb_set_str(integral_ref, ent.integrals[i].c_str(), working_prec);
+            if(is_binary)
+                p = arb_deserialize(ws.integral_ref, p, end);
+            else
+                arb_set_str(ws.integral_ref, ent.integrals[i].c_str(), working_prec);
 
             /* Do the intervals overlap? */
-            if(!arb_overlaps(integral_ref, integrals+i))
+            if(!arb_overlaps(ws.integral_ref, integrals+i))
             {
-                std::cout << "Entry failed test:\n";
-                char * s1 = arb_get_str(integrals+i, 2*data.ndigits, 0);
-                char * s2 = arb_get_str(integral_ref, 2*data.ndigits, 0);
-                std::cout << "   Calculated: " << s1 << "\n";
-                std::cout << "    Reference: " << s2 << "\n\n";
+                ss << "Entry failed test:\n";
+                char * s1 = arb_get_str(integrals+i, 2*ndigits, 0);
+                char * s2 = arb_get_str(ws.integral_ref, 2*ndigits, 0);
+                ss << "   Calculated: " << s1 << "\n";
+                ss << "    Reference: " << s2 << "\n\n";
                 free(s1);
                 free(s2);
-                nfailed++;
+                r.nfailed++;
             }
         }
 
-        _arb_vec_clear(integrals, nint);
+        r.report = ss.str();
+    };
 
-    }
+    // Failures are printed in the order of the file
+    auto write = [&](entry_result & r)
+    {
+        std::cout << r.report;
+        nfailed += r.nfailed;
+        nentry++;
+    };
 
-    arb_clear(integral_ref);
+    run_pipeline<workspace>(reader, static_cast<long>(range.second - range.first), nthreads, compute, write);
 
-    print_results(nfailed, data.entries.size());
+    print_results(nfailed, nentry);
 
     return nfailed;
 }
@@ -168,124 +436,165 @@ long integral_verify_test(const std::string & filepath,
 
 template<int N>
 long integral_verify_test_exact(const std::string & filepath,
+                                int nthreads,
+                                const shard_spec & shard,
                                 typename callback_helper<N>::cb_exact_type cb,
                                 typename callback_helper<N>::cb_type cb_arb)
 {
     long nfailed = 0;
+    long nentry = 0;
 
-    integral_data data = testfile_read_integral(filepath, N, false);
+    testfile_integral_reader reader(filepath, N, false);
 
-    std::array<std::array<double, 3>, N> xyz;
-    std::array<std::vector<double>, N> alpha, coeff;
-    std::vector<double> integrals;
+    // Only the entries of this shard are checked
+    const std::pair<size_t, size_t> range = entry_shard_range(reader, filepath, N, false, shard);
+    skip_entries(reader, range.first);
 
-    std::array<arb_ptr, N> xyz_arb;
-    for(auto & it : xyz_arb)
-        it = _arb_vec_init(3);
+    /* Per-thread storage for converting the entries */
+    struct workspace
+    {
+        std::array<std::array<double, 3>, N> xyz;
+        std::array<std::vector<double>, N> alpha, coeff;
+        std::vector<double> integrals;
+        std::array<int, N> am, nprim, ngeneral;
 
-    std::array<int, N> am, nprim, ngeneral;
+        std::array<arb_buffer, N> xyz_arb, alpha_arb, coeff_arb;
+        arb_buffer integrals_arb;
+
+        arb_t integral_ref;
+
+        workspace(void) { arb_init(integral_ref); }
+        ~workspace(void) { arb_clear(integral_ref); }
+    };
 
-    for(const auto & ent : data.entries)
+    auto compute = [&](entry_result & r, workspace & ws)
     {
+        const auto & ent = r.ent;
+
         const size_t nint = nintegrals(ent);
-        integrals.resize(nint);
+        ws.integrals.resize(nint);
 
-        arb_ptr integrals_arb = _arb_vec_init(nint);
+        arb_ptr integrals_arb = ws.integrals_arb.get(nint);
 
-        std::array<arb_ptr, N> alpha_arb, coeff_arb;
+        std::array<arb_ptr, N> xyz_arb, alpha_arb, coeff_arb;
 
         for(int n = 0; n < N; n++)
         {
             const auto & g = ent.g[n];
 
-            alpha[n].clear();
-            coeff[n].clear();
+            ws.alpha[n].clear();
+            ws.coeff[n].clear();
 
-            alpha_arb[n] = _arb_vec_init(g.nprim);
-            coeff_arb[n] = _arb_vec_init(g.nprim*g.ngeneral);
+            xyz_arb[n] = ws.xyz_arb[n].get(3);
+            alpha_arb[n] = ws.alpha_arb[n].get(static_cast<size_t>(g.nprim));
+            coeff_arb[n] = ws.coeff_arb[n].get(static_cast<size_t>(g.nprim*g.ngeneral));
 
-            am[n] = g.am;
-            nprim[n] = g.nprim;
-            ngeneral[n] = g.ngeneral;
+            ws.am[n] = g.am;
+            ws.nprim[n] = g.nprim;
+            ws.ngeneral[n] = g.ngeneral;
 
             for(int i = 0; i < 3; i++)
             {
-                xyz[n][i] = std::strtod(ent.g[n].xyz[i].c_str(), nullptr);
-                arb_set_d(xyz_arb[n] + i, xyz[n][i]);
+                ws.xyz[n][i] = std::strtod(ent.g[n].xyz[i].c_str(), nullptr);
+                arb_set_d(xyz_arb[n] + i, ws.xyz[n][i]);
             }
 
             for(int i = 0; i < g.nprim; i++)
             {
-                alpha[n].push_back(std::strtod(g.alpha[i].c_str(), nullptr));
-                arb_set_d(alpha_arb[n]+i, alpha[n][i]);
+                ws.alpha[n].push_back(std::strtod(g.alpha[i].c_str(), nullptr));
+                arb_set_d(alpha_arb[n]+i, ws.alpha[n][i]);
             }
 
             for(int i = 0; i < g.nprim*g.ngeneral; i++)
             {
-                coeff[n].push_back(std::strtod(g.coeff[i].c_str(), nullptr));
-                arb_set_d(coeff_arb[n]+i, coeff[n][i]);
+                ws.coeff[n].push_back(std::strtod(g.coeff[i].c_str(), nullptr));
+                arb_set_d(coeff_arb[n]+i, ws.coeff[n][i]);
             }
         }
 
-        callback_helper<N>::call_exact(integrals.data(), am, xyz, nprim, ngeneral, alpha, coeff, cb);
+        const long nuncertified = callback_helper<N>::call_exact(ws.integrals.data(), ws.am, ws.xyz, ws.nprim,
+                                                                 ws.ngeneral, ws.alpha, ws.coeff, cb);
 
         /* Compute using very high precision */
-        callback_helper<N>::call(integrals_arb, am, xyz_arb, nprim, ngeneral, alpha_arb, coeff_arb, 512, cb_arb);
-
-
-        for(int n = 0; n < N; n++)
-        {
-            const auto & g = ent.g[n];
-            _arb_vec_clear(alpha_arb[n], g.nprim);
-            _arb_vec_clear(coeff_arb[n], g.nprim*g.ngeneral);
-        }
+        callback_helper<N>::call(integrals_arb, ws.am, xyz_arb, ws.nprim, ws.ngeneral, alpha_arb, coeff_arb, 512, cb_arb);
 
-        slong acc_bits = mirp_min_accuracy_bits(integrals_arb, nint);
+        slong acc_bits = mirp_min_accuracy_bits(integrals_arb, static_cast<slong>(nint));
 
         if(acc_bits > 0 && acc_bits < 64)
             throw std::logic_error("Not enough bits in testing exact integral function. Contact the developer");
 
-        bool failed_shell = false;
+        std::ostringstream ss;
+        ss.precision(17);
+
+        const unsigned char * p = ent.integrals_bin.data();
+        const unsigned char * end = p + ent.integrals_bin.size();
+        const bool is_binary = !ent.integrals_bin.empty();
+
         for(size_t i = 0; i < nint; i++)
         {
-            double vref_dbl = std::strtod(ent.integrals[i].c_str(), nullptr);
+            double vref_dbl;
+            if(is_binary)
+            {
+                p = arb_deserialize(ws.integral_ref, p, end);
+                vref_dbl = arf_get_d(arb_midref(ws.integral_ref), ARF_RND_NEAR);
+            }
+            else
+                vref_dbl = std::strtod(ent.integrals[i].c_str(), nullptr);
+
             double vref2_dbl = arf_get_d(arb_midref(integrals_arb+i), ARF_RND_NEAR);
 
             PRAGMA_WARNING_PUSH
             PRAGMA_WARNING_IGNORE_FP_EQUALITY
 
-            if(integrals[i] != vref_dbl && integrals[i] != vref2_dbl)
+            if(ws.integrals[i] != vref_dbl && ws.integrals[i] != vref2_dbl)
             {
-                std::cout << "Entry failed test:\n";
+                ss << "Entry failed test:\n";
                 for(int j = 0; j < N; j++)
                 {
-                    std::cout << ent.g[j].am << " "
-                              << ent.g[j].xyz[0] << " "
-                              << ent.g[j].xyz[1] << " "
-                              << ent.g[j].xyz[2] << "\n";
+                    ss << ent.g[j].am << " "
+                       << ent.g[j].xyz[0] << " "
+                       << ent.g[j].xyz[1] << " "
+                       << ent.g[j].xyz[2] << "\n";
                 }
 
-                auto old_cout_prec = std::cout.precision(17);
-                std::cout << "     Calculated: " << integrals[i] << "\n";
-                std::cout << "      Reference: " << vref2_dbl << "\n";
-                std::cout << " File Reference: " << vref_dbl << "\n\n";
-                std::cout.precision(old_cout_prec);
-                failed_shell = true;
+                ss << "     Calculated: " << ws.integrals[i] << "\n";
+                ss << "      Reference: " << vref2_dbl << "\n";
+                ss << " File Reference: " << vref_dbl << "\n\n";
+                r.nfailed = 1;
             }
 
             PRAGMA_WARNING_POP
         }
 
-        _arb_vec_clear(integrals_arb, nint);
+        // Exact results must all be correctly rounded
+        if(nuncertified > 0)
+        {
+            ss << "Entry has " << nuncertified << " integrals that could not be certified:\n";
+            for(int j = 0; j < N; j++)
+            {
+                ss << ent.g[j].am << " "
+                   << ent.g[j].xyz[0] << " "
+                   << ent.g[j].xyz[1] << " "
+                   << ent.g[j].xyz[2] << "\n";
+            }
+            ss << "\n";
+            r.nfailed = 1;
+        }
 
-        if(failed_shell)
-            nfailed++;
-    }
+        r.report = ss.str();
+    };
+
+    // Failures are printed in the order of the file
+    auto write = [&](entry_result & r)
+    {
+        std::cout << r.report;
+        nfailed += r.nfailed;
+        nentry++;
+    };
 
-    print_results(nfailed, data.entries.size());
+    run_pipeline<workspace>(reader, static_cast<long>(range.second - range.first), nthreads, compute, write);
 
-    for(auto & it : xyz_arb)
-        _arb_vec_clear(it, 3);
+    print_results(nfailed, nentry);
 
     return nfailed;
 }
@@ -299,16 +608,19 @@ integral_create_test<4>(const std::string &,
                         const std::string &,
                         slong, long,
                         const std::string &,
+                        int,
+                        const shard_spec &,
+                        const checkpoint_options &,
                         callback_helper<4>::cb_str_type);
 
 template long
-integral_verify_test<4>(const std::string &, slong,
-    callback_helper<4>::cb_str_type);
+integral_verify_test<4>(const std::string &, slong, int,
+    const shard_spec &, callback_helper<4>::cb_str_type);
 
 
 template long
-integral_verify_test_exact<4>(const std::string &,
-    callback_helper<4>::cb_exact_type,
+integral_verify_test_exact<4>(const std::string &, int,
+    const shard_spec &, callback_helper<4>::cb_exact_type,
     callback_helper<4>::cb_type);
 
 } // close namespace mirp
@@ -9,6 +9,8 @@
 #include <string>
 
 #include "mirp_bin/callback_helper.hpp"
+#include "mirp_bin/checkpoint.hpp"
+#include "mirp_bin/shard.hpp"
 
 namespace mirp {
 
@@ -106,6 +108,17 @@ integral_single_verify_test_exact<4>(
  *
  * Any existing output file (given by \p output_filepath) will be overwritten.
  *
+ * Entries are read, computed in parallel, and written in a pipeline, so only
+ * a limited number of entries are held in memory. The output does not depend
+ * on the number of threads.
+ *
+ * If a shard is given, only its entries of the input file are computed (see
+ * shard.hpp), and the output file contains only those entries.
+ *
+ * Checkpoints are written periodically, so that an interrupted run can be
+ * continued (with the same arguments and the same contents of the input file)
+ * and results in the same file (see checkpoint.hpp).
+ *
  * \throw std::runtime_error if there is a problem opening the file or there
  *        there is a problem reading or writing the data
  *
@@ -119,6 +132,9 @@ integral_single_verify_test_exact<4>(
  * \param [in] ndigits         Number of digits to print
  * \param [in] header          Header information to add to the file
  *                             (appended to the input file header)
+ * \param [in] nthreads        Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] shard           Shard of the entries of the input file to compute
+ * \param [in] ckpt_opt        Options for checkpointing, continuing, and stopping early
  * \param [in] cb              Function that computes contracted integrals
  */
 template<int N>
@@ -126,6 +142,9 @@ void integral_create_test(const std::string & input_filepath,
                           const std::string & output_filepath,
                           slong working_prec, long ndigits,
                           const std::string & header,
+                          int nthreads,
+                          const shard_spec & shard,
+                          const checkpoint_options & ckpt_opt,
                           typename callback_helper<N>::cb_str_type cb);
 
 extern template void
@@ -133,9 +152,15 @@ integral_create_test<4>(const std::string &,
                         const std::string &,
                         slong, long,
                         const std::string &,
+                        int,
+                        const shard_spec &,
+                        const checkpoint_options &,
                         callback_helper<4>::cb_str_type);
 
-/*! \brief Runs a test of single cartesian integrals
+/*! \brief Runs a test of contracted integrals
+ *
+ * Entries are checked in parallel, and failures are printed in the
+ * order of the file.
  *
  * \throw std::runtime_error if there is a problem opening the file or there
  *        there is a problem reading or writing the data
@@ -143,26 +168,35 @@ integral_create_test<4>(const std::string &,
  * \tparam N Number of centers the integral needs
  * \param [in] filepath     Path to the file with the reference data
  * \param [in] working_prec Internal working precision to use
+ * \param [in] nthreads     Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] shard        Shard of the entries of the file to check (see shard.hpp)
  * \param [in] cb           Function that computes contracted integrals
  * \return Number of failed tests
  */
 template<int N>
 long integral_verify_test(const std::string & filepath,
                           slong working_prec,
+                          int nthreads,
+                          const shard_spec & shard,
                           typename callback_helper<N>::cb_str_type cb);
 
 extern template long
-integral_verify_test<4>(const std::string &, slong,
-    callback_helper<4>::cb_str_type);
+integral_verify_test<4>(const std::string &, slong, int,
+    const shard_spec &, callback_helper<4>::cb_str_type);
 
 
 /*! \brief Test contracted integrals in exact double precision
  *
  * The integrals are tested to be exactly equal to the reference data
- * or to integral computed with very large accuracy.
+ * or to integral computed with very large accuracy. Entries with integrals
+ * that could not be certified (see \ref mirp_integral4_exact) also fail.
+ * Entries are checked in parallel, and failures are printed in the
+ * order of the file.
  *
  * \tparam N Number of centers the integral needs
  * \param [in] filepath  Path to the file with the reference data
+ * \param [in] nthreads  Number of threads to use (see \ref mirp_scheduler_nthreads)
+ * \param [in] shard     Shard of the entries of the file to check (see shard.hpp)
  * \param [in] cb        Function that computes contracted integrals
  *                       in exact double precision
  * \param [in] cb_arb     Function that computes contracted integrals
@@ -171,11 +205,14 @@ integral_verify_test<4>(const std::string &, slong,
  */
 template<int N>
 long integral_verify_test_exact(const std::string & filepath,
+                                int nthreads,
+                                const shard_spec & shard,
                                 typename callback_helper<N>::cb_exact_type cb,
                                 typename callback_helper<N>::cb_type cb_arb);
 
 extern template long
-integral_verify_test_exact<4>(const std::string &,
+integral_verify_test_exact<4>(const std::string &, int,
+                              const shard_spec &,
                               callback_helper<4>::cb_exact_type,
                               callback_helper<4>::cb_type);
 
@@ -23,11 +23,14 @@ void integral_single_create_test(const std::string & input_filepath,
                                  const std::string & header,
                                  typename callback_helper<N>::cb_single_str_type cb)
 {
-    integral_single_data data = testfile_read_integral_single(input_filepath, N, true);
+    testfile_integral_single_reader reader(input_filepath, N, true);
 
-    data.ndigits = ndigits;
-    data.working_prec = working_prec;
-    data.header += header;
+    integral_single_data info = reader.info();
+    info.ndigits = ndigits;
+    info.working_prec = working_prec;
+    info.header += header;
+
+    testfile_integral_single_writer writer(output_filepath, info, reader.nentry());
 
     /* What we need for the number of digits (plus some safety) */
     const slong min_prec = static_cast<slong>( static_cast<double>(ndigits+5) / MIRP_LOG_10_2 );
@@ -39,7 +42,10 @@ void integral_single_create_test(const std::string & input_filepath,
     std::array<std::array<int, 3>, N> lmn;
     std::array<const char *, N> alpha;
 
-    for(auto & ent : data.entries)
+    // Entries are computed and written one at a time
+    integral_single_data_entry ent;
+
+    while(reader.read_entry(ent))
     {
         if(ent.g.size() != N)
             throw std::runtime_error("Entry does not have the correct number of gaussians");
@@ -62,9 +68,11 @@ void integral_single_create_test(const std::string & input_filepath,
         char * s = arb_get_str(integral, ndigits, 0);
         ent.integral = s;
         free(s);
+
+        writer.write_entry(ent);
     }
 
-    testfile_write_integral_single(output_filepath, data);
+    reader.finish();
     arb_clear(integral);
 }
 
@@ -74,8 +82,10 @@ long integral_single_verify_test(const std::string & filepath,
                                  typename callback_helper<N>::cb_single_str_type cb)
 {
     long nfailed = 0;
+    long nentry = 0;
 
-    integral_single_data data = testfile_read_integral_single(filepath, N, false);
+    testfile_integral_single_reader reader(filepath, N, false);
+    const long ndigits = reader.info().ndigits;
 
     arb_t integral, integral_ref;
     arb_init(integral);
@@ -85,7 +95,9 @@ long integral_single_verify_test(const std::string & filepath,
     std::array<std::array<int, 3>, N> lmn;
     std::array<const char *, N> alpha;
 
-    for(const auto & ent : data.entries)
+    integral_single_data_entry ent;
+
+    while(reader.read_entry(ent))
     {
         for(int n = 0; n < N; n++)
         {
@@ -105,20 +117,24 @@ long integral_single_verify_test(const std::string & filepath,
         if(!arb_overlaps(integral_ref, integral))
         {
             std::cout << "Entry failed test:\n";
-            char * s1 = arb_get_str(integral, 2*data.ndigits, 0);
-            char * s2 = arb_get_str(integral_ref, 2*data.ndigits, 0);
+            char * s1 = arb_get_str(integral, 2*ndigits, 0);
+            char * s2 = arb_get_str(integral_ref, 2*ndigits, 0);
             std::cout << "   Calculated: " << s1 << "\n";
             std::cout << "    Reference: " << s2 << "\n\n";
             free(s1);
             free(s2);
             nfailed++;
         }
+
+        nentry++;
     }
 
+    reader.finish();
+
     arb_clear(integral);
     arb_clear(integral_ref);
 
-    print_results(nfailed, data.entries.size());
+    print_results(nfailed, nentry);
 
     return nfailed;
 }
@@ -130,8 +146,9 @@ long integral_single_verify_test_exact(const std::string & filepath,
                                        typename callback_helper<N>::cb_single_type cb_arb)
 {
     long nfailed = 0;
+    long nentry = 0;
 
-    integral_single_data data = testfile_read_integral_single(filepath, N, false);
+    testfile_integral_single_reader reader(filepath, N, false);
 
     std::array<std::array<int, 3>, N> lmn;
     
@@ -152,7 +169,9 @@ long integral_single_verify_test_exact(const std::string & filepath,
 
     double integral;
 
-    for(const auto & ent : data.entries)
+    integral_single_data_entry ent;
+
+    while(reader.read_entry(ent))
     {
         for(int n = 0; n < N; n++)
         {
@@ -208,15 +227,19 @@ long integral_single_verify_test_exact(const std::string & filepath,
         }
 
         PRAGMA_WARNING_POP
+
+        nentry++;
     }
 
+    reader.finish();
+
     arb_clear(integral_arb);
     for(auto & it : xyz_arb)
         _arb_vec_clear(it, 3);
     for(auto & it : alpha_arb)
         arb_clear(it);
 
-    print_results(nfailed, data.entries.size());
+    print_results(nfailed, nentry);
 
     return nfailed;
 }
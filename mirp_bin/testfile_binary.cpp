@@ -0,0 +1,379 @@
+/*! \file
+ *
+ * \brief Reading/writing contracted integral test files in binary format
+ */
+
+#include "mirp_bin/testfile_binary.hpp"
+#include "mirp_bin/testfile_io.hpp"
+
+#include <mirp/math.h>
+#include <mirp/shell.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace mirp {
+
+/* Magic string at the start of the file */
+static const char testfile_magic[8] = {'M', 'I', 'R', 'P', 'D', 'A', 'T', 'B'};
+
+
+/* Number of integrals for the shells of an entry */
+static size_t entry_nintegrals(const integral_data_entry & ent)
+{
+    size_t n = 1;
+    for(const auto & g : ent.g)
+        n *= static_cast<size_t>(MIRP_NCART(g.am) * g.ngeneral);
+    return n;
+}
+
+
+static void append_string(std::vector<unsigned char> & buf, const std::string & s)
+{
+    append_le(buf, s.size(), 4);
+    buf.insert(buf.end(), s.begin(), s.end());
+}
+
+
+/*******************************************
+ * Serialization of balls
+ *******************************************/
+void arb_serialize(const arb_t x, std::vector<unsigned char> & out)
+{
+    if(!arb_is_finite(x))
+        throw std::runtime_error("Cannot serialize a ball that is not finite");
+
+    fmpz_t man, exp;
+    arf_t rad;
+    mpz_t z;
+
+    fmpz_init(man);
+    fmpz_init(exp);
+    arf_init(rad);
+    mpz_init(z);
+
+    bool exp_ok = true;
+
+    // Midpoint = man * 2^exp, with man odd
+    if(arf_is_zero(arb_midref(x)))
+        out.push_back(0);
+    else
+    {
+        arf_get_fmpz_2exp(man, exp, arb_midref(x));
+        exp_ok = fmpz_fits_si(exp);
+
+        out.push_back(fmpz_sgn(man) > 0 ? 1 : 2);
+        append_le(out, static_cast<uint64_t>(fmpz_get_si(exp)), 8);
+
+        fmpz_get_mpz(z, man);
+        mpz_abs(z, z);
+
+        const size_t nbytes = (mpz_sizeinbase(z, 2) + 7) / 8;
+        append_le(out, nbytes, 4);
+
+        const size_t pos = out.size();
+        out.resize(pos + nbytes);
+        mpz_export(out.data() + pos, nullptr, -1, 1, 0, 0, z);
+    }
+
+    // Radius (its mantissa has at most 30 bits)
+    arf_set_mag(rad, arb_radref(x));
+    if(arf_is_zero(rad))
+    {
+        append_le(out, 0, 4);
+        append_le(out, 0, 8);
+    }
+    else
+    {
+        arf_get_fmpz_2exp(man, exp, rad);
+        exp_ok = exp_ok && fmpz_fits_si(exp);
+
+        append_le(out, fmpz_get_ui(man), 4);
+        append_le(out, static_cast<uint64_t>(fmpz_get_si(exp)), 8);
+    }
+
+    fmpz_clear(man);
+    fmpz_clear(exp);
+    arf_clear(rad);
+    mpz_clear(z);
+
+    if(!exp_ok)
+        throw std::runtime_error("Exponent of a ball is too large to serialize");
+}
+
+
+const unsigned char * arb_deserialize(arb_t x, const unsigned char * p, const unsigned char * end)
+{
+    if(end - p < 1)
+        throw std::runtime_error("Serialized ball is truncated");
+
+    const int sign = *p++;
+    if(sign > 2)
+        throw std::runtime_error("Invalid serialized ball");
+
+    if(sign == 0)
+        arf_zero(arb_midref(x));
+    else
+    {
+        if(end - p < 12)
+            throw std::runtime_error("Serialized ball is truncated");
+
+        const slong e = static_cast<slong>(static_cast<int64_t>(load_le(p, 8)));
+        const size_t nbytes = static_cast<size_t>(load_le(p+8, 4));
+        p += 12;
+
+        if(static_cast<size_t>(end - p) < nbytes)
+            throw std::runtime_error("Serialized ball is truncated");
+
+        fmpz_t man, exp;
+        mpz_t z;
+        fmpz_init(man);
+        fmpz_init(exp);
+        mpz_init(z);
+
+        mpz_import(z, nbytes, -1, 1, 0, 0, p);
+        if(sign == 2)
+            mpz_neg(z, z);
+
+        fmpz_set_mpz(man, z);
+        fmpz_set_si(exp, e);
+        arf_set_fmpz_2exp(arb_midref(x), man, exp);
+
+        fmpz_clear(man);
+        fmpz_clear(exp);
+        mpz_clear(z);
+
+        p += nbytes;
+    }
+
+    if(end - p < 12)
+        throw std::runtime_error("Serialized ball is truncated");
+
+    const ulong rad_man = static_cast<ulong>(load_le(p, 4));
+    const slong rad_exp = static_cast<slong>(static_cast<int64_t>(load_le(p+4, 8)));
+    p += 12;
+
+    // Exact, since the mantissa came from a mag_t
+    if(rad_man == 0)
+        mag_zero(arb_radref(x));
+    else
+        mag_set_ui_2exp_si(arb_radref(x), rad_man, rad_exp);
+
+    return p;
+}
+
+
+/*******************************************
+ * Reading
+ *******************************************/
+bool testfile_is_binary(const std::string & filepath)
+{
+    return file_has_magic(filepath, testfile_magic, sizeof(testfile_magic));
+}
+
+
+testfile_binary_reader::testfile_binary_reader(const std::string & filepath, int n,
+                                               integral_data & info, size_t & nentry)
+    : err_("Error reading file " + filepath + ": "),
+      file_(filepath),
+      p_(file_.data()), end_(file_.data() + file_.size()),
+      n_(n)
+{
+    if(file_.size() < 48 || std::memcmp(p_, testfile_magic, sizeof(testfile_magic)) != 0)
+        throw std::runtime_error(err_ + "Not a binary test file");
+    p_ += sizeof(testfile_magic);
+
+    const uint64_t version = read_uint(4);
+    if(version != testfile_binary_version)
+    {
+        std::stringstream ss;
+        ss << err_ << "Unsupported version " << version << " (expected " << testfile_binary_version << ")";
+        throw std::runtime_error(ss.str());
+    }
+
+    if(read_uint(4) != static_cast<uint64_t>(n))
+        throw std::runtime_error(err_ + "File is for integrals with a different number of centers");
+
+    nentry = static_cast<size_t>(read_uint(8));
+    info.ndigits = static_cast<long>(read_uint(8));
+    info.working_prec = static_cast<long>(read_uint(8));
+    info.header = read_string();
+}
+
+
+uint64_t testfile_binary_reader::read_uint(int nbytes)
+{
+    if(end_ - p_ < nbytes)
+        throw std::runtime_error(err_ + "Unexpected end of file");
+
+    const uint64_t v = load_le(p_, nbytes);
+    p_ += nbytes;
+    return v;
+}
+
+
+std::string testfile_binary_reader::read_string(void)
+{
+    const size_t len = static_cast<size_t>(read_uint(4));
+    if(static_cast<size_t>(end_ - p_) < len)
+        throw std::runtime_error(err_ + "Unexpected end of file");
+
+    std::string s(reinterpret_cast<const char *>(p_), len);
+    p_ += len;
+    return s;
+}
+
+
+bool testfile_binary_reader::read_entry(integral_data_entry & ent)
+{
+    if(p_ == end_)
+        return false;
+
+    ent.g.resize(static_cast<size_t>(n_));
+    ent.idx.clear();
+    ent.integrals.clear();
+
+    for(auto & g : ent.g)
+    {
+        g.am = static_cast<int>(read_uint(4));
+        g.nprim = static_cast<int>(read_uint(4));
+        g.ngeneral = static_cast<int>(read_uint(4));
+
+        if(g.am < 0 || g.nprim <= 0 || g.ngeneral <= 0)
+            throw std::runtime_error(err_ + "Invalid shell information");
+
+        for(auto & it : g.xyz)
+            it = read_string();
+
+        g.alpha.resize(static_cast<size_t>(g.nprim));
+        g.coeff.resize(static_cast<size_t>(g.nprim*g.ngeneral));
+        for(auto & it : g.alpha)
+            it = read_string();
+        for(auto & it : g.coeff)
+            it = read_string();
+    }
+
+    if(read_uint(8) != entry_nintegrals(ent))
+        throw std::runtime_error(err_ + "Inconsistent number of integrals");
+
+    const size_t nbytes = static_cast<size_t>(read_uint(8));
+    if(static_cast<size_t>(end_ - p_) < nbytes)
+        throw std::runtime_error(err_ + "Unexpected end of file");
+
+    ent.integrals_bin.assign(p_, p_ + nbytes);
+    p_ += nbytes;
+    return true;
+}
+
+
+/*******************************************
+ * Writing
+ *******************************************/
+testfile_binary_writer::testfile_binary_writer(const std::string & filepath, int n,
+                                               const integral_data & info, size_t nentry)
+    : n_(n)
+{
+    outfile_.open(filepath, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if(!outfile_.is_open())
+        throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
+
+    outfile_.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+
+    // The bits needed for the digits in the file (plus some safety)
+    prec_ = static_cast<slong>(static_cast<double>(info.ndigits) / MIRP_LOG_10_2) + 64;
+    if(info.working_prec > 0 && prec_ > info.working_prec)
+        prec_ = info.working_prec;
+
+    buf_.assign(testfile_magic, testfile_magic + sizeof(testfile_magic));
+    append_le(buf_, testfile_binary_version, 4);
+    append_le(buf_, static_cast<uint64_t>(n), 4);
+    append_le(buf_, nentry, 8);
+    append_le(buf_, static_cast<uint64_t>(info.ndigits), 8);
+    append_le(buf_, static_cast<uint64_t>(info.working_prec), 8);
+    append_string(buf_, info.header);
+
+    outfile_.write(reinterpret_cast<const char *>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+}
+
+
+void testfile_binary_writer::write_entry(const integral_data_entry & ent)
+{
+    if(ent.g.size() != static_cast<size_t>(n_))
+        throw std::runtime_error("Entry has the wrong number of shells for the binary test file");
+
+    const size_t nint = entry_nintegrals(ent);
+    if(ent.integrals.size() != nint)
+        throw std::runtime_error("Entry has the wrong number of integrals for the binary test file");
+
+    buf_.clear();
+    for(const auto & g : ent.g)
+    {
+        append_le(buf_, static_cast<uint64_t>(g.am), 4);
+        append_le(buf_, static_cast<uint64_t>(g.nprim), 4);
+        append_le(buf_, static_cast<uint64_t>(g.ngeneral), 4);
+
+        for(const auto & it : g.xyz)
+            append_string(buf_, it);
+        for(const auto & it : g.alpha)
+            append_string(buf_, it);
+        for(const auto & it : g.coeff)
+            append_string(buf_, it);
+    }
+
+    append_le(buf_, nint, 8);
+
+    // Size of the integrals, which is filled in below
+    const size_t size_pos = buf_.size();
+    append_le(buf_, 0, 8);
+
+    arb_t x;
+    arb_init(x);
+
+    try {
+        for(const auto & s : ent.integrals)
+        {
+            if(arb_set_str(x, s.c_str(), prec_) != 0)
+                throw std::runtime_error("Unable to parse integral \"" + s + "\"");
+            arb_serialize(x, buf_);
+        }
+    }
+    catch(...)
+    {
+        arb_clear(x);
+        throw;
+    }
+
+    arb_clear(x);
+
+    store_le(buf_.data() + size_pos, buf_.size() - size_pos - 8, 8);
+    outfile_.write(reinterpret_cast<const char *>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+}
+
+
+/*******************************************
+ * Conversion
+ *******************************************/
+size_t testfile_convert_to_binary(const std::string & text_filepath,
+                                  const std::string & binary_filepath,
+                                  int n)
+{
+    if(testfile_is_binary(text_filepath))
+        throw std::runtime_error("Input file is already in binary format");
+
+    testfile_integral_reader reader(text_filepath, n, false);
+    testfile_binary_writer writer(binary_filepath, n, reader.info(), reader.nentry());
+
+    integral_data_entry ent;
+    size_t nentry = 0;
+
+    while(reader.read_entry(ent))
+    {
+        writer.write_entry(ent);
+        nentry++;
+    }
+
+    reader.finish();
+    return nentry;
+}
+
+} // close namespace mirp
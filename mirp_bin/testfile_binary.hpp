@@ -0,0 +1,182 @@
+/*! \file
+ *
+ * \brief Reading/writing contracted integral test files in binary format
+ *
+ * The binary format holds the same information as the text format, but
+ * the reference integrals are stored as the exact midpoint and radius of
+ * their ball, so that no decimal strings need to be parsed when verifying.
+ * The shell parameters are kept as strings, since they are passed to the
+ * integral functions as strings anyway.
+ *
+ * Layout (all integers are little-endian):
+ *
+ * - Magic string "MIRPDATB" (8 bytes)
+ * - Format version and number of centers (32-bit each)
+ * - Number of entries, number of decimal digits, and working precision (64-bit each)
+ * - The header (a string)
+ * - The entries. For each shell, its AM, number of primitives, and number of
+ *   general contractions (32-bit each), followed by the coordinates, exponents,
+ *   and coefficients (strings, in the order of gaussian_shell_str). After the
+ *   shells, the number of integrals and the size of the serialized integrals
+ *   (in bytes, 64-bit each), then the serialized integrals.
+ *
+ * Strings are stored as their length (32-bit) followed by their characters.
+ *
+ * Each integral is serialized by \ref arb_serialize.
+ */
+
+#pragma once
+
+#include "mirp_bin/data_entry.hpp"
+#include "mirp_bin/binary_io.hpp"
+
+#include <arb.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mirp {
+
+/*! \brief Current version of the binary test file format */
+static const uint32_t testfile_binary_version = 1;
+
+
+/*! \brief Appends the exact binary representation of a ball to a buffer
+ *
+ * The ball is stored as a byte for the sign of the midpoint (0 for zero, 1 for
+ * positive, 2 for negative), followed (for nonzero midpoints) by the exponent
+ * (64-bit) and the mantissa (the number of bytes as 32-bit, followed by the bytes
+ * of the absolute value), so that the midpoint is mantissa * 2^exponent.
+ * The radius is stored as its mantissa (32-bit) and exponent (64-bit).
+ *
+ * \throw std::runtime_error if the ball is not finite
+ *
+ * \param [in]  x   The ball to serialize
+ * \param [out] out The serialized ball is appended to this buffer
+ */
+void arb_serialize(const arb_t x, std::vector<unsigned char> & out);
+
+
+/*! \brief Reads a ball written by \ref arb_serialize
+ *
+ * \throw std::runtime_error if the data is truncated or invalid
+ *
+ * \param [out] x   The ball that was read (exactly as it was serialized)
+ * \param [in]  p   Start of the serialized ball
+ * \param [in]  end End of the available data
+ * \return Pointer to the data following the ball
+ */
+const unsigned char * arb_deserialize(arb_t x, const unsigned char * p, const unsigned char * end);
+
+
+/*! \brief Determines if a file is a binary test file
+ *
+ * \param [in] filepath Path to the file to check
+ * \return True if the file starts with the magic string of the binary format
+ */
+bool testfile_is_binary(const std::string & filepath);
+
+
+/*! \brief Reads the entries of a binary test file in order
+ *
+ * The file is memory mapped, and the integrals of each entry
+ * are copied in their serialized form.
+ */
+class testfile_binary_reader
+{
+public:
+    /*! \brief Opens a file and reads the header and metadata
+     *
+     * \throw std::runtime_error if the file cannot be opened, or if it is
+     *        not a valid binary test file for integrals with \p n centers
+     *
+     * \param [in]  filepath Path to the file
+     * \param [in]  n        Number of centers in the integral
+     * \param [out] info     Header and metadata of the file (without any entries)
+     * \param [out] nentry   Number of entries in the file
+     */
+    testfile_binary_reader(const std::string & filepath, int n,
+                           integral_data & info, size_t & nentry);
+
+
+    /*! \brief Reads the next entry
+     *
+     * The integrals are stored in integral_data_entry::integrals_bin
+     *
+     * \throw std::runtime_error if there is a problem reading the entry
+     *
+     * \param [out] ent The entry that was read
+     * \return False if there are no more entries in the file
+     */
+    bool read_entry(integral_data_entry & ent);
+
+
+private:
+    std::string err_;               /*!< Prefix for errors */
+    mapped_file file_;              /*!< The mapped file */
+    const unsigned char * p_;       /*!< Current position in the file */
+    const unsigned char * end_;     /*!< End of the file */
+    int n_;                         /*!< Number of centers of the integral */
+
+    uint64_t read_uint(int nbytes);
+    std::string read_string(void);
+};
+
+
+/*! \brief Writes contracted integral test data to a binary file one entry at a time
+ *
+ * Any existing file will be overwritten. The header and metadata are written
+ * when the writer is created.
+ */
+class testfile_binary_writer
+{
+public:
+    /*! \brief Opens a file and writes the header and metadata
+     *
+     * \throw std::runtime_error if there is a problem opening or
+     *        writing to the file
+     *
+     * \param [in] filepath  Path to the file to write to
+     * \param [in] n         Number of centers in the integral
+     * \param [in] info      Header and metadata to write (entries are ignored)
+     * \param [in] nentry    Number of entries that will be written
+     */
+    testfile_binary_writer(const std::string & filepath, int n,
+                           const integral_data & info, size_t nentry);
+
+
+    /*! \brief Writes an entry
+     *
+     * The integrals are converted from the strings in integral_data_entry::integrals.
+     * They are parsed with enough precision for the number of digits in the file
+     * (but no more than its working precision), and are then stored exactly.
+     *
+     * \throw std::runtime_error if an integral cannot be parsed, or if
+     *        there is a problem writing to the file
+     */
+    void write_entry(const integral_data_entry & ent);
+
+
+private:
+    std::ofstream outfile_;             /*!< The file being written */
+    int n_;                             /*!< Number of centers of the integral */
+    slong prec_;                        /*!< Precision for parsing the integrals */
+    std::vector<unsigned char> buf_;    /*!< Buffer for an entry */
+};
+
+
+/*! \brief Converts a text test file to binary format
+ *
+ * \throw std::runtime_error if there is a problem reading or writing the files
+ *
+ * \param [in] text_filepath   Path to the text test file
+ * \param [in] binary_filepath Path to the binary file to write
+ * \param [in] n               Number of centers in the integral
+ * \return Number of entries converted
+ */
+size_t testfile_convert_to_binary(const std::string & text_filepath,
+                                  const std::string & binary_filepath,
+                                  int n);
+
+} // close namespace mirp
@@ -4,6 +4,7 @@
  */
 
 #include "mirp_bin/testfile_io.hpp"
+#include "mirp_bin/testfile_binary.hpp"
 #include "mirp_bin/data_entry.hpp"
 #include "mirp_bin/test_common.hpp"
 #include <mirp/shell.h>
@@ -14,366 +15,471 @@
 
 namespace mirp {
 
-integral_single_data testfile_read_integral_single(const std::string & filepath, int n, bool is_input)
+testfile_integral_single_reader::testfile_integral_single_reader(const std::string & filepath,
+                                                                 int n,
+                                                                 bool is_input)
+    : filepath_(filepath), n_(n), is_input_(is_input), nentry_(0), nread_(0)
 {
     using std::ifstream;
 
     if(n <= 0)
         throw std::logic_error("Cannot read negative or zero gaussians from a file");
 
+    infile_.open(filepath, ifstream::in);
+    if(!infile_.is_open())
+        throw std::runtime_error(error_prefix() + "Cannot open file");
 
-    // Used in errors
-    std::stringstream sserr;
-    sserr << "Error reading file " << filepath << ": ";
-
-
-    ifstream infile(filepath);
-    if(!infile.is_open())
-    {
-        sserr << "Cannot open file";
-        throw std::runtime_error(sserr.str());
-    }
-
-    integral_single_data data;
-    size_t nentry = 0;
+    info_.ndigits = 0;
+    info_.working_prec = 0;
 
     // read in the header comments
-    while(infile.peek() == '#')
+    while(infile_.peek() == '#')
     {
         std::string line;
-        std::getline(infile, line);
-        data.header += line + "\n";
+        std::getline(infile_, line);
+        info_.header += line + "\n";
     }
 
     // Read the expected number of entries
-    file_skip(infile, '#');
-    infile >> nentry;
+    file_skip(infile_, '#');
+    infile_ >> nentry_;
 
     // Read in the number of digits and the working prec
     if(!is_input)
     {
-        infile >> data.ndigits >> data.working_prec;
-        if(!infile.good())
-        {
-            sserr << "Error reading metadata (nentry, ndigits, working_prec)";
-            throw std::runtime_error(sserr.str());
-        }
+        infile_ >> info_.ndigits >> info_.working_prec;
+        if(!infile_.good())
+            throw std::runtime_error(error_prefix() + "Error reading metadata (nentry, ndigits, working_prec)");
     }
+}
 
-    // read the actual data
-    while(infile.good())
-    {
-        // check if there is more data
-        if(!file_skip(infile, '#'))
-            break;
 
-        // We will fill in the shells here, then add to the data
-        integral_single_data_entry ent;
+std::string testfile_integral_single_reader::error_prefix(void) const
+{
+    return "Error reading file " + filepath_ + ": ";
+}
+
+
+bool testfile_integral_single_reader::read_entry(integral_single_data_entry & ent)
+{
+    // Used in errors
+    std::stringstream sserr;
+    sserr << error_prefix();
+
+    // check if there is more data
+    if(!infile_.good() || !file_skip(infile_, '#'))
+        return false;
+
+    ent.g.clear();
+    ent.integral.clear();
 
-        // read in n gaussians
-        for(int i = 0; i < n; i++)
+    // read in n gaussians
+    for(int i = 0; i < n_; i++)
+    {
+        if(!file_skip(infile_, '#'))
         {
-            if(!file_skip(infile, '#'))
-            {
-                if(infile.eof())
-                {
-                    sserr << "Unexpected end of file while reading gaussian " << i << "/" << n
-                          << " for entry " << data.entries.size() << "\n";
-                    throw std::runtime_error(sserr.str());
-                }
-                else
-                {
-                    sserr << "Error while reading gaussian " << i << "/" << n
-                          << " for entry " << data.entries.size() << "\n";
-                    throw std::runtime_error(sserr.str());
-                }
-            } 
-
-
-            gaussian_single_str g;
-
-            infile >> g.lmn[0] >> g.lmn[1] >> g.lmn[2]
-                   >> g.xyz[0] >> g.xyz[1] >> g.xyz[2]
-                   >> g.alpha;
- 
-            if(infile.bad() || infile.fail())
+            if(infile_.eof())
             {
-                sserr << "Error while reading gaussian " << i << "/" << n
-                      << " for entry " << data.entries.size() << "\n";
+                sserr << "Unexpected end of file while reading gaussian " << i << "/" << n_
+                      << " for entry " << nread_ << "\n";
                 throw std::runtime_error(sserr.str());
             }
-                
-            ent.g.push_back(std::move(g));
-        }
-
-        // If this is not an input file, read the integral also
-        if(!is_input)
-        {
-            // the first one reads in the rest of the line (which should
-            // be empty). The second will contain the integral
-            file_skip(infile, '#');
-            std::getline(infile, ent.integral);
-
-            if(infile.bad() || infile.fail())
+            else
             {
-                sserr << "Error while integral for entry " << data.entries.size() << "\n";
+                sserr << "Error while reading gaussian " << i << "/" << n_
+                      << " for entry " << nread_ << "\n";
                 throw std::runtime_error(sserr.str());
             }
+        } 
+
+
+        gaussian_single_str g;
+
+        infile_ >> g.lmn[0] >> g.lmn[1] >> g.lmn[2]
+                >> g.xyz[0] >> g.xyz[1] >> g.xyz[2]
+                >> g.alpha;
+ 
+        if(infile_.bad() || infile_.fail())
+        {
+            sserr << "Error while reading gaussian " << i << "/" << n_
+                  << " for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
         }
+            
+        ent.g.push_back(std::move(g));
+    }
 
-        // add the entry
-        data.entries.push_back(std::move(ent));
+    // If this is not an input file, read the integral also
+    if(!is_input_)
+    {
+        // the first one reads in the rest of the line (which should
+        // be empty). The second will contain the integral
+        file_skip(infile_, '#');
+        std::getline(infile_, ent.integral);
+
+        if(infile_.bad() || infile_.fail())
+        {
+            sserr << "Error while integral for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
+        }
     }
 
-    if(data.entries.size() != nentry)
+    nread_++;
+    return true;
+}
+
+
+void testfile_integral_single_reader::finish(void) const
+{
+    if(nread_ != nentry_)
     {
-        sserr << "Number of entries not consistent: Expected " << nentry
-              << " but got " << data.entries.size() << "\n";
+        std::stringstream sserr;
+        sserr << error_prefix() << "Number of entries not consistent: Expected " << nentry_
+              << " but got " << nread_ << "\n";
         throw std::runtime_error(sserr.str());
     }
 
-    std::cout << "Read " << data.entries.size() << " entries from " << filepath << "\n";
+    std::cout << "Read " << nread_ << " entries from " << filepath_ << "\n";
+}
+
+
+integral_single_data testfile_read_integral_single(const std::string & filepath, int n, bool is_input)
+{
+    testfile_integral_single_reader reader(filepath, n, is_input);
+    integral_single_data data = reader.info();
+
+    integral_single_data_entry ent;
+    while(reader.read_entry(ent))
+        data.entries.push_back(std::move(ent));
+
+    reader.finish();
     return data;
 }
 
 
-void testfile_write_integral_single(const std::string & filepath, const integral_single_data & data)
+testfile_integral_single_writer::testfile_integral_single_writer(const std::string & filepath,
+                                                                 const integral_single_data & info,
+                                                                 size_t nentry)
 {
     using std::ofstream;
 
-    ofstream outfile;
-    outfile.open(filepath, ofstream::out | ofstream::trunc);
+    outfile_.open(filepath, ofstream::out | ofstream::trunc);
 
-    if(!outfile.is_open())
+    if(!outfile_.is_open())
         throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
 
-    outfile.exceptions(ofstream::badbit | ofstream::failbit);
+    outfile_.exceptions(ofstream::badbit | ofstream::failbit);
 
-    outfile << data.header;
-    outfile << data.entries.size() << " "
-            << data.ndigits << " "
-            << data.working_prec << "\n";
+    outfile_ << info.header;
+    outfile_ << nentry << " "
+             << info.ndigits << " "
+             << info.working_prec << "\n";
+}
 
-    for(const auto & ent : data.entries)
-    {
-        for(const auto & g : ent.g)
-        {
-            outfile << g.lmn[0] << " " << g.lmn[1] << " " << g.lmn[2] << " "
-                    << g.xyz[0] << " " << g.xyz[1] << " " << g.xyz[2] << " "
-                    << g.alpha << "\n";
-        }
 
-        outfile << ent.integral << "\n\n";
+void testfile_integral_single_writer::write_entry(const integral_single_data_entry & ent)
+{
+    for(const auto & g : ent.g)
+    {
+        outfile_ << g.lmn[0] << " " << g.lmn[1] << " " << g.lmn[2] << " "
+                 << g.xyz[0] << " " << g.xyz[1] << " " << g.xyz[2] << " "
+                 << g.alpha << "\n";
     }
+
+    outfile_ << ent.integral << "\n\n";
 }
 
 
+void testfile_write_integral_single(const std::string & filepath, const integral_single_data & data)
+{
+    testfile_integral_single_writer writer(filepath, data, data.entries.size());
 
-integral_data testfile_read_integral(const std::string & filepath,
-                                     int n,
-                                     bool is_input)
+    for(const auto & ent : data.entries)
+        writer.write_entry(ent);
+}
+
+
+
+testfile_integral_reader::testfile_integral_reader(const std::string & filepath,
+                                                   int n,
+                                                   bool is_input)
+    : filepath_(filepath), n_(n), is_input_(is_input), nentry_(0), nread_(0)
 {
     using std::ifstream;
 
     if(n <= 0)
         throw std::logic_error("Cannot read negative or zero gaussians from a file");
 
-
-    // Used in errors
-    std::stringstream sserr;
-    sserr << "Error reading file " << filepath << ": ";
-
-
-    ifstream infile(filepath, ifstream::in);
-    if(!infile.is_open())
+    if(testfile_is_binary(filepath))
     {
-        sserr << "Cannot open file";
-        throw std::runtime_error(sserr.str());
+        binfile_.reset(new testfile_binary_reader(filepath, n, info_, nentry_));
+        return;
     }
 
-    integral_data data;
-    size_t nentry = 0;
+    infile_.open(filepath, ifstream::in);
+    if(!infile_.is_open())
+        throw std::runtime_error(error_prefix() + "Cannot open file");
+
+    info_.ndigits = 0;
+    info_.working_prec = 0;
 
     // read in the header comments
-    while(infile.peek() == '#')
+    while(infile_.peek() == '#')
     {
         std::string line;
-        std::getline(infile, line);
-        data.header += line + "\n";
+        std::getline(infile_, line);
+        info_.header += line + "\n";
     }
 
 
     // Read the expected number of entries
-    infile >> nentry;
+    infile_ >> nentry_;
 
     // Read in the number of digits and the working prec
     if(!is_input)
     {
-        infile >> data.ndigits >> data.working_prec;
-        if(!infile.good())
-        {
-            sserr << "Error reading metadata (nentry, ndigits, working_prec)";
-            throw std::runtime_error(sserr.str());
-        }
+        infile_ >> info_.ndigits >> info_.working_prec;
+        if(!infile_.good())
+            throw std::runtime_error(error_prefix() + "Error reading metadata (nentry, ndigits, working_prec)");
     }
+}
 
 
-    // read the actual data
-    while(infile.good())
+testfile_integral_reader::~testfile_integral_reader(void)
+{
+}
+
+
+std::string testfile_integral_reader::error_prefix(void) const
+{
+    return "Error reading file " + filepath_ + ": ";
+}
+
+
+bool testfile_integral_reader::read_entry(integral_data_entry & ent)
+{
+    // Used in errors
+    std::stringstream sserr;
+    sserr << error_prefix();
+
+    if(binfile_)
     {
-        // check if there is more data
-        if(!file_skip(infile, '#'))
-            break;
+        if(!binfile_->read_entry(ent))
+            return false;
 
-        // We will fill in the shells here, then add to the data
-        integral_data_entry ent;
+        if(is_input_)
+            ent.integrals_bin.clear();
 
-        // read in n gaussians
-        for(int i = 0; i < n; i++)
+        nread_++;
+        return true;
+    }
+
+    // check if there is more data
+    if(!infile_.good() || !file_skip(infile_, '#'))
+        return false;
+
+    ent.g.clear();
+    ent.idx.clear();
+    ent.integrals.clear();
+    ent.integrals_bin.clear();
+
+    // read in n gaussians
+    for(int i = 0; i < n_; i++)
+    {
+        if(!file_skip(infile_, '#'))
         {
-            if(!file_skip(infile, '#'))
-            {
-                if(infile.eof())
-                {
-                    sserr << "Unexpected end of file while reading gaussian " << i << "/" << n
-                          << " for entry " << data.entries.size() << "\n";
-                    throw std::runtime_error(sserr.str());
-                }
-                else
-                {
-                    sserr << "Error while reading gaussian " << i << "/" << n
-                          << " for entry " << data.entries.size() << "\n";
-                    throw std::runtime_error(sserr.str());
-                }
-            } 
-
-            gaussian_shell_str g;
-            infile >> g.am >> g.nprim >> g.ngeneral
-                   >> g.xyz[0] >> g.xyz[1] >> g.xyz[2];
-
-            if(infile.bad() || infile.fail())
+            if(infile_.eof())
             {
-                sserr << "Error while reading gaussian " << i << "/" << n
-                      << " for entry " << data.entries.size() << "\n";
+                sserr << "Unexpected end of file while reading gaussian " << i << "/" << n_
+                      << " for entry " << nread_ << "\n";
                 throw std::runtime_error(sserr.str());
             }
-
-            if(!file_skip(infile, '#'))
+            else
             {
-                sserr << "Unexpected EOF or error after reading info for gaussian " << i << "/" << n
-                      << " for entry " << data.entries.size() << "\n";
+                sserr << "Error while reading gaussian " << i << "/" << n_
+                      << " for entry " << nread_ << "\n";
                 throw std::runtime_error(sserr.str());
             }
+        } 
 
-            g.alpha.resize(g.nprim);
-            g.coeff.resize(g.nprim*g.ngeneral);
-
-            for(int j = 0; j < g.nprim; j++)
-            {
-                infile >> g.alpha[j];
-                for(int k = 0; k < g.ngeneral; k++)
-                    infile >> g.coeff[k*g.nprim+j];
-            }
+        gaussian_shell_str g;
+        infile_ >> g.am >> g.nprim >> g.ngeneral
+                >> g.xyz[0] >> g.xyz[1] >> g.xyz[2];
 
-            if(infile.bad() || infile.fail())
-            {
-                sserr << "Error while reading exponents and coefficients for gaussian " << i << "/" << n
-                      << " for entry " << data.entries.size() << "\n";
-                throw std::runtime_error(sserr.str());
-            }
+        if(infile_.bad() || infile_.fail())
+        {
+            sserr << "Error while reading gaussian " << i << "/" << n_
+                  << " for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
+        }
 
-            ent.g.push_back(std::move(g));
+        if(!file_skip(infile_, '#'))
+        {
+            sserr << "Unexpected EOF or error after reading info for gaussian " << i << "/" << n_
+                  << " for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
         }
 
+        g.alpha.resize(g.nprim);
+        g.coeff.resize(g.nprim*g.ngeneral);
 
-        // read in the integral values 
-        if(!is_input)
+        for(int j = 0; j < g.nprim; j++)
         {
-            // Read and discard the rest of the line
-            infile.ignore(max_length, '\n');
+            infile_ >> g.alpha[j];
+            for(int k = 0; k < g.ngeneral; k++)
+                infile_ >> g.coeff[k*g.nprim+j];
+        }
 
-            // number of integrals we should be reading
-            size_t nintegral = 1;
-            for(const auto & it : ent.g)
-                nintegral *= MIRP_NCART(it.am)*it.ngeneral;
+        if(infile_.bad() || infile_.fail())
+        {
+            sserr << "Error while reading exponents and coefficients for gaussian " << i << "/" << n_
+                  << " for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
+        }
 
-            ent.integrals.resize(nintegral);
+        ent.g.push_back(std::move(g));
+    }
 
-            // If this isn't an input file, read the integrals
-            int dummy; // integral index (not needed)
 
-            for(size_t i = 0; i < nintegral; i++)
-            {
-                infile >> dummy;
-                std::getline(infile, ent.integrals[i]);
-            }
+    // read in the integral values 
+    if(!is_input_)
+    {
+        // Read and discard the rest of the line
+        infile_.ignore(max_length, '\n');
 
-            if(infile.bad() || infile.fail())
-            {
-                sserr << "Error while reading integrals for entry " << data.entries.size() << "\n";
-                throw std::runtime_error(sserr.str());
-            }
+        // number of integrals we should be reading
+        size_t nintegral = 1;
+        for(const auto & it : ent.g)
+            nintegral *= MIRP_NCART(it.am)*it.ngeneral;
+
+        ent.integrals.resize(nintegral);
+
+        // If this isn't an input file, read the integrals
+        int dummy; // integral index (not needed)
+
+        for(size_t i = 0; i < nintegral; i++)
+        {
+            infile_ >> dummy;
+            std::getline(infile_, ent.integrals[i]);
         }
 
-        // add to the entries
-        data.entries.push_back(std::move(ent));
+        if(infile_.bad() || infile_.fail())
+        {
+            sserr << "Error while reading integrals for entry " << nread_ << "\n";
+            throw std::runtime_error(sserr.str());
+        }
     }
 
-    if(data.entries.size() != nentry)
+    nread_++;
+    return true;
+}
+
+
+void testfile_integral_reader::finish(void) const
+{
+    if(nread_ != nentry_)
     {
-        sserr << "Number of entries not consistent: Expected " << nentry
-              << " but got " << data.entries.size() << "\n";
+        std::stringstream sserr;
+        sserr << error_prefix() << "Number of entries not consistent: Expected " << nentry_
+              << " but got " << nread_ << "\n";
         throw std::runtime_error(sserr.str());
     }
 
-    std::cout << "Read " << data.entries.size() << " entries from " << filepath << "\n";
+    std::cout << "Read " << nread_ << " entries from " << filepath_ << "\n";
+}
+
+
+integral_data testfile_read_integral(const std::string & filepath,
+                                     int n,
+                                     bool is_input)
+{
+    testfile_integral_reader reader(filepath, n, is_input);
+    integral_data data = reader.info();
+
+    integral_data_entry ent;
+    while(reader.read_entry(ent))
+        data.entries.push_back(std::move(ent));
+
+    reader.finish();
     return data;
 }
 
 
-void testfile_write_integral(const std::string & filepath, const integral_data & data)
+testfile_integral_writer::testfile_integral_writer(const std::string & filepath,
+                                                   const integral_data & info,
+                                                   size_t nentry)
 {
     using std::ofstream;
 
-    ofstream outfile;
-    outfile.open(filepath, ofstream::out | ofstream::trunc);
+    outfile_.open(filepath, ofstream::out | ofstream::trunc);
 
-    if(!outfile.is_open())
+    if(!outfile_.is_open())
         throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
 
-    outfile.exceptions(ofstream::badbit | ofstream::failbit);
+    outfile_.exceptions(ofstream::badbit | ofstream::failbit);
+
+    outfile_ << info.header;
+    outfile_ << nentry << " "
+             << info.ndigits << " "
+             << info.working_prec << "\n";
+}
 
-    outfile << data.header;
-    outfile << data.entries.size() << " "
-            << data.ndigits << " "
-            << data.working_prec << "\n";
 
-    for(const auto & ent : data.entries)
+testfile_integral_writer::testfile_integral_writer(const std::string & filepath)
+{
+    using std::ofstream;
+
+    outfile_.open(filepath, ofstream::in | ofstream::out);
+
+    if(!outfile_.is_open())
+        throw std::runtime_error(std::string("Unable to open file \"") + filepath + "\" for writing");
+
+    outfile_.exceptions(ofstream::badbit | ofstream::failbit);
+    outfile_.seekp(0, ofstream::end);
+}
+
+
+void testfile_integral_writer::write_entry(const integral_data_entry & ent)
+{
+    for(const auto & g : ent.g)
     {
-        for(const auto & g : ent.g)
-        {
-            outfile << g.am << " " << g.nprim << " " << g.ngeneral << " "
-                    << g.xyz[0] << " " << g.xyz[1] << " " << g.xyz[2] << "\n";
+        outfile_ << g.am << " " << g.nprim << " " << g.ngeneral << " "
+                 << g.xyz[0] << " " << g.xyz[1] << " " << g.xyz[2] << "\n";
 
-            for(int i = 0; i < g.nprim; i++)
-            {
-                outfile << g.alpha[i];
-                for(int j = 0; j < g.ngeneral; j++)
-                    outfile << " " << g.coeff[j*g.nprim + i];
-                outfile << "\n";
-            }
+        for(int i = 0; i < g.nprim; i++)
+        {
+            outfile_ << g.alpha[i];
+            for(int j = 0; j < g.ngeneral; j++)
+                outfile_ << " " << g.coeff[j*g.nprim + i];
+            outfile_ << "\n";
         }
+    }
 
 
-        size_t ncart = 1;
-        for(const auto & it : ent.g)
-            ncart *= MIRP_NCART(it.am) * it.ngeneral;
+    size_t ncart = 1;
+    for(const auto & it : ent.g)
+        ncart *= MIRP_NCART(it.am) * it.ngeneral;
 
-        for(size_t i = 0; i < ncart; i++)
-            outfile << i << "  " << ent.integrals[i] << "\n";
+    for(size_t i = 0; i < ncart; i++)
+        outfile_ << i << "  " << ent.integrals[i] << "\n";
 
-        outfile << "\n";
-    }
+    outfile_ << "\n";
+}
+
+
+uint64_t testfile_integral_writer::offset(void)
+{
+    outfile_.flush();
+    return static_cast<uint64_t>(outfile_.tellp());
+}
+
+
+void testfile_write_integral(const std::string & filepath, const integral_data & data)
+{
+    testfile_integral_writer writer(filepath, data, data.entries.size());
+
+    for(const auto & ent : data.entries)
+        writer.write_entry(ent);
 }
 
 
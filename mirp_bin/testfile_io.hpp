@@ -6,12 +6,110 @@
 #pragma once
 
 #include "mirp_bin/data_entry.hpp"
+#include <cstdint>
+#include <fstream>
+#include <memory>
 
 namespace mirp {
 
 // forward declarations
 struct integral_single_data;
 struct integral_data;
+class testfile_binary_reader;
+
+/*! \brief Reads single integral test data from a file one entry at a time
+ *
+ * The header and metadata are read when the reader is created. Entries
+ * are then read in order via \ref read_entry, so that the whole file
+ * does not need to be held in memory.
+ */
+class testfile_integral_single_reader
+{
+public:
+    /*! \brief Opens a file and reads the header and metadata
+     *
+     * \throw std::runtime_error if there is a problem opening or
+     *        reading the file
+     *
+     * \param [in] filepath  Path to the file to read from
+     * \param [in] n         Number of centers in the integral (2 center, 4 center, etc)
+     * \param [in] is_input  True if the file is a test input file, false if it is a data file
+     */
+    testfile_integral_single_reader(const std::string & filepath, int n, bool is_input);
+
+
+    /*! \brief Header and metadata of the file (without any entries) */
+    const integral_single_data & info(void) const { return info_; }
+
+
+    /*! \brief Number of entries the file claims to have */
+    size_t nentry(void) const { return nentry_; }
+
+
+    /*! \brief Reads the next entry
+     *
+     * If the reader was created for an input file, the
+     * integral_single_data_entry::integral member is left empty.
+     *
+     * \throw std::runtime_error if there is a problem reading the entry
+     *
+     * \param [out] ent The entry that was read
+     * \return False if there are no more entries in the file
+     */
+    bool read_entry(integral_single_data_entry & ent);
+
+
+    /*! \brief Checks that all entries have been read
+     *
+     * \throw std::runtime_error if the number of entries read is
+     *        different from the number given in the file
+     */
+    void finish(void) const;
+
+
+private:
+    std::string filepath_;      /*!< Path to the file (for errors) */
+    std::ifstream infile_;      /*!< The file being read */
+    int n_;                     /*!< Number of centers of the integral */
+    bool is_input_;             /*!< Whether this is an input file (without integrals) */
+    integral_single_data info_; /*!< Header and metadata */
+    size_t nentry_;             /*!< Number of entries given in the file */
+    size_t nread_;              /*!< Number of entries read so far */
+
+    std::string error_prefix(void) const;
+};
+
+
+/*! \brief Writes single integral test data to a file one entry at a time
+ *
+ * Any existing file will be overwritten. The header and metadata are written
+ * when the writer is created.
+ */
+class testfile_integral_single_writer
+{
+public:
+    /*! \brief Opens a file and writes the header and metadata
+     *
+     * \throw std::runtime_error if there is a problem opening or
+     *        writing to the file
+     *
+     * \param [in] filepath  Path to the file to write to
+     * \param [in] info      Header and metadata to write (entries are ignored)
+     * \param [in] nentry    Number of entries that will be written
+     */
+    testfile_integral_single_writer(const std::string & filepath,
+                                    const integral_single_data & info,
+                                    size_t nentry);
+
+
+    /*! \brief Writes an entry (including its integral) */
+    void write_entry(const integral_single_data_entry & ent);
+
+
+private:
+    std::ofstream outfile_;  /*!< The file being written */
+};
+
 
 /*! \brief Read generic single integral test data from a file
  *
@@ -47,6 +145,126 @@ void testfile_write_integral_single(const std::string & filepath,
 
 
 
+/*! \brief Reads contracted integral test data from a file one entry at a time
+ *
+ * The header and metadata are read when the reader is created. Entries
+ * are then read in order via \ref read_entry, so that the whole file
+ * does not need to be held in memory.
+ *
+ * Binary test files (see testfile_binary.hpp) are detected automatically.
+ * Their integrals are returned in integral_data_entry::integrals_bin
+ * rather than as strings.
+ */
+class testfile_integral_reader
+{
+public:
+    /*! \brief Opens a file and reads the header and metadata
+     *
+     * \throw std::runtime_error if there is a problem opening or
+     *        reading the file
+     *
+     * \param [in] filepath  Path to the file to read from
+     * \param [in] n         Number of centers in the integral (2 center, 4 center, etc)
+     * \param [in] is_input  True if the file is a test input file, false if it is a data file
+     */
+    testfile_integral_reader(const std::string & filepath, int n, bool is_input);
+
+    ~testfile_integral_reader(void);
+
+
+    /*! \brief Header and metadata of the file (without any entries) */
+    const integral_data & info(void) const { return info_; }
+
+
+    /*! \brief Number of entries the file claims to have */
+    size_t nentry(void) const { return nentry_; }
+
+
+    /*! \brief Number of entries read so far */
+    size_t nread(void) const { return nread_; }
+
+
+    /*! \brief Reads the next entry
+     *
+     * If the reader was created for an input file, the
+     * integral_data_entry::integrals member is left empty.
+     *
+     * \throw std::runtime_error if there is a problem reading the entry
+     *
+     * \param [out] ent The entry that was read
+     * \return False if there are no more entries in the file
+     */
+    bool read_entry(integral_data_entry & ent);
+
+
+    /*! \brief Checks that all entries have been read
+     *
+     * \throw std::runtime_error if the number of entries read is
+     *        different from the number given in the file
+     */
+    void finish(void) const;
+
+
+private:
+    std::string filepath_;   /*!< Path to the file (for errors) */
+    std::ifstream infile_;   /*!< The file being read */
+    int n_;                  /*!< Number of centers of the integral */
+    bool is_input_;          /*!< Whether this is an input file (without integrals) */
+    integral_data info_;     /*!< Header and metadata */
+    size_t nentry_;          /*!< Number of entries given in the file */
+    size_t nread_;           /*!< Number of entries read so far */
+
+    std::unique_ptr<testfile_binary_reader> binfile_; /*!< Reader for binary files */
+
+    std::string error_prefix(void) const;
+};
+
+
+/*! \brief Writes contracted integral test data to a file one entry at a time
+ *
+ * Any existing file will be overwritten. The header and metadata are written
+ * when the writer is created. A partially written file may instead be continued
+ * (when resuming from a checkpoint).
+ */
+class testfile_integral_writer
+{
+public:
+    /*! \brief Opens a file and writes the header and metadata
+     *
+     * \throw std::runtime_error if there is a problem opening or
+     *        writing to the file
+     *
+     * \param [in] filepath  Path to the file to write to
+     * \param [in] info      Header and metadata to write (entries are ignored)
+     * \param [in] nentry    Number of entries that will be written
+     */
+    testfile_integral_writer(const std::string & filepath,
+                             const integral_data & info,
+                             size_t nentry);
+
+
+    /*! \brief Opens a partially written file to continue writing at its end
+     *
+     * \throw std::runtime_error if there is a problem opening the file
+     *
+     * \param [in] filepath  Path to the file to continue
+     */
+    explicit testfile_integral_writer(const std::string & filepath);
+
+
+    /*! \brief Writes an entry (including its integrals) */
+    void write_entry(const integral_data_entry & ent);
+
+
+    /*! \brief Writes any buffered data, and returns the size of the file so far */
+    uint64_t offset(void);
+
+
+private:
+    std::ofstream outfile_;  /*!< The file being written */
+};
+
+
 /*! \brief Read generic contracted integral test data from a file
  *
  * If \p is_input is set to true, then the returned data
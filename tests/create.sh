@@ -95,3 +95,12 @@ generator/generate_integral_frombasis.py \
            --basis generator/basis/sto-3g.bas \
            --geometry generator/geometry/water.xyz \
            --outfile gtoeri_water_sto-3g.ref
+
+../build/mirp_bin/mirp_convert_reference \
+           --infile gtoeri_water_sto-3g.ref \
+           --outfile gtoeri_water_sto-3g.refb
+
+../build/mirp_bin/mirp_convert_reference \
+           --infile gtoeri_water_sto-3g.ref \
+           --outfile gtoeri_water_sto-3g_compressed.refb \
+           --format compressed